@@ -5,6 +5,10 @@
 #include <string.h>
 #include <math.h>
 
+#include "simd_kernels.h"
+#include "matrix_file.h"
+#include "invmat.h"
+
 // Medir o tempo em segundos
 double get_time() {
     struct timeval tv;
@@ -12,303 +16,256 @@ double get_time() {
     return tv.tv_sec + tv.tv_usec * 1e-6;
 }
 
-// Gerar uma matriz aleatória n x n que seja inversível
-void generate_invertible_matrix(double *matrix, int n) {
-    // Primeiro cria uma matriz diagonal com valores não nulos na diagonal
+// Função para imprimir matriz (apenas para depuração)
+void print_matrix(double *matrix, int n, const char *label) {
+    printf("%s:\n", label);
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < n; j++) {
-            if (i == j) {
-                matrix[i*n + j] = (double)(rand() % 100) + 1.0; // Valores de 1 a 100 na diagonal
-            } else {
-                matrix[i*n + j] = 0.0;
-            }
-        }
-    }
-    
-    // Aplica permutações aleatórias para manter a matriz inversível mas não trivial
-    for (int k = 0; k < n*2; k++) {
-        int row1 = rand() % n;
-        int row2 = rand() % n;
-        
-        if (row1 != row2) {
-            // Soma a linha row1 com a linha row2 multiplicada por um fator aleatório
-            double factor = (double)(rand() % 10) + 0.1;
-            for (int j = 0; j < n; j++) {
-                matrix[row1*n + j] += factor * matrix[row2*n + j];
-            }
+            printf("%10.4f ", matrix[i*n + j]);
         }
+        printf("\n");
     }
+    printf("\n");
 }
 
-// Salva a matriz em um arquivo .bin
-void save_matrix_to_file(double *matrix, int n, const char *filename) {
-    FILE *file = fopen(filename, "wb");
-    if (file == NULL) {
-        fprintf(stderr, "Erro ao abrir o arquivo %s para escrita\n", filename);
-        exit(EXIT_FAILURE);
-    }
-    
-    fwrite(matrix, sizeof(double), n*n, file);
-    fclose(file);
-}
+// Contextos da libinvmat (Comum/invmat.h) das orientações 1 e 2, criados
+// no primeiro uso: a área de trabalho (temp_A e o produto da validação) fica
+// reservada até o fim do programa, inclusive para os fallbacks
+invmat_context_t *serial_contexts[INVMAT_BACKEND_OPENCL + 1];
 
-// Ler a matriz em um arquivo .bin salva anteriormente
-void load_matrix_from_file(double *matrix, int n, const char *filename) {
-    FILE *file = fopen(filename, "rb");
-    if (file == NULL) {
-        fprintf(stderr, "Erro ao abrir o arquivo %s para leitura\n", filename);
+// Termina o programa com a mensagem de um erro da biblioteca
+void invmat_check(invmat_status_t status) {
+    if (status != INVMAT_OK) {
+        fprintf(stderr, "Erro: %s\n", invmat_error_message());
         exit(EXIT_FAILURE);
     }
-    
-    size_t read_elements = fread(matrix, sizeof(double), n*n, file);
-    if (read_elements != n*n) {
-        fprintf(stderr, "Erro ao ler dados do arquivo %s\n", filename);
-        exit(EXIT_FAILURE);
-    }
-    
-    fclose(file);
 }
 
-// Função para imprimir matriz (apenas para depuração)
-void print_matrix(double *matrix, int n, const char *label) {
-    printf("%s:\n", label);
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            printf("%10.4f ", matrix[i*n + j]);
-        }
-        printf("\n");
+invmat_context_t *serial_context(invmat_backend_t backend) {
+    if (serial_contexts[backend] == NULL) {
+        invmat_check(invmat_context_create(backend, 1, &serial_contexts[backend]));
     }
-    printf("\n");
+    return serial_contexts[backend];
 }
 
 // Função para calcular a inversa da matriz usando o método de Gauss-Jordan
-// Orientação a linhas
+// Orientação a linhas (backend "linhas" da libinvmat; matrizes pequenas usam
+// os kernels de tamanho fixo)
 void calculate_inverse_row_oriented(double *A, double *Ainv, int n) {
-    // Cria uma cópia da matriz A para não modificá-la
-    double *temp_A = (double*)malloc(n*n*sizeof(double));
-    memcpy(temp_A, A, n*n*sizeof(double));
-    
-    // Inicializa Ainv como matriz identidade
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            Ainv[i*n + j] = (i == j) ? 1.0 : 0.0;
-        }
-    }
-    
-    // Algoritmo de Gauss-Jordan
-    for (int k = 0; k < n; k++) {
-        // Encontra o pivô (valor máximo na coluna k)
-        int pivot_row = k;
-        double pivot_value = fabs(temp_A[k*n + k]);
-        
-        for (int i = k + 1; i < n; i++) {
-            double abs_value = fabs(temp_A[i*n + k]);
-            if (abs_value > pivot_value) {
-                pivot_value = abs_value;
-                pivot_row = i;
-            }
-        }
-        
-        // Se o pivô for muito pequeno, a matriz pode ser singular
-        if (pivot_value < 1e-10) {
-            fprintf(stderr, "Erro: A matriz parece ser singular ou mal condicionada\n");
-            free(temp_A);
-            exit(EXIT_FAILURE);
-        }
-        
-        // Troca as linhas se necessário
-        if (pivot_row != k) {
-            for (int j = 0; j < n; j++) {
-                double temp = temp_A[k*n + j];
-                temp_A[k*n + j] = temp_A[pivot_row*n + j];
-                temp_A[pivot_row*n + j] = temp;
-                
-                temp = Ainv[k*n + j];
-                Ainv[k*n + j] = Ainv[pivot_row*n + j];
-                Ainv[pivot_row*n + j] = temp;
-            }
-        }
-        
-        // Normaliza a linha do pivô
-        double pivot = temp_A[k*n + k];
-        for (int j = 0; j < n; j++) {
-            temp_A[k*n + j] /= pivot;
-            Ainv[k*n + j] /= pivot;
-        }
-        
-        // Eliminação de Gauss
-        for (int i = 0; i < n; i++) {
-            if (i != k) {
-                double factor = temp_A[i*n + k];
-                for (int j = 0; j < n; j++) {
-                    temp_A[i*n + j] -= factor * temp_A[k*n + j];
-                    Ainv[i*n + j] -= factor * Ainv[k*n + j];
-                }
-            }
-        }
-    }
-    
-    free(temp_A);
+    invmat_check(invmat_invert_buffer(serial_context(INVMAT_BACKEND_SERIAL_ROW), A, Ainv, n));
 }
 
 // Função para calcular a inversa da matriz usando o método de Gauss-Jordan
-// Orientação a colunas
+// Orientação a colunas (backend "colunas" da libinvmat)
 void calculate_inverse_column_oriented(double *A, double *Ainv, int n) {
-    // Cria uma cópia da matriz A para não modificá-la
-    double *temp_A = (double*)malloc(n*n*sizeof(double));
-    memcpy(temp_A, A, n*n*sizeof(double));
-    
-    // Inicializa Ainv como matriz identidade
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            Ainv[i*n + j] = (i == j) ? 1.0 : 0.0;
-        }
-    }
-    
-    // Algoritmo de Gauss-Jordan (orientado a colunas)
-    for (int k = 0; k < n; k++) {
-        // Encontra o pivô (valor máximo na coluna k)
-        int pivot_row = k;
-        double pivot_value = fabs(temp_A[k*n + k]);
-        
-        for (int i = k + 1; i < n; i++) {
-            double abs_value = fabs(temp_A[i*n + k]);
-            if (abs_value > pivot_value) {
-                pivot_value = abs_value;
-                pivot_row = i;
-            }
-        }
-        
-        // Se o pivô for muito pequeno, a matriz pode ser singular
-        if (pivot_value < 1e-10) {
-            fprintf(stderr, "Erro: A matriz parece ser singular ou mal condicionada\n");
-            free(temp_A);
-            exit(EXIT_FAILURE);
-        }
-        
-        // Troca as linhas se necessário
-        if (pivot_row != k) {
-            for (int j = 0; j < n; j++) {
-                double temp = temp_A[k*n + j];
-                temp_A[k*n + j] = temp_A[pivot_row*n + j];
-                temp_A[pivot_row*n + j] = temp;
-                
-                temp = Ainv[k*n + j];
-                Ainv[k*n + j] = Ainv[pivot_row*n + j];
-                Ainv[pivot_row*n + j] = temp;
-            }
-        }
-        
-        // Normaliza a linha do pivô
-        double pivot = temp_A[k*n + k];
-        for (int j = 0; j < n; j++) {
-            temp_A[k*n + j] /= pivot;
-            Ainv[k*n + j] /= pivot;
-        }
-        
-        // Loop externo sobre colunas (diferente da orientação a linhas)
-        for (int j = 0; j < n; j++) {
-            if (j != k) {
-                for (int i = 0; i < n; i++) {
-                    if (i != k) {
-                        temp_A[i*n + j] -= temp_A[i*n + k] * temp_A[k*n + j];
-                        Ainv[i*n + j] -= Ainv[i*n + k] * temp_A[k*n + j];
-                    }
-                }
-            }
-        }
-    }
-    
-    free(temp_A);
+    invmat_check(invmat_invert_buffer(serial_context(INVMAT_BACKEND_SERIAL_COL), A, Ainv, n));
 }
 
-// Valida a inversa calculada (A * A^-1 deve ser aproximadamente I)
+// Tamanho padrão do painel (número de colunas fatoradas por bloco)
+#define DEFAULT_BLOCK_SIZE 64
+
+// Função para calcular a inversa da matriz usando o método de Gauss-Jordan
+// Versão blocada (tiled), invmat_invert_blocked: fatora um painel de b
+// colunas e aplica a transformação acumulada ao restante de [temp_A | Ainv]
+// como um produto matriz-matriz, em vez de uma atualização de posto 1 por pivô
+void calculate_inverse_blocked(double *A, double *Ainv, int n, int b) {
+    invmat_check(invmat_invert_blocked(serial_context(INVMAT_BACKEND_SERIAL_ROW), A, Ainv, n, b));
+}
+
+// Função para calcular a inversa da matriz via fatoração LU com pivotamento
+// parcial (invmat_invert_lu): P*A = L*U, inversão de U, resolução de
+// inv(A)*L = inv(U) e desfaz a permutação nas colunas. Custa ~2n^3 flops,
+// contra ~4n^3 do Gauss-Jordan sobre o par [temp_A | Ainv]
+void calculate_inverse_lu(double *A, double *Ainv, int n) {
+    invmat_check(invmat_invert_lu(serial_context(INVMAT_BACKEND_SERIAL_ROW), A, Ainv, n));
+}
+
+// Função para calcular a inversa no próprio buffer de entrada (Gauss-Jordan
+// com substituição de colunas, invmat_invert_in_place): usa n^2 doubles mais
+// o vetor de pivôs e metade das operações do laço aumentado
+void calculate_inverse_in_place(double *A, int n) {
+    invmat_check(invmat_invert_in_place(serial_context(INVMAT_BACKEND_SERIAL_ROW), A, n));
+}
+
+// Resultado do último refinamento (relatado em main)
+invmat_refine_info_t mixed_info;
+
+// Função para calcular a inversa em precisão mista (invmat_invert_mixed):
+// Gauss-Jordan in-place em float e refinamento em double por Newton-Schulz,
+// X <- X + X*(I - A*X), que dobra o número de dígitos corretos a cada
+// iteração. Se o resíduo não cair abaixo da tolerância de validate_inverse,
+// recalcula tudo em double pela orientação a linhas
+void calculate_inverse_mixed(double *A, double *Ainv, int n) {
+    invmat_check(invmat_invert_mixed(serial_context(INVMAT_BACKEND_SERIAL_ROW), A, Ainv, n, &mixed_info));
+}
+
+// Valida a inversa calculada (A * A^-1 deve ser aproximadamente I), com o
+// produto na área de trabalho do contexto da orientação a linhas
 int validate_inverse(double *A, double *Ainv, int n) {
-    double *result = (double*)malloc(n*n*sizeof(double));
-    double epsilon = 1e-6;
-    
-    // Calcula A * A^-1
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            result[i*n + j] = 0.0;
-            for (int k = 0; k < n; k++) {
-                result[i*n + j] += A[i*n + k] * Ainv[k*n + j];
-            }
-        }
+    int valid;
+    invmat_check(invmat_validate_exact(serial_context(INVMAT_BACKEND_SERIAL_ROW), A, Ainv, n, &valid));
+    return valid;
+}
+
+// Valida a inversa uma linha de A * A^-1 por vez, sem o buffer n^2 do
+// resultado, para o modo in-place (A é lida em ordem do mapeamento do
+// arquivo de entrada)
+int validate_inverse_by_rows(const double *A, double *Ainv, int n) {
+    int valid;
+    invmat_check(invmat_validate_by_rows(serial_context(INVMAT_BACKEND_SERIAL_ROW), A, Ainv, n, &valid));
+    return valid;
+}
+
+// Número padrão de vetores aleatórios da validação probabilística
+#define VALIDATION_PROBES 3
+
+// Função para validar a inversa sem formar A * A^-1 (teste de Freivalds,
+// invmat_validate_freivalds): O(n^2) e sem buffer n^2, com probabilidade
+// <= 2^-probes de aceitar uma inversa errada. Retorna o maior ||r||_inf
+double validate_inverse_freivalds(const double *A, const double *Ainv, int n, int probes) {
+    double residual;
+    invmat_check(invmat_validate_freivalds(serial_context(INVMAT_BACKEND_SERIAL_ROW), A, Ainv, n, probes,
+                                           (unsigned int)time(NULL), &residual));
+    return residual;
+}
+
+// Maior diferença relativa aceita entre a inversa de uma orientação e a da
+// orientação 1 (as ordens de operação diferem só no arredondamento, ampliado
+// pelo condicionamento de A)
+#define REFERENCE_TOLERANCE 1e-6
+
+// Compara Ainv com a inversa da orientação 1, calculada em um buffer à parte.
+// Retorna max |Ainv - Ref| / max |Ref|
+double compare_with_row_oriented(double *A, const double *Ainv, int n) {
+    double *reference = (double *)malloc((size_t)n * n * sizeof(double));
+    if (reference == NULL) {
+        fprintf(stderr, "Erro: falha na alocação da inversa de referência\n");
+        exit(EXIT_FAILURE);
     }
-    
-    // Verifica se o resultado é aproximadamente a matriz identidade
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            double expected = (i == j) ? 1.0 : 0.0;
-            if (fabs(result[i*n + j] - expected) > epsilon) {
-                free(result);
-                return 0; // Falha na validação
+    calculate_inverse_row_oriented(A, reference, n);
+
+    double max_diff = 0.0, max_ref = 0.0;
+    for (size_t i = 0; i < (size_t)n * n; i++) {
+        double diff = fabs(Ainv[i] - reference[i]);
+        if (diff > max_diff) max_diff = diff;
+        if (fabs(reference[i]) > max_ref) max_ref = fabs(reference[i]);
+    }
+    free(reference);
+    return max_ref > 0.0 ? max_diff / max_ref : max_diff;
+}
+
+// Retira de argv as opções da validação, aceitas em qualquer posição:
+//   --exato        confere A * A^-1 = I entrada a entrada (O(n^3))
+//   --sondas=K     número de vetores do teste de Freivalds (padrão VALIDATION_PROBES)
+//   --referencia   compara a inversa com a da orientação 1
+void parse_validation_options(int *argc, char *argv[], int *exact, int *probes, int *reference) {
+    int kept = 1;
+    for (int a = 1; a < *argc; a++) {
+        if (strcmp(argv[a], "--exato") == 0) {
+            *exact = 1;
+        } else if (strcmp(argv[a], "--referencia") == 0) {
+            *reference = 1;
+        } else if (strncmp(argv[a], "--sondas=", 9) == 0) {
+            *probes = atoi(argv[a] + 9);
+            if (*probes <= 0) {
+                fprintf(stderr, "Erro: O número de sondas deve ser positivo\n");
+                exit(EXIT_FAILURE);
             }
+        } else {
+            argv[kept++] = argv[a];
         }
     }
-    
-    free(result);
-    return 1; // Validação bem-sucedida
+    *argc = kept;
+    argv[kept] = NULL;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Uso: %s <tamanho_da_matriz> <orientacao>\n", argv[0]);
-        fprintf(stderr, "orientacao: 1 para orientado a linhas, 2 para orientado a colunas\n");
+    // Opções da validação (as demais são posicionais)
+    int exact_validation = 0;
+    int probes = VALIDATION_PROBES;
+    int reference_check = 0;
+    parse_validation_options(&argc, argv, &exact_validation, &probes, &reference_check);
+    
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "Uso: %s <tamanho_da_matriz> <orientacao> [tamanho_bloco] [--exato] [--sondas=K] [--referencia]\n", argv[0]);
+        fprintf(stderr, "orientacao: 1 para orientado a linhas, 2 para orientado a colunas, 3 para blocado, 4 para LU, 5 para in-place, 6 para precisão mista\n");
+        fprintf(stderr, "validação: teste de Freivalds com K vetores aleatórios (padrão %d); --exato confere A * A^-1 = I inteira; --referencia compara com a orientação 1\n", VALIDATION_PROBES);
         return EXIT_FAILURE;
     }
     
     // Obtem o tamanho da matriz e orientação dos argumentos da linha de comando
     int n = atoi(argv[1]);
     int orientation = atoi(argv[2]);
+    int block_size = (argc == 4) ? atoi(argv[3]) : DEFAULT_BLOCK_SIZE;
     
     if (n <= 0) {
         fprintf(stderr, "Erro: O tamanho da matriz deve ser positivo\n");
         return EXIT_FAILURE;
     }
     
-    if (orientation != 1 && orientation != 2) {
-        fprintf(stderr, "Erro: Orientação deve ser 1 (linhas) ou 2 (colunas)\n");
+    if (orientation < 1 || orientation > 6) {
+        fprintf(stderr, "Erro: Orientação deve ser 1 (linhas), 2 (colunas), 3 (blocado), 4 (LU), 5 (in-place) ou 6 (precisão mista)\n");
         return EXIT_FAILURE;
     }
     
-    // Aloca memória para as matrizes
-    double *A = (double*)malloc(n*n*sizeof(double));
-    double *Ainv = (double*)malloc(n*n*sizeof(double));
-    
-    if (A == NULL || Ainv == NULL) {
-        fprintf(stderr, "Erro: Falha na alocação de memória\n");
-        free(A);
-        free(Ainv);
+    if (block_size <= 0) {
+        fprintf(stderr, "Erro: O tamanho do bloco deve ser positivo\n");
         return EXIT_FAILURE;
     }
     
+    // Sufixo usado nos arquivos de saída de cada orientação
+    const char *suffixes[] = { "row", "col", "blk", "lu", "inp", "mix" };
+    const char *suffix = suffixes[orientation - 1];
+    
+    // No modo in-place a inversa sobrescreve a cópia de A no arquivo de saída
+    int in_place = (orientation == 5);
+    
     // Define o nome dos arquivos de entrada e saída
     char input_filename[100], output_filename[100];
     sprintf(input_filename, "matrix_%d.bin", n);
-    sprintf(output_filename, "inverse_matrix_%d_%s.bin", n, orientation == 1 ? "row" : "col");
+    sprintf(output_filename, "inverse_matrix_%d_%s.bin", n, suffix);
+    
+    // Entrada e saída são mapeadas em memória (formato de Comum/matrix_file.h)
+    matrix_map_t in_map, out_map;
     
     // Verifica se o arquivo de entrada existe, se não, gera e salva uma matriz
     FILE *test_file = fopen(input_filename, "rb");
     if (test_file == NULL) {
         printf("Arquivo de matriz de entrada não encontrado. Gerando nova matriz %dx%d...\n", n, n);
         
-        // Configura a semente para números aleatórios
-        srand(time(NULL));
-        
-        // Gera uma matriz inversível aleatória
-        generate_invertible_matrix(A, n);
-        
-        // Salva a matriz no arquivo
-        save_matrix_to_file(A, n, input_filename);
+        // Gera uma matriz inversível aleatória diretamente no arquivo
+        double *M = matrix_file_create(input_filename, n, MATRIX_ROW_MAJOR, &in_map);
+        invmat_generate(M, n, (unsigned int)time(NULL));
+        matrix_file_close(&in_map);
         printf("Matriz salva em %s\n", input_filename);
     } else {
         fclose(test_file);
         printf("Carregando matriz %dx%d do arquivo %s\n", n, n, input_filename);
-        load_matrix_from_file(A, n, input_filename);
     }
     
+    double map_start = get_time();
+    double *A = matrix_file_open(input_filename, n, &in_map);
+    double map_time = get_time() - map_start;
+    
+    if (in_map.n != n) {
+        fprintf(stderr, "Erro: %s contém uma matriz %dx%d\n", input_filename, in_map.n, in_map.n);
+        matrix_file_close(&in_map);
+        return EXIT_FAILURE;
+    }
+    printf("Formato do arquivo: %s (mapeado e verificado em %.3f s)\n",
+           matrix_file_format_name(&in_map), map_time);
+    
+    // A inversa é escrita diretamente no arquivo de saída mapeado, na mesma
+    // ordem da entrada (uma matriz por colunas é A^T, e inv(A^T) = inv(A)^T)
+    double *Ainv = matrix_file_create(output_filename, n, in_map.layout, &out_map);
+    if (in_place) {
+        memcpy(Ainv, A, n*n*sizeof(double));
+    }
+    
+    // Seleciona os kernels SIMD de acordo com a CPU (ou IM_ISA)
+    simd_init();
+    printf("Kernels SIMD: %s\n", simd_isa_name());
+    
     // Mede o tempo de execução
     double start_time = get_time();
     
@@ -316,28 +273,68 @@ int main(int argc, char *argv[]) {
     if (orientation == 1) {
         printf("Calculando inversa (orientação a linhas)...\n");
         calculate_inverse_row_oriented(A, Ainv, n);
-    } else {
+    } else if (orientation == 2) {
         printf("Calculando inversa (orientação a colunas)...\n");
         calculate_inverse_column_oriented(A, Ainv, n);
+    } else if (orientation == 3) {
+        printf("Calculando inversa (blocada, painel de %d colunas)...\n", block_size);
+        calculate_inverse_blocked(A, Ainv, n, block_size);
+    } else if (orientation == 4) {
+        printf("Calculando inversa (fatoração LU)...\n");
+        calculate_inverse_lu(A, Ainv, n);
+    } else if (orientation == 5) {
+        printf("Calculando inversa (in-place, substituição de colunas)...\n");
+        calculate_inverse_in_place(Ainv, n);
+    } else {
+        printf("Calculando inversa (precisão mista float/double)...\n");
+        calculate_inverse_mixed(A, Ainv, n);
     }
     
     double end_time = get_time();
     double execution_time = end_time - start_time;
     
-    // Valida a matriz inversa calculada
-    if (validate_inverse(A, Ainv, n)) {
-        printf("Validação da matriz inversa: SUCESSO\n");
+    // Desempenho em GFLOP/s, usando a mesma contagem nominal (4n^3, a do
+    // Gauss-Jordan sobre [temp_A | Ainv]) para todas as orientações
+    double gflops = 4.0 * n * n * (double)n / (execution_time * 1e9);
+    
+    // Valida a matriz inversa calculada: por padrão com o teste de Freivalds
+    // (O(n^2)); com --exato, forma A * A^-1 (no modo in-place, sem buffer n^2)
+    double validation_start = get_time();
+    if (exact_validation) {
+        int valid = in_place ? validate_inverse_by_rows(A, Ainv, n)
+                             : validate_inverse(A, Ainv, n);
+        if (valid) {
+            printf("Validação da matriz inversa (exata): SUCESSO");
+        } else {
+            printf("Validação da matriz inversa (exata): FALHA");
+        }
     } else {
-        printf("Validação da matriz inversa: FALHA\n");
+        double residual = validate_inverse_freivalds(A, Ainv, n, probes);
+        if (residual < 1e-6) {
+            printf("Validação da matriz inversa (Freivalds, %d sondas): SUCESSO, resíduo ||A*(A^-1*x) - x||_inf = %.3e", probes, residual);
+        } else {
+            printf("Validação da matriz inversa (Freivalds, %d sondas): FALHA, resíduo ||A*(A^-1*x) - x||_inf = %.3e", probes, residual);
+        }
+    }
+    printf(" (%.3f s)\n", get_time() - validation_start);
+    
+    // Com --referencia, confere o resultado com a orientação 1 (a inversa de
+    // referência é calculada da matriz de entrada, que o modo in-place não altera)
+    if (reference_check && orientation != 1) {
+        double diff = compare_with_row_oriented(A, Ainv, n);
+        printf("Comparação com a orientação 1: %s, maior diferença relativa %.3e\n",
+               diff < REFERENCE_TOLERANCE ? "SUCESSO" : "FALHA", diff);
     }
     
-    // Salva a matriz inversa em um arquivo
-    save_matrix_to_file(Ainv, n, output_filename);
-    printf("Matriz inversa salva em %s\n", output_filename);
+    // Fecha a saída (grava o checksum); as páginas já estão no arquivo
+    double store_start = get_time();
+    matrix_file_close(&out_map);
+    matrix_file_close(&in_map);
+    printf("Matriz inversa salva em %s (%.3f s)\n", output_filename, get_time() - store_start);
     
     // Grava os resultados em um arquivo CSV para análise de escalabilidade
     char results_filename[100];
-    sprintf(results_filename, "results_%s.csv", orientation == 1 ? "row" : "col");
+    sprintf(results_filename, "results_%s.csv", suffix);
     
     FILE *results_file = fopen(results_filename, "a");
     if (results_file == NULL) {
@@ -358,10 +355,20 @@ int main(int argc, char *argv[]) {
     
     printf("Tamanho da matriz: %d x %d\n", n, n);
     printf("Tempo de execução: %.6f segundos\n", execution_time);
+    printf("Desempenho: %.3f GFLOP/s\n", gflops);
+    if (orientation == 6) {
+        if (mixed_info.fallback) {
+            printf("Inversa recalculada em double após %d iterações de refinamento: %s\n", mixed_info.iterations,
+                   invmat_fallback_reason(mixed_info.reason));
+        } else {
+            printf("Iterações de refinamento (Newton-Schulz): %d\n", mixed_info.iterations);
+        }
+        printf("Estimativa de condicionamento pelos pivôs em float (max|A| / min|pivô|): %.3e\n", mixed_info.condition_estimate);
+        printf("Resíduo final ||A*Ainv - I||_inf: %.3e\n", mixed_info.residual);
+    }
     
-    // Libera a memória
-    free(A);
-    free(Ainv);
-    
+    for (int b = 0; b <= INVMAT_BACKEND_OPENCL; b++) {
+        invmat_context_destroy(serial_contexts[b]);
+    }
     return EXIT_SUCCESS;
 }
\ No newline at end of file
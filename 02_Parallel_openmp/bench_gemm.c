@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>  // Inclusão da biblioteca OpenMP
+
+#include "simd_kernels.h"
+#include "gemm.h"
+
+/*
+ * bench_gemm.c - Compara o produto de matrizes de Comum/gemm.c com o laço
+ * i-j-k usado até então em validate_inverse (leituras de B com passo n), para
+ * os tamanhos da lista (padrão: 500, 1000, 2000, 3000 e 4000)
+ */
+
+// Função para medir o tempo de execução
+double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Produto C = A * B com o laço de validate_inverse (paralelizado por linhas)
+void matmul_naive(const double *A, const double *B, double *C, int n) {
+    #pragma omp parallel for
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            C[(size_t)i*n + j] = 0.0;
+            for (int k = 0; k < n; k++) {
+                C[(size_t)i*n + j] += A[(size_t)i*n + k] * B[(size_t)k*n + j];
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <num_threads> [tamanho_da_matriz ...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int num_threads = atoi(argv[1]);
+    if (num_threads <= 0) {
+        fprintf(stderr, "Erro: O número de threads deve ser positivo\n");
+        return EXIT_FAILURE;
+    }
+
+    int default_sizes[] = { 500, 1000, 2000, 3000, 4000 };
+    int num_sizes = (argc > 2) ? argc - 2 : (int)(sizeof(default_sizes) / sizeof(default_sizes[0]));
+
+    omp_set_num_threads(num_threads);
+
+    // Seleciona os kernels SIMD de acordo com a CPU (ou IM_ISA)
+    simd_init();
+    printf("Kernels SIMD: %s, micro-kernel do GEMM: %s, %d threads\n",
+           simd_isa_name(), gemm_kernel_name(), num_threads);
+
+    srand(time(NULL));
+
+    for (int s = 0; s < num_sizes; s++) {
+        int n = (argc > 2) ? atoi(argv[s + 2]) : default_sizes[s];
+        if (n <= 0) {
+            fprintf(stderr, "Erro: O tamanho da matriz deve ser positivo\n");
+            return EXIT_FAILURE;
+        }
+
+        size_t elems = (size_t)n*n;
+        double *A = (double*)malloc(elems*sizeof(double));
+        double *B = (double*)malloc(elems*sizeof(double));
+        double *C_naive = (double*)malloc(elems*sizeof(double));
+        double *C_gemm = (double*)malloc(elems*sizeof(double));
+        if (A == NULL || B == NULL || C_naive == NULL || C_gemm == NULL) {
+            fprintf(stderr, "Erro: Falha na alocação de memória\n");
+            return EXIT_FAILURE;
+        }
+
+        for (size_t i = 0; i < elems; i++) {
+            A[i] = 2.0 * rand() / RAND_MAX - 1.0;
+            B[i] = 2.0 * rand() / RAND_MAX - 1.0;
+        }
+
+        double flops = 2.0 * n * n * (double)n;
+
+        double start_time = get_time();
+        matmul_naive(A, B, C_naive, n);
+        double naive_time = get_time() - start_time;
+
+        // Primeira chamada fora da medição (páginas de C e buffers de empacotamento)
+        gemm(n, n, n, 1.0, A, n, B, n, 0.0, C_gemm, n);
+        start_time = get_time();
+        gemm(n, n, n, 1.0, A, n, B, n, 0.0, C_gemm, n);
+        double gemm_time = get_time() - start_time;
+
+        // Diferença relativa entre os dois produtos (ordem de soma diferente)
+        double max_diff = 0.0, max_value = 0.0;
+        for (size_t i = 0; i < elems; i++) {
+            double diff = fabs(C_gemm[i] - C_naive[i]);
+            if (diff > max_diff) {
+                max_diff = diff;
+            }
+            if (fabs(C_naive[i]) > max_value) {
+                max_value = fabs(C_naive[i]);
+            }
+        }
+
+        printf("n = %5d: laço i-j-k %8.3f s (%7.2f GFLOP/s) | gemm %8.3f s (%7.2f GFLOP/s) | %.1fx | dif. relativa %.1e\n",
+               n, naive_time, flops / (naive_time * 1e9), gemm_time, flops / (gemm_time * 1e9),
+               naive_time / gemm_time, max_diff / max_value);
+
+        // Grava os resultados em um arquivo CSV
+        FILE *results_file = fopen("results_gemm.csv", "a");
+        if (results_file == NULL) {
+            fprintf(stderr, "Erro ao abrir o arquivo de resultados results_gemm.csv\n");
+        } else {
+            // Verifica se o arquivo está vazio para adicionar o cabeçalho
+            fseek(results_file, 0, SEEK_END);
+            long size = ftell(results_file);
+
+            if (size == 0) {
+                fprintf(results_file, "tamanho_matriz,num_threads,micro_kernel,tempo_laco,gflops_laco,tempo_gemm,gflops_gemm\n");
+            }
+
+            // Adiciona os resultados
+            fprintf(results_file, "%d,%d,%s,%.6f,%.3f,%.6f,%.3f\n", n, num_threads, gemm_kernel_name(),
+                    naive_time, flops / (naive_time * 1e9), gemm_time, flops / (gemm_time * 1e9));
+            fclose(results_file);
+        }
+
+        free(A);
+        free(B);
+        free(C_naive);
+        free(C_gemm);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>  // Inclusão da biblioteca OpenMP
+
+#include "invmat.h"
+
+// Maior diferença relativa aceita entre a inversa do lote e a do laço serial
+// (as ordens de operação diferem só no arredondamento, ampliado pelo
+// condicionamento de cada matriz)
+#define COMPARE_TOLERANCE 1e-6
+
+// Quantas matrizes divergentes são listadas
+#define COMPARE_REPORT_LIMIT 10
+
+// Função para medir o tempo em segundos
+double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Termina o programa com a mensagem de um erro da biblioteca
+void invmat_check(invmat_status_t status) {
+    if (status != INVMAT_OK) {
+        fprintf(stderr, "Erro: %s\n", invmat_error_message());
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Função para calcular a inversa da matriz usando o método de Gauss-Jordan
+// Orientação a linhas (invmat_gauss_jordan_serial, mesma rotina da versão
+// serial, usada como referência), com temp_A alocada a cada chamada
+void calculate_inverse_row_oriented(double *A, double *Ainv, int n) {
+    double *temp_A = (double*)malloc(n*n*sizeof(double));
+    if (temp_A == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+    invmat_status_t status = invmat_gauss_jordan_serial(A, Ainv, temp_A, n);
+    free(temp_A);
+    invmat_check(status);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4) {
+        fprintf(stderr, "Uso: %s <tamanho_da_matriz> <tamanho_lote> <num_threads>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Obtem o tamanho das matrizes, do lote e o número de threads
+    int n = atoi(argv[1]);
+    int batch = atoi(argv[2]);
+    int num_threads = atoi(argv[3]);
+
+    if (n <= 0 || batch <= 0) {
+        fprintf(stderr, "Erro: O tamanho da matriz e do lote devem ser positivos\n");
+        return EXIT_FAILURE;
+    }
+
+    if (num_threads <= 0) {
+        fprintf(stderr, "Erro: O número de threads deve ser positivo\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t elements = (size_t)n*n*batch;
+
+    // Lote intercalado (entrada e saída) e o mesmo lote matriz a matriz,
+    // usado pelo laço de referência sobre calculate_inverse_row_oriented
+    double *A = (double*)malloc(elements*sizeof(double));
+    double *Ainv = (double*)malloc(elements*sizeof(double));
+    double *A_seq = (double*)malloc(elements*sizeof(double));
+    double *Ainv_seq = (double*)malloc(elements*sizeof(double));
+    int *status = (int*)malloc(batch*sizeof(int));
+
+    if (A == NULL || Ainv == NULL || A_seq == NULL || Ainv_seq == NULL || status == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Gerando lote de %d matrizes %dx%d...\n", batch, n, n);
+    unsigned int seed = (unsigned int)time(NULL);
+    for (int b = 0; b < batch; b++) {
+        double *M = A_seq + (size_t)b*n*n;
+        invmat_generate(M, n, seed + b);
+        for (int e = 0; e < n*n; e++) {
+            A[(size_t)e*batch + b] = M[e];
+        }
+    }
+
+    // Contextos da libinvmat: o lote usa num_threads threads e a validação é
+    // serial. A criação seleciona os kernels SIMD de acordo com a CPU (ou IM_ISA)
+    invmat_context_t *batch_context, *serial_context;
+    invmat_check(invmat_context_create(INVMAT_BACKEND_OPENMP, num_threads, &batch_context));
+    invmat_check(invmat_context_create(INVMAT_BACKEND_SERIAL_ROW, 1, &serial_context));
+    if (invmat_error_message()[0] != '\0') {
+        fprintf(stderr, "%s\n", invmat_error_message());
+    }
+    printf("Kernels SIMD: %s\n", invmat_context_device(serial_context));
+
+    // Referência: uma chamada de calculate_inverse_row_oriented por matriz
+    printf("Calculando inversas (laço sobre a versão serial)...\n");
+    double start_time = get_time();
+    for (int b = 0; b < batch; b++) {
+        calculate_inverse_row_oriented(A_seq + (size_t)b*n*n, Ainv_seq + (size_t)b*n*n, n);
+    }
+    double loop_time = get_time() - start_time;
+
+    // Lote intercalado, paralelo entre grupos de matrizes
+    printf("Calculando inversas (lote intercalado, %d threads)...\n", num_threads);
+    start_time = get_time();
+    int failures;
+    invmat_check(invmat_invert_batch(batch_context, A, Ainv, status, n, batch, &failures));
+    double batch_time = get_time() - start_time;
+
+    // Valida cada inversa do lote e a compara, elemento a elemento, com a
+    // do laço serial: max |lote - laço| / max |laço|
+    double *M = (double*)malloc(n*n*sizeof(double));
+    double *Minv = (double*)malloc(n*n*sizeof(double));
+    if (M == NULL || Minv == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        return EXIT_FAILURE;
+    }
+    int valid = 0, matrix_valid, matching = 0, compared = 0;
+    double max_difference = 0.0;
+    for (int b = 0; b < batch; b++) {
+        for (int e = 0; e < n*n; e++) {
+            M[e] = A[(size_t)e*batch + b];
+            Minv[e] = Ainv[(size_t)e*batch + b];
+        }
+        if (status[b]) {
+            invmat_check(invmat_validate_exact(serial_context, M, Minv, n, &matrix_valid));
+            valid += matrix_valid;
+
+            const double *reference = Ainv_seq + (size_t)b*n*n;
+            double diff = 0.0, scale = 0.0;
+            for (int e = 0; e < n*n; e++) {
+                diff = fmax(diff, fabs(Minv[e] - reference[e]));
+                scale = fmax(scale, fabs(reference[e]));
+            }
+            if (scale > 0.0) {
+                diff /= scale;
+            }
+            if (diff > max_difference) {
+                max_difference = diff;
+            }
+            compared++;
+            if (diff < COMPARE_TOLERANCE) {
+                matching++;
+            } else if (compared - matching <= COMPARE_REPORT_LIMIT) {
+                printf("Aviso: a inversa %d do lote difere da do laço serial (diferença relativa %.3e)\n", b, diff);
+            }
+        }
+    }
+    free(M);
+    free(Minv);
+
+    if (failures > 0) {
+        printf("Aviso: %d matrizes do lote parecem singulares\n", failures);
+    }
+    printf("Validação das matrizes inversas: %d de %d com SUCESSO\n", valid, batch);
+    printf("Comparação com o laço serial: %d de %d iguais (maior diferença relativa %.3e)\n",
+           matching, compared, max_difference);
+
+    double loop_rate = batch / loop_time;
+    double batch_rate = batch / batch_time;
+
+    // Grava os resultados em um arquivo CSV para análise de escalabilidade
+    FILE *results_file = fopen("results_batch.csv", "a");
+    if (results_file == NULL) {
+        fprintf(stderr, "Erro ao abrir o arquivo de resultados results_batch.csv\n");
+    } else {
+        // Verifica se o arquivo está vazio para adicionar o cabeçalho
+        fseek(results_file, 0, SEEK_END);
+        long size = ftell(results_file);
+
+        if (size == 0) {
+            fprintf(results_file, "tamanho_matriz,tamanho_lote,num_threads,tempo_laco,tempo_lote\n");
+        }
+
+        // Adiciona os resultados
+        fprintf(results_file, "%d,%d,%d,%.6f,%.6f\n", n, batch, num_threads, loop_time, batch_time);
+        fclose(results_file);
+    }
+
+    printf("Tamanho das matrizes: %d x %d, lote de %d\n", n, n, batch);
+    printf("Número de threads: %d\n", num_threads);
+    printf("Laço sobre calculate_inverse_row_oriented: %.6f segundos (%.0f matrizes/s)\n", loop_time, loop_rate);
+    printf("Lote intercalado: %.6f segundos (%.0f matrizes/s)\n", batch_time, batch_rate);
+    printf("Ganho de vazão: %.2fx\n", batch_rate / loop_rate);
+
+    // Libera a memória
+    free(A);
+    free(Ainv);
+    free(A_seq);
+    free(Ainv_seq);
+    free(status);
+    invmat_context_destroy(batch_context);
+    invmat_context_destroy(serial_context);
+
+    return EXIT_SUCCESS;
+}
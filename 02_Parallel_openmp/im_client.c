@@ -0,0 +1,377 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "matrix_file.h"
+#include "service_protocol.h"
+
+// Função para medir o tempo em segundos
+double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Matriz aleatória com diagonal dominante: sempre inversível e bem
+// condicionada, para que toda requisição tenha uma inversa válida
+void generate_diagonally_dominant_matrix(double *matrix, int n, unsigned *seed) {
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            matrix[i*n + j] = 2.0 * rand_r(seed) / RAND_MAX - 1.0;
+        }
+        matrix[i*n + i] += n;
+    }
+}
+
+// Lê exatamente bytes bytes; retorna 0 no fim da conexão ou em erro
+static int read_full(int fd, void *buffer, size_t bytes) {
+    char *p = (char*)buffer;
+    while (bytes > 0) {
+        ssize_t r = read(fd, p, bytes);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            return 0;
+        }
+        p += r;
+        bytes -= r;
+    }
+    return 1;
+}
+
+static int write_full(int fd, const void *buffer, size_t bytes) {
+    const char *p = (const char*)buffer;
+    while (bytes > 0) {
+        ssize_t w = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w <= 0) {
+            return 0;
+        }
+        p += w;
+        bytes -= w;
+    }
+    return 1;
+}
+
+// Teste de Freivalds com um vetor x de entradas ±1: ||A*(A^-1*x) - x||_inf
+double freivalds_residual(const double *A, const double *Ainv, int n, unsigned *seed) {
+    double *x = (double*)malloc(n*sizeof(double));
+    double *y = (double*)malloc(n*sizeof(double));
+    if (x == NULL || y == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) {
+        x[i] = (rand_r(seed) & 1) ? 1.0 : -1.0;
+    }
+    for (int i = 0; i < n; i++) {
+        double sum = 0.0;
+        for (int j = 0; j < n; j++) {
+            sum += Ainv[(size_t)i*n + j] * x[j];
+        }
+        y[i] = sum;
+    }
+    double residual = 0.0;
+    for (int i = 0; i < n; i++) {
+        double sum = 0.0;
+        for (int j = 0; j < n; j++) {
+            sum += A[(size_t)i*n + j] * y[j];
+        }
+        residual = fmax(residual, fabs(sum - x[i]));
+    }
+    free(x);
+    free(y);
+    return residual;
+}
+
+// Parâmetros e resultados de uma conexão do gerador de carga
+typedef struct {
+    int id;
+    int n;
+    int requests;               // requisições desta conexão, em sequência
+    const char *socket_path;
+    const double *file_matrix;  // matriz de --arquivo (NULL: gerada)
+    int layout;
+    int validate;
+    double *latencies;          // latência de cada requisição no cliente (s)
+    int completed;
+    int errors;
+    int invalid;
+    double queue_seconds;       // somas informadas pelo servidor
+    double compute_seconds;
+    double batch_size;
+} connection_t;
+
+static void *connection_thread(void *arg) {
+    connection_t *c = (connection_t*)arg;
+    int n = c->n;
+    size_t data_bytes = (size_t)n*n*sizeof(double);
+    unsigned seed = 12345u + 7919u*c->id;
+
+    double *A = (double*)malloc(data_bytes);
+    double *Ainv = (double*)malloc(data_bytes);
+    if (A == NULL || Ainv == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+    if (c->file_matrix != NULL) {
+        memcpy(A, c->file_matrix, data_bytes);
+    } else {
+        generate_diagonally_dominant_matrix(A, n, &seed);
+    }
+
+    // Cabeçalho de Comum/matrix_file.h, sem o preenchimento do arquivo
+    matrix_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MATRIX_FILE_MAGIC, 8);
+    header.version = MATRIX_FILE_VERSION;
+    header.elem_type = MATRIX_ELEM_F64;
+    header.layout = c->layout;
+    header.data_offset = sizeof(header);
+    header.n = n;
+    header.checksum = matrix_checksum(A, data_bytes);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, c->socket_path);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Erro ao conectar em %s: %s\n", c->socket_path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    for (int r = 0; r < c->requests; r++) {
+        double start = get_time();
+        service_response_t response;
+        if (!write_full(fd, &header, sizeof(header)) || !write_full(fd, A, data_bytes) ||
+            !read_full(fd, &response, sizeof(response)) ||
+            memcmp(response.magic, SERVICE_RESPONSE_MAGIC, 8) != 0) {
+            fprintf(stderr, "Erro: conexão %d encerrada pelo servidor\n", c->id);
+            break;
+        }
+
+        if (response.status == SERVICE_OK) {
+            matrix_file_header_t result;
+            if (!read_full(fd, &result, sizeof(result)) || result.n != (uint64_t)n ||
+                result.data_offset != sizeof(result) || !read_full(fd, Ainv, data_bytes)) {
+                fprintf(stderr, "Erro: resposta inválida na conexão %d\n", c->id);
+                break;
+            }
+            c->latencies[c->completed] = get_time() - start;
+            if (matrix_checksum(Ainv, data_bytes) != result.checksum) {
+                c->invalid++;
+            } else if (c->validate && !(freivalds_residual(A, Ainv, n, &seed) < 1e-6)) {
+                c->invalid++;
+            }
+        } else {
+            c->latencies[c->completed] = get_time() - start;
+            if (c->errors == 0) {
+                fprintf(stderr, "Aviso: conexão %d: %s\n", c->id, service_status_name(response.status));
+            }
+            c->errors++;
+        }
+        c->queue_seconds += response.queue_seconds;
+        c->compute_seconds += response.compute_seconds;
+        c->batch_size += response.batch_size;
+        c->completed++;
+    }
+
+    close(fd);
+    free(A);
+    free(Ainv);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil p (0..100) de valores ordenados
+static double percentile(const double *sorted, long count, double p) {
+    long index = (long)ceil(p / 100.0 * count) - 1;
+    if (index < 0) {
+        index = 0;
+    }
+    return sorted[index];
+}
+
+// Retira de argv as opções, aceitas em qualquer posição:
+//   --arquivo=F  envia a matriz de F (formato de Comum/matrix_file.h) em vez de gerar uma
+//   --validar    confere cada inversa recebida com o teste de Freivalds
+void parse_options(int *argc, char *argv[], const char **filename, int *validate) {
+    int kept = 1;
+    for (int a = 1; a < *argc; a++) {
+        if (strncmp(argv[a], "--arquivo=", 10) == 0) {
+            *filename = argv[a] + 10;
+        } else if (strcmp(argv[a], "--validar") == 0) {
+            *validate = 1;
+        } else {
+            argv[kept++] = argv[a];
+        }
+    }
+    *argc = kept;
+    argv[kept] = NULL;
+}
+
+int main(int argc, char *argv[]) {
+    const char *filename = NULL;
+    int validate = 0;
+    parse_options(&argc, argv, &filename, &validate);
+
+    if (argc < 3 || argc > 5) {
+        fprintf(stderr, "Uso: %s <tamanho_da_matriz> <requisicoes> [conexoes] [socket] [--arquivo=F] [--validar]\n", argv[0]);
+        fprintf(stderr, "conexoes: conexões simultâneas, cada uma enviando a próxima requisição ao receber a resposta (padrão 1)\n");
+        fprintf(stderr, "socket: caminho do socket Unix do servidor (padrão %s)\n", SERVICE_DEFAULT_SOCKET);
+        return EXIT_FAILURE;
+    }
+
+    int n = atoi(argv[1]);
+    int requests = atoi(argv[2]);
+    int connections = (argc >= 4) ? atoi(argv[3]) : 1;
+    const char *socket_path = (argc == 5) ? argv[4] : SERVICE_DEFAULT_SOCKET;
+
+    if (n <= 0 || n > SERVICE_MAX_N) {
+        fprintf(stderr, "Erro: O tamanho da matriz deve estar entre 1 e %d\n", SERVICE_MAX_N);
+        return EXIT_FAILURE;
+    }
+
+    if (requests <= 0 || connections <= 0) {
+        fprintf(stderr, "Erro: O número de requisições e de conexões deve ser positivo\n");
+        return EXIT_FAILURE;
+    }
+
+    if (strlen(socket_path) >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+        fprintf(stderr, "Erro: O caminho do socket é longo demais\n");
+        return EXIT_FAILURE;
+    }
+
+    if (connections > requests) {
+        connections = requests;
+    }
+
+    // Matriz de um arquivo, enviada por todas as conexões
+    matrix_map_t map;
+    const double *file_matrix = NULL;
+    int layout = MATRIX_ROW_MAJOR;
+    if (filename != NULL) {
+        file_matrix = matrix_file_open(filename, n, &map);
+        if (map.n != n) {
+            fprintf(stderr, "Erro: %s contém uma matriz %dx%d\n", filename, map.n, map.n);
+            return EXIT_FAILURE;
+        }
+        layout = map.layout;
+        printf("Matriz enviada: %s (%s)\n", filename, matrix_file_format_name(&map));
+    }
+
+    connection_t *conns = (connection_t*)calloc(connections, sizeof(connection_t));
+    pthread_t *threads = (pthread_t*)malloc(connections*sizeof(pthread_t));
+    double *latencies = (double*)malloc((size_t)requests*sizeof(double));
+    if (conns == NULL || threads == NULL || latencies == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        return EXIT_FAILURE;
+    }
+
+    // Requisições divididas entre as conexões; cada uma grava as suas
+    // latências num trecho contíguo do vetor
+    int offset = 0;
+    for (int c = 0; c < connections; c++) {
+        conns[c].id = c;
+        conns[c].n = n;
+        conns[c].requests = requests / connections + (c < requests % connections);
+        conns[c].socket_path = socket_path;
+        conns[c].file_matrix = file_matrix;
+        conns[c].layout = layout;
+        conns[c].validate = validate;
+        conns[c].latencies = latencies + offset;
+        offset += conns[c].requests;
+    }
+
+    printf("Enviando %d requisições %dx%d por %d conexões a %s...\n", requests, n, n, connections, socket_path);
+    double start_time = get_time();
+    for (int c = 0; c < connections; c++) {
+        if (pthread_create(&threads[c], NULL, connection_thread, &conns[c]) != 0) {
+            fprintf(stderr, "Erro ao criar a thread da conexão %d\n", c);
+            return EXIT_FAILURE;
+        }
+    }
+    for (int c = 0; c < connections; c++) {
+        pthread_join(threads[c], NULL);
+    }
+    double elapsed = get_time() - start_time;
+
+    // Junta as latências das conexões (os trechos podem ter ficado incompletos)
+    long completed = 0;
+    int errors = 0, invalid = 0;
+    double queue_seconds = 0.0, compute_seconds = 0.0, batch_size = 0.0;
+    for (int c = 0; c < connections; c++) {
+        memmove(latencies + completed, conns[c].latencies, conns[c].completed*sizeof(double));
+        completed += conns[c].completed;
+        errors += conns[c].errors;
+        invalid += conns[c].invalid;
+        queue_seconds += conns[c].queue_seconds;
+        compute_seconds += conns[c].compute_seconds;
+        batch_size += conns[c].batch_size;
+    }
+    if (completed == 0) {
+        fprintf(stderr, "Erro: nenhuma requisição foi concluída\n");
+        return EXIT_FAILURE;
+    }
+    qsort(latencies, completed, sizeof(double), compare_double);
+
+    double throughput = completed / elapsed;
+    double p50 = percentile(latencies, completed, 50.0);
+    double p99 = percentile(latencies, completed, 99.0);
+
+    printf("Requisições concluídas: %ld de %d (%d com erro", completed, requests, errors);
+    if (validate) {
+        printf(", %d inversas inválidas", invalid);
+    } else if (invalid > 0) {
+        printf(", %d com checksum incorreto", invalid);
+    }
+    printf(")\n");
+    printf("Vazão: %.1f requisições/s (%.3f s no total)\n", throughput, elapsed);
+    printf("Latência no cliente: p50 %.3f ms, p99 %.3f ms, máximo %.3f ms\n",
+           1e3 * p50, 1e3 * p99, 1e3 * latencies[completed - 1]);
+    printf("No servidor (médias): fila %.3f ms, inversão %.3f ms, %.1f requisições por lote\n",
+           1e3 * queue_seconds / completed, 1e3 * compute_seconds / completed, batch_size / completed);
+
+    // Grava os resultados em um arquivo CSV para análise de latência
+    FILE *results_file = fopen("results_service.csv", "a");
+    if (results_file == NULL) {
+        fprintf(stderr, "Erro ao abrir o arquivo de resultados results_service.csv\n");
+    } else {
+        // Verifica se o arquivo está vazio para adicionar o cabeçalho
+        fseek(results_file, 0, SEEK_END);
+        long size = ftell(results_file);
+
+        if (size == 0) {
+            fprintf(results_file, "tamanho_matriz,conexoes,requisicoes,vazao_req_s,p50_ms,p99_ms\n");
+        }
+
+        fprintf(results_file, "%d,%d,%ld,%.1f,%.6f,%.6f\n", n, connections, completed, throughput, 1e3 * p50, 1e3 * p99);
+        fclose(results_file);
+    }
+
+    if (filename != NULL) {
+        matrix_file_close(&map);
+    }
+    free(conns);
+    free(threads);
+    free(latencies);
+    return (errors > 0 || invalid > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,664 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <omp.h>  // Inclusão da biblioteca OpenMP
+
+#include "simd_kernels.h"
+#include "matrix_file.h"
+#include "invmat.h"
+
+/*
+ * im_ooc.c - Inversão fora do núcleo (out-of-core) para matrizes maiores que
+ * a memória. A matriz fica num arquivo temporário de tiles quadrados b x b,
+ * gravados por colunas de blocos: a coluna de blocos J (N x b, tiles
+ * empilhados) é uma região contígua do arquivo, lida e escrita com um único
+ * pread/pwrite. Apenas algumas colunas de blocos ficam em memória.
+ *
+ * O algoritmo é o Gauss-Jordan in-place (substituição de colunas) por
+ * blocos. No passo K o painel (coluna de blocos K) é fatorado em memória;
+ * o resultado V = T*E_K descreve a transformação T dos b pivôs do passo, e
+ * cada outra coluna de blocos X recebe as trocas de linhas do passo seguidas
+ * de Z = D^-1 * X[linhas de K], por substituições com a LU do bloco
+ * diagonal D do painel original, e X[i] <- X[i] - C[i] * Z nas demais linhas
+ * (C = painel original; ~2n^3 flops no total). Enquanto uma coluna é
+ * atualizada, uma thread de E/S lê a próxima e grava a anterior.
+ */
+
+// Colunas de blocos em circulação na atualização (atual, próxima, anterior)
+#define OOC_RING 3
+
+// Menor tile aceito (largura mínima dos kernels SIMD)
+#define OOC_MIN_TILE 8
+
+// Número de vetores do teste de Freivalds
+#define VALIDATION_PROBES 3
+
+// Função para medir o tempo de execução
+double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Encerra com a mensagem da libinvmat se status não for INVMAT_OK
+void invmat_check(invmat_status_t status) {
+    if (status != INVMAT_OK) {
+        fprintf(stderr, "Erro: %s\n", invmat_error_message());
+        exit(EXIT_FAILURE);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Thread de E/S: atende pedidos em ordem FIFO, de modo que uma leitura
+// enfileirada depois de uma escrita da mesma coluna sempre vê os dados novos
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int write;          // 0 = leitura, 1 = escrita
+    off_t offset;       // posição do primeiro trecho no arquivo
+    size_t bytes;       // bytes por trecho
+    int count;          // número de trechos
+    off_t stride;       // distância entre trechos no arquivo
+    double *buf;        // trechos ficam consecutivos no buffer
+    int done;
+} io_request_t;
+
+#define IO_QUEUE_SIZE 8
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    io_request_t *queue[IO_QUEUE_SIZE];
+    int head, count;
+    int stop;
+    int fd;
+    long long bytes_read, bytes_written;
+    double stall_time;  // tempo em que a thread de cálculo esperou pela E/S
+} io;
+
+static void io_transfer(io_request_t *req) {
+    char *buf = (char *)req->buf;
+
+    for (int c = 0; c < req->count; c++) {
+        size_t done = 0;
+        off_t offset = req->offset + c * req->stride;
+        while (done < req->bytes) {
+            ssize_t r = req->write
+                ? pwrite(io.fd, buf + done, req->bytes - done, offset + done)
+                : pread(io.fd, buf + done, req->bytes - done, offset + done);
+            if (r <= 0) {
+                fprintf(stderr, "Erro de E/S no arquivo de tiles\n");
+                exit(EXIT_FAILURE);
+            }
+            done += (size_t)r;
+        }
+        buf += req->bytes;
+    }
+}
+
+static void *io_thread_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&io.lock);
+    for (;;) {
+        while (io.count == 0 && !io.stop) {
+            pthread_cond_wait(&io.cond, &io.lock);
+        }
+        if (io.count == 0) {
+            break;
+        }
+        io_request_t *req = io.queue[io.head];
+        pthread_mutex_unlock(&io.lock);
+
+        io_transfer(req);
+
+        pthread_mutex_lock(&io.lock);
+        io.head = (io.head + 1) % IO_QUEUE_SIZE;
+        io.count--;
+        if (req->write) {
+            io.bytes_written += (long long)req->bytes * req->count;
+        } else {
+            io.bytes_read += (long long)req->bytes * req->count;
+        }
+        req->done = 1;
+        pthread_cond_broadcast(&io.cond);
+    }
+    pthread_mutex_unlock(&io.lock);
+
+    return NULL;
+}
+
+static void io_start(int fd) {
+    memset(&io, 0, sizeof(io));
+    io.fd = fd;
+    pthread_mutex_init(&io.lock, NULL);
+    pthread_cond_init(&io.cond, NULL);
+    if (pthread_create(&io.thread, NULL, io_thread_main, NULL) != 0) {
+        fprintf(stderr, "Erro ao criar a thread de E/S\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void io_stop(void) {
+    pthread_mutex_lock(&io.lock);
+    io.stop = 1;
+    pthread_cond_broadcast(&io.cond);
+    pthread_mutex_unlock(&io.lock);
+    pthread_join(io.thread, NULL);
+    pthread_mutex_destroy(&io.lock);
+    pthread_cond_destroy(&io.cond);
+}
+
+// Espera o pedido terminar; o tempo parado conta como espera por E/S
+static void io_wait(io_request_t *req) {
+    pthread_mutex_lock(&io.lock);
+    if (!req->done) {
+        double start = get_time();
+        while (!req->done) {
+            pthread_cond_wait(&io.cond, &io.lock);
+        }
+        io.stall_time += get_time() - start;
+    }
+    pthread_mutex_unlock(&io.lock);
+}
+
+// Enfileira um pedido. O buffer não pode ser tocado até io_wait(req)
+static void io_submit(io_request_t *req, int write, double *buf, off_t offset,
+                      size_t bytes, int count, off_t stride) {
+    // O pedido anterior deste buffer precisa ter terminado
+    io_wait(req);
+
+    req->write = write;
+    req->buf = buf;
+    req->offset = offset;
+    req->bytes = bytes;
+    req->count = count;
+    req->stride = stride;
+    req->done = 0;
+
+    pthread_mutex_lock(&io.lock);
+    if (io.count == IO_QUEUE_SIZE) {
+        double start = get_time();
+        while (io.count == IO_QUEUE_SIZE) {
+            pthread_cond_wait(&io.cond, &io.lock);
+        }
+        io.stall_time += get_time() - start;
+    }
+    io.queue[(io.head + io.count) % IO_QUEUE_SIZE] = req;
+    io.count++;
+    pthread_cond_broadcast(&io.cond);
+    pthread_mutex_unlock(&io.lock);
+}
+
+// Lê (write = 0) ou grava (write = 1) a coluna de blocos J inteira
+static void io_block_column(io_request_t *req, int write, double *buf, int J, int N, int b) {
+    size_t bytes = (size_t)N*b*sizeof(double);
+    io_submit(req, write, buf, (off_t)J * bytes, bytes, 1, 0);
+}
+
+// ---------------------------------------------------------------------------
+// Núcleos de cálculo sobre colunas de blocos (N x b, orientadas a linhas)
+// ---------------------------------------------------------------------------
+
+// Fatora o painel K no próprio buffer (Gauss-Jordan in-place restrito às b
+// colunas do painel). Grava os pivôs em ipiv[K*b .. K*b+b-1]. Retorna 0 se
+// a matriz parecer singular
+static int factor_panel(double *V, int N, int b, int K, int *ipiv) {
+    for (int c = 0; c < b; c++) {
+        int k = K*b + c;
+
+        // Encontra o pivô (valor máximo na coluna c do painel)
+        double pivot_value;
+        int pivot_row = simd_abs_argmax(V + c, b, k, N, &pivot_value);
+
+        // Se o pivô for muito pequeno, a matriz pode ser singular
+        if (pivot_value < 1e-10) {
+            return 0;
+        }
+
+        // Troca as linhas do painel; as demais colunas trocam na atualização
+        ipiv[k] = pivot_row;
+        if (pivot_row != k) {
+            for (int j = 0; j < b; j++) {
+                double temp = V[(size_t)k*b + j];
+                V[(size_t)k*b + j] = V[(size_t)pivot_row*b + j];
+                V[(size_t)pivot_row*b + j] = temp;
+            }
+        }
+
+        // Normaliza a linha do pivô; V[k][c] passa a ser 1/pivô
+        double pivot = V[(size_t)k*b + c];
+        V[(size_t)k*b + c] = 1.0;
+        simd_scale(V + (size_t)k*b, pivot, b);
+
+        // Eliminação de Gauss (paralelizado); V[i][c] passa a ser -fator/pivô
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < N; i++) {
+            if (i != k) {
+                double factor = V[(size_t)i*b + c];
+                V[(size_t)i*b + c] = 0.0;
+                simd_axpy(V + (size_t)i*b, V + (size_t)k*b, factor, b);
+            }
+        }
+    }
+
+    return 1;
+}
+
+// Fatoração LU in-place (L com diagonal unitária abaixo, U acima) do bloco
+// diagonal D, b x b, do painel original já trocado. As trocas do painel já
+// levaram para D os pivôs do pivotamento parcial, então não há novas trocas
+static void factor_diagonal_block(double *LU, int b) {
+    for (int j = 0; j < b; j++) {
+        const double *pivot_row = LU + (size_t)j*b;
+        for (int r = j + 1; r < b; r++) {
+            double *row = LU + (size_t)r*b;
+            row[j] /= pivot_row[j];
+            simd_axpy(row + j + 1, pivot_row + j + 1, row[j], b - j - 1);
+        }
+    }
+}
+
+// Aplica a transformação do passo K a uma coluna de blocos X: as trocas de
+// linhas do painel, Y = D^-1 * X[linhas de K] por substituição direta com L
+// e reversa com U, e X[i] <- X[i] - C[i] * Y nas demais linhas, com C = P (o
+// painel original trocado). Em exatidão é o mesmo que X + (V - E_K) * X[K],
+// mas V[linhas de K] = D^-1 explícita amplificaria o arredondamento pelo
+// condicionamento de D
+static void update_block_column(double *X, const double *P, const double *LU, double *Y, int N, int b, int K,
+                                const int *ipiv) {
+    int k0 = K*b;
+
+    for (int k = k0; k < k0 + b; k++) {
+        if (ipiv[k] != k) {
+            for (int j = 0; j < b; j++) {
+                double temp = X[(size_t)k*b + j];
+                X[(size_t)k*b + j] = X[(size_t)ipiv[k]*b + j];
+                X[(size_t)ipiv[k]*b + j] = temp;
+            }
+        }
+    }
+
+    memcpy(Y, X + (size_t)k0*b, (size_t)b*b*sizeof(double));
+    for (int r = 1; r < b; r++) {
+        for (int c = 0; c < r; c++) {
+            simd_axpy(Y + (size_t)r*b, Y + (size_t)c*b, LU[(size_t)r*b + c], b);
+        }
+    }
+    for (int r = b - 1; r >= 0; r--) {
+        for (int c = r + 1; c < b; c++) {
+            simd_axpy(Y + (size_t)r*b, Y + (size_t)c*b, LU[(size_t)r*b + c], b);
+        }
+        simd_scale(Y + (size_t)r*b, LU[(size_t)r*b + r], b);
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < N; i++) {
+        double *row = X + (size_t)i*b;
+        const double *w = P + (size_t)i*b;
+
+        // As linhas do próprio bloco passam a ser Y
+        if (i >= k0 && i < k0 + b) {
+            memcpy(row, Y + (size_t)(i - k0)*b, (size_t)b*sizeof(double));
+            continue;
+        }
+        for (int c = 0; c < b; c++) {
+            if (w[c] != 0.0) {
+                simd_axpy(row, Y + (size_t)c*b, w[c], b);
+            }
+        }
+    }
+}
+
+// Aloca um buffer alinhado a 64 bytes
+static double *alloc_buffer(size_t elems) {
+    void *p = NULL;
+    if (posix_memalign(&p, 64, elems*sizeof(double)) != 0) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+    return (double *)p;
+}
+
+// Memória de trabalho para tiles de largura b: OOC_RING + 2 colunas de blocos
+// de N x b doubles (N = n completado até múltiplo de b; o anel, o painel
+// fatorado e o painel original) mais os blocos Y e LU
+static double ooc_working_set(int n, int b) {
+    double N = (double)((n + b - 1) / b) * b;
+    return ((OOC_RING + 2) * N + 2 * b) * b * sizeof(double);
+}
+
+// Função para calcular a inversa fora do núcleo. A (n x n, normalmente
+// mapeada do arquivo de entrada) é copiada para o arquivo de tiles em
+// tile_path; a inversa é escrita em Ainv (normalmente o arquivo de saída
+// mapeado) uma faixa de linhas por vez. Em memória ficam apenas
+// OOC_RING + 2 colunas de blocos de N x b doubles
+void calculate_inverse_out_of_core(const double *A, double *Ainv, int n, int b, const char *tile_path) {
+    int nt = (n + b - 1) / b;
+    int N = nt * b;  // completada com a identidade até um múltiplo de b
+    size_t col_elems = (size_t)N*b;
+
+    int fd = open(tile_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "Erro ao criar o arquivo de tiles %s\n", tile_path);
+        exit(EXIT_FAILURE);
+    }
+    // O arquivo some ao ser fechado, inclusive se o programa terminar com erro
+    unlink(tile_path);
+
+    if (posix_fallocate(fd, 0, (off_t)N * N * (off_t)sizeof(double)) != 0) {
+        fprintf(stderr, "Erro: espaço insuficiente em disco para o arquivo de tiles\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double *V = alloc_buffer(col_elems);
+    double *ring[OOC_RING];
+    for (int r = 0; r < OOC_RING; r++) {
+        ring[r] = alloc_buffer(col_elems);
+    }
+    double *P = alloc_buffer(col_elems);
+    double *Y = alloc_buffer((size_t)b*b);
+    double *LU = alloc_buffer((size_t)b*b);
+    int *ipiv = (int*)malloc(N*sizeof(int));
+    int *order = (int*)malloc(nt*sizeof(int));
+    int *col_perm = (int*)malloc(N*sizeof(int));
+
+    if (ipiv == NULL || order == NULL || col_perm == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+
+    io_request_t vreq = { .done = 1 };
+    io_request_t rreq[OOC_RING];
+    for (int r = 0; r < OOC_RING; r++) {
+        rreq[r].done = 1;
+    }
+
+    io_start(fd);
+
+    // 1. Copia A para o arquivo de tiles, uma coluna de blocos por vez
+    for (int J = 0; J < nt; J++) {
+        int slot = J % OOC_RING;
+        double *X = ring[slot];
+        io_wait(&rreq[slot]);
+
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < N; i++) {
+            for (int c = 0; c < b; c++) {
+                int j = J*b + c;
+                X[(size_t)i*b + c] = (i < n && j < n) ? A[(size_t)i*n + j] : (i == j ? 1.0 : 0.0);
+            }
+        }
+        io_block_column(&rreq[slot], 1, X, J, N, b);
+    }
+
+    // 2. Um passo por coluna de blocos: fatora o painel e atualiza as demais
+    for (int K = 0; K < nt; K++) {
+        io_block_column(&vreq, 0, V, K, N, b);
+        io_wait(&vreq);
+        memcpy(P, V, col_elems*sizeof(double));
+
+        if (!factor_panel(V, N, b, K, ipiv)) {
+            fprintf(stderr, "Erro: A matriz parece ser singular ou mal condicionada\n");
+            exit(EXIT_FAILURE);
+        }
+
+        // Painel original com as mesmas trocas (fatores C) e a LU do seu
+        // bloco diagonal
+        for (int k = K*b; k < K*b + b; k++) {
+            if (ipiv[k] != k) {
+                for (int j = 0; j < b; j++) {
+                    double temp = P[(size_t)k*b + j];
+                    P[(size_t)k*b + j] = P[(size_t)ipiv[k]*b + j];
+                    P[(size_t)ipiv[k]*b + j] = temp;
+                }
+            }
+        }
+        memcpy(LU, P + (size_t)K*b*b, (size_t)b*b*sizeof(double));
+        factor_diagonal_block(LU, b);
+
+        // O painel fatorado é a coluna K daqui em diante (V continua em uso,
+        // somente leitura, enquanto a escrita acontece)
+        io_block_column(&vreq, 1, V, K, N, b);
+
+        int m = 0;
+        for (int J = 0; J < nt; J++) {
+            if (J != K) {
+                order[m++] = J;
+            }
+        }
+
+        // Leitura antecipada da primeira coluna
+        if (m > 0) {
+            io_block_column(&rreq[0], 0, ring[0], order[0], N, b);
+        }
+
+        for (int idx = 0; idx < m; idx++) {
+            int slot = idx % OOC_RING;
+            io_wait(&rreq[slot]);
+
+            // Prefetch da próxima coluna enquanto esta é atualizada
+            if (idx + 1 < m) {
+                int next = (idx + 1) % OOC_RING;
+                io_block_column(&rreq[next], 0, ring[next], order[idx + 1], N, b);
+            }
+
+            update_block_column(ring[slot], P, LU, Y, N, b, K, ipiv);
+            io_block_column(&rreq[slot], 1, ring[slot], order[idx], N, b);
+        }
+    }
+
+    // 3. Desfaz as trocas de linhas como trocas de colunas (na ordem inversa)
+    // e escreve a inversa por faixas de b linhas: a faixa I é formada pelos
+    // tiles (I, 0..nt-1), cada um lido da sua coluna de blocos
+    for (int j = 0; j < N; j++) {
+        col_perm[j] = j;
+    }
+    for (int k = N - 1; k >= 0; k--) {
+        int temp = col_perm[k];
+        col_perm[k] = col_perm[ipiv[k]];
+        col_perm[ipiv[k]] = temp;
+    }
+
+    size_t tile_bytes = (size_t)b*b*sizeof(double);
+    off_t col_bytes = (off_t)col_elems * (off_t)sizeof(double);
+    io_submit(&rreq[0], 0, ring[0], 0, tile_bytes, nt, col_bytes);
+
+    for (int I = 0; I < nt; I++) {
+        int slot = I % 2;
+        double *S = ring[slot];
+        io_wait(&rreq[slot]);
+
+        if (I + 1 < nt) {
+            int next = (I + 1) % 2;
+            io_submit(&rreq[next], 0, ring[next], (off_t)(I + 1) * (off_t)tile_bytes,
+                      tile_bytes, nt, col_bytes);
+        }
+
+        int rows = (n - I*b < b) ? n - I*b : b;
+        #pragma omp parallel for schedule(static)
+        for (int r = 0; r < rows; r++) {
+            double *out = Ainv + (size_t)(I*b + r)*n;
+            for (int j = 0; j < n; j++) {
+                int src = col_perm[j];
+                out[j] = S[(size_t)(src / b)*b*b + (size_t)r*b + src % b];
+            }
+        }
+    }
+
+    io_wait(&vreq);
+    for (int r = 0; r < OOC_RING; r++) {
+        io_wait(&rreq[r]);
+    }
+    io_stop();
+    close(fd);
+
+    free(V);
+    for (int r = 0; r < OOC_RING; r++) {
+        free(ring[r]);
+    }
+    free(P);
+    free(Y);
+    free(LU);
+    free(ipiv);
+    free(order);
+    free(col_perm);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4 && argc != 5) {
+        fprintf(stderr, "Uso: %s <tamanho_da_matriz> <num_threads> <memoria_MB> [tamanho_tile]\n", argv[0]);
+        fprintf(stderr, "memoria_MB: limite para as colunas de blocos mantidas em memória; sem tamanho_tile, o maior tile que cabe no limite é usado\n");
+        return EXIT_FAILURE;
+    }
+
+    // Obtem o tamanho da matriz, número de threads e limite de memória
+    int n = atoi(argv[1]);
+    int num_threads = atoi(argv[2]);
+    double budget_mb = atof(argv[3]);
+    int tile = (argc == 5) ? atoi(argv[4]) : 0;
+
+    if (n <= 0) {
+        fprintf(stderr, "Erro: O tamanho da matriz deve ser positivo\n");
+        return EXIT_FAILURE;
+    }
+
+    if (num_threads <= 0) {
+        fprintf(stderr, "Erro: O número de threads deve ser positivo\n");
+        return EXIT_FAILURE;
+    }
+
+    if (budget_mb <= 0 || tile < 0) {
+        fprintf(stderr, "Erro: O limite de memória e o tamanho do tile devem ser positivos\n");
+        return EXIT_FAILURE;
+    }
+
+    // Sem tamanho_tile, começa pela estimativa b ~ limite / ((OOC_RING + 2) * 8n)
+    // e reduz até o conjunto de trabalho (com o preenchimento) caber no limite
+    double budget = budget_mb * 1024.0 * 1024.0;
+    if (tile == 0) {
+        tile = (int)(budget / ((OOC_RING + 2) * 8.0 * n));
+        tile -= tile % OOC_MIN_TILE;
+        // Um único tile cobre n arredondado ao múltiplo de OOC_MIN_TILE (o
+        // preenchimento com a identidade completa o último bloco)
+        int max_tile = ((n + OOC_MIN_TILE - 1) / OOC_MIN_TILE) * OOC_MIN_TILE;
+        if (tile > max_tile) {
+            tile = max_tile;
+        }
+        while (tile > OOC_MIN_TILE && ooc_working_set(n, tile) > budget) {
+            tile -= OOC_MIN_TILE;
+        }
+    }
+    if (tile < OOC_MIN_TILE || ooc_working_set(n, tile) > budget) {
+        fprintf(stderr, "Erro: %.2f MB não comportam colunas de blocos de largura %d (mínimo %d) para n = %d\n",
+                budget_mb, tile, OOC_MIN_TILE, n);
+        return EXIT_FAILURE;
+    }
+    double working_set = ooc_working_set(n, tile);
+
+    omp_set_num_threads(num_threads);
+
+    // Define o nome dos arquivos de entrada, saída e tiles
+    char input_filename[100], output_filename[100], tile_filename[100];
+    sprintf(input_filename, "matrix_%d.bin", n);
+    sprintf(output_filename, "inverse_matrix_%d_ooc_%d.bin", n, num_threads);
+    sprintf(tile_filename, "ooc_tiles_%d_%d.tmp", n, (int)getpid());
+
+    // Entrada e saída são mapeadas em memória (formato de Comum/matrix_file.h);
+    // as páginas mapeadas ficam no cache de páginas, que o kernel pode liberar
+    matrix_map_t in_map, out_map;
+
+    // Verifica se o arquivo de entrada existe, se não, gera e salva uma matriz
+    FILE *test_file = fopen(input_filename, "rb");
+    if (test_file == NULL) {
+        printf("Arquivo de matriz de entrada não encontrado. Gerando nova matriz %dx%d...\n", n, n);
+
+        // Gera uma matriz inversível aleatória diretamente no arquivo
+        double *M = matrix_file_create(input_filename, n, MATRIX_ROW_MAJOR, &in_map);
+        invmat_generate(M, n, (unsigned int)time(NULL));
+        matrix_file_close(&in_map);
+        printf("Matriz salva em %s\n", input_filename);
+    } else {
+        fclose(test_file);
+        printf("Carregando matriz %dx%d do arquivo %s\n", n, n, input_filename);
+    }
+
+    double *A = matrix_file_open(input_filename, n, &in_map);
+    if (in_map.n != n) {
+        fprintf(stderr, "Erro: %s contém uma matriz %dx%d\n", input_filename, in_map.n, in_map.n);
+        matrix_file_close(&in_map);
+        return EXIT_FAILURE;
+    }
+
+    // A saída segue a ordem da entrada (inv(A^T) = inv(A)^T)
+    double *Ainv = matrix_file_create(output_filename, n, in_map.layout, &out_map);
+
+    // Seleciona os kernels SIMD de acordo com a CPU (ou IM_ISA)
+    simd_init();
+    printf("Kernels SIMD: %s\n", simd_isa_name());
+
+    // Mede o tempo de execução
+    double start_time = get_time();
+
+    printf("Calculando inversa (fora do núcleo, tiles de %dx%d, %.1f MB em memória, %d threads)...\n",
+           tile, tile, working_set / (1024.0 * 1024.0), num_threads);
+    calculate_inverse_out_of_core(A, Ainv, n, tile, tile_filename);
+
+    double end_time = get_time();
+    double execution_time = end_time - start_time;
+
+    // Valida a matriz inversa calculada pelo teste de Freivalds da libinvmat:
+    // percorre cada matriz uma vez por sonda, em ordem, sem buffers n^2
+    // (adequado a matrizes que não cabem na memória)
+    invmat_context_t *ctx;
+    invmat_check(invmat_context_create(INVMAT_BACKEND_OPENMP, num_threads, &ctx));
+    double residual;
+    invmat_check(invmat_validate_freivalds(ctx, A, Ainv, n, VALIDATION_PROBES, (unsigned int)time(NULL), &residual));
+    invmat_context_destroy(ctx);
+    if (residual < 1e-6) {
+        printf("Validação da matriz inversa (Freivalds, %d sondas): SUCESSO, resíduo ||A*(A^-1*x) - x||_inf = %.3e\n", VALIDATION_PROBES, residual);
+    } else {
+        printf("Validação da matriz inversa (Freivalds, %d sondas): FALHA, resíduo ||A*(A^-1*x) - x||_inf = %.3e\n", VALIDATION_PROBES, residual);
+    }
+
+    matrix_file_close(&out_map);
+    matrix_file_close(&in_map);
+    printf("Matriz inversa salva em %s\n", output_filename);
+
+    // Grava os resultados em um arquivo CSV para dimensionar o limite de memória
+    FILE *results_file = fopen("results_ooc.csv", "a");
+    if (results_file == NULL) {
+        fprintf(stderr, "Erro ao abrir o arquivo de resultados results_ooc.csv\n");
+    } else {
+        // Verifica se o arquivo está vazio para adicionar o cabeçalho
+        fseek(results_file, 0, SEEK_END);
+        long size = ftell(results_file);
+
+        if (size == 0) {
+            fprintf(results_file, "tamanho_matriz,num_threads,memoria_mb,tamanho_tile,tempo_execucao,bytes_lidos,bytes_escritos,tempo_espera_io\n");
+        }
+
+        // Adiciona os resultados
+        fprintf(results_file, "%d,%d,%.1f,%d,%.6f,%lld,%lld,%.6f\n", n, num_threads, budget_mb, tile,
+                execution_time, io.bytes_read, io.bytes_written, io.stall_time);
+        fclose(results_file);
+    }
+
+    printf("Tamanho da matriz: %d x %d\n", n, n);
+    printf("Número de threads: %d\n", num_threads);
+    printf("Bytes lidos: %lld (%.1f MB)\n", io.bytes_read, io.bytes_read / (1024.0 * 1024.0));
+    printf("Bytes escritos: %lld (%.1f MB)\n", io.bytes_written, io.bytes_written / (1024.0 * 1024.0));
+    printf("Espera por E/S: %.6f segundos (%.1f%% do tempo)\n", io.stall_time, 100.0 * io.stall_time / execution_time);
+    printf("Tempo de execução: %.6f segundos\n", execution_time);
+
+    return EXIT_SUCCESS;
+}
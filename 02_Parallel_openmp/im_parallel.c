@@ -6,6 +6,14 @@
 #include <math.h>
 #include <omp.h>  // Inclusão da biblioteca OpenMP
 
+#include "simd_kernels.h"
+#include "fixed_size_kernels.h"
+#include "matrix_file.h"
+#include "topology.h"
+#include "arena.h"
+#include "gemm.h"
+#include "invmat.h"
+
 // Função para medir o tempo em segundos
 double get_time() {
     struct timeval tv;
@@ -13,208 +21,365 @@ double get_time() {
     return tv.tv_sec + tv.tv_usec * 1e-6;
 }
 
-// Função para gerar uma matriz aleatória n x n que seja inversível
-void generate_invertible_matrix(double *matrix, int n) {
-    // Primeiro cria uma matriz diagonal com valores não nulos na diagonal
+// Função para imprimir matriz (para depuração)
+void print_matrix(double *matrix, int n, const char *label) {
+    printf("%s:\n", label);
     for (int i = 0; i < n; i++) {
         for (int j = 0; j < n; j++) {
-            if (i == j) {
-                matrix[i*n + j] = (double)(rand() % 100) + 1.0; // Valores de 1 a 100 na diagonal
-            } else {
-                matrix[i*n + j] = 0.0;
-            }
-        }
-    }
-    
-    // Aplica permutações aleatórias para manter a matriz inversível mas não trivial
-    for (int k = 0; k < n*2; k++) {
-        int row1 = rand() % n;
-        int row2 = rand() % n;
-        
-        if (row1 != row2) {
-            // Soma a linha row1 com a linha row2 multiplicada por um fator aleatório
-            double factor = (double)(rand() % 10) + 0.1;
-            for (int j = 0; j < n; j++) {
-                matrix[row1*n + j] += factor * matrix[row2*n + j];
-            }
+            printf("%10.4f ", matrix[i*n + j]);
         }
+        printf("\n");
     }
+    printf("\n");
 }
 
-// Função para salvar a matriz em um arquivo binário
-void save_matrix_to_file(double *matrix, int n, const char *filename) {
-    FILE *file = fopen(filename, "wb");
-    if (file == NULL) {
-        fprintf(stderr, "Erro ao abrir o arquivo %s para escrita\n", filename);
-        exit(EXIT_FAILURE);
-    }
-    
-    fwrite(matrix, sizeof(double), n*n, file);
-    fclose(file);
-}
+// Contexto da libinvmat (Comum/invmat.h, backend "openmp") do método 1, dos
+// fallbacks e da validação: a área de trabalho (temp_A, o produto e os
+// buffers do GEMM) é reservada no primeiro uso e reaproveitada. Recriado se
+// o número de threads mudar
+invmat_context_t *openmp_context = NULL;
 
-// Função para carregar a matriz de um arquivo binário
-void load_matrix_from_file(double *matrix, int n, const char *filename) {
-    FILE *file = fopen(filename, "rb");
-    if (file == NULL) {
-        fprintf(stderr, "Erro ao abrir o arquivo %s para leitura\n", filename);
+// Termina o programa com a mensagem de um erro da biblioteca
+void invmat_check(invmat_status_t status) {
+    if (status != INVMAT_OK) {
+        fprintf(stderr, "Erro: %s\n", invmat_error_message());
         exit(EXIT_FAILURE);
     }
-    
-    size_t read_elements = fread(matrix, sizeof(double), n*n, file);
-    if (read_elements != n*n) {
-        fprintf(stderr, "Erro ao ler dados do arquivo %s\n", filename);
-        exit(EXIT_FAILURE);
-    }
-    
-    fclose(file);
 }
 
-// Função para imprimir matriz (para depuração)
-void print_matrix(double *matrix, int n, const char *label) {
-    printf("%s:\n", label);
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            printf("%10.4f ", matrix[i*n + j]);
-        }
-        printf("\n");
+invmat_context_t *shared_context(int num_threads) {
+    if (openmp_context != NULL && invmat_context_threads(openmp_context) != num_threads) {
+        invmat_context_destroy(openmp_context);
+        openmp_context = NULL;
     }
-    printf("\n");
+    if (openmp_context == NULL) {
+        invmat_check(invmat_context_create(INVMAT_BACKEND_OPENMP, num_threads, &openmp_context));
+    }
+    return openmp_context;
 }
 
 // Função paralela para calcular a inversa da matriz usando o método de Gauss-Jordan
-// Orientação a linhas (row-oriented)
+// Orientação a linhas (row-oriented), pelo backend "openmp" da libinvmat:
+// pivô por redução entre as threads, eliminação com schedule(static) e cópia
+// de A por primeiro toque; matrizes pequenas usam os kernels de tamanho fixo
 void calculate_inverse_row_oriented_parallel(double *A, double *Ainv, int n, int num_threads) {
-    // Define o número de threads a ser usado
-    omp_set_num_threads(num_threads);
+    invmat_check(invmat_invert_buffer(shared_context(num_threads), A, Ainv, n));
+}
+
+// Função paralela para calcular a inversa usando o método de Gauss-Jordan
+// com uma única região paralela para todo o laço k (invmat_invert_persistent).
+// Cada thread é dona de um bloco fixo de linhas (partição estática), a escolha
+// do pivô é uma redução sem lock sobre candidatos por thread, a troca de
+// linhas é dividida por colunas e a busca do próximo pivô é feita na mesma
+// passada da eliminação
+void calculate_inverse_persistent_parallel(double *A, double *Ainv, int n, int num_threads) {
+    invmat_check(invmat_invert_persistent(shared_context(num_threads), A, Ainv, n));
+}
+
+// Parâmetros padrão da versão com escalonamento por tarefas (DAG de tiles)
+#define DEFAULT_TILE_SIZE 64
+#define DEFAULT_LOOKAHEAD 1
+
+// Estatísticas do último escalonamento por tarefas, informadas pelo main
+invmat_tiled_stats_t tiled_stats;
+
+// Função paralela para calcular a inversa usando Gauss-Jordan blocado com um
+// escalonador de DAG (invmat_invert_tiled). [temp_A | Ainv] é dividido em
+// faixas de tile colunas; o painel K+1 é fatorado assim que sua faixa recebe
+// a atualização do passo K, sem barreira entre passos. O lookahead limita
+// quantos passos podem ter atualizações pendentes quando um novo painel
+// começa (0 = síncrono)
+void calculate_inverse_tiled_parallel(double *A, double *Ainv, int n, int num_threads, int tile, int lookahead) {
+    invmat_check(invmat_invert_tiled(shared_context(num_threads), A, Ainv, n, tile, lookahead, &tiled_stats));
+}
+
+// Função paralela para calcular a inversa via fatoração LU com pivotamento
+// parcial (invmat_invert_lu): P*A = L*U, inversão de U, resolução de
+// inv(A)*L = inv(U) e desfaz a permutação nas colunas (~2n^3 flops, metade
+// do Gauss-Jordan)
+void calculate_inverse_lu_parallel(double *A, double *Ainv, int n, int num_threads) {
+    invmat_check(invmat_invert_lu(shared_context(num_threads), A, Ainv, n));
+}
+
+// Função paralela para calcular a inversa no próprio buffer de entrada
+// (Gauss-Jordan com substituição de colunas, invmat_invert_in_place): n^2
+// doubles mais o vetor de pivôs e metade das operações do laço sobre
+// [temp_A | Ainv], já que o lado da identidade nunca é atualizado
+void calculate_inverse_in_place_parallel(double *A, int n, int num_threads) {
+    invmat_check(invmat_invert_in_place(shared_context(num_threads), A, n));
+}
+
+// Resultado do último refinamento por Newton-Schulz (relatado em main):
+// iterações feitas, resíduo ||I - A*X||_inf antes de cada iteração e no fim,
+// e se foi preciso recalcular a inversa do zero
+invmat_refine_info_t ns_info;
+
+// Função paralela para calcular a inversa em precisão mista
+// (invmat_invert_mixed): Gauss-Jordan in-place em float e refinamento em
+// double por Newton-Schulz, que dobra o número de dígitos corretos a cada
+// iteração. Se o resíduo não cair abaixo da tolerância de validate_inverse,
+// recalcula tudo em double pelo método 1
+void calculate_inverse_mixed_parallel(double *A, double *Ainv, int n, int num_threads) {
+    invmat_check(invmat_invert_mixed(shared_context(num_threads), A, Ainv, n, &ns_info));
+}
+
+// Função paralela para reinverter uma matriz que mudou pouco
+// (invmat_invert_from_guess): parte de uma inversa anterior (guess) em vez da
+// identidade e a atualiza por Newton-Schulz em poucos produtos de matrizes.
+// Se a aproximação estiver longe demais, volta para o método 1
+void calculate_inverse_newton_schulz_parallel(double *A, double *Ainv, const double *guess, int n, int num_threads) {
+    invmat_check(invmat_invert_from_guess(shared_context(num_threads), A, guess, Ainv, n, &ns_info));
+}
+
+// Função para validar a inversa calculada (A * A^-1 deve ser aproximadamente
+// I), com o produto na área de trabalho do contexto compartilhado
+int validate_inverse(double *A, double *Ainv, int n) {
+    int valid;
+    invmat_check(invmat_validate_exact(shared_context(omp_get_max_threads()), A, Ainv, n, &valid));
+    return valid;
+}
+
+// Função para validar a inversa uma linha de A * A^-1 por vez, sem o buffer
+// n^2 do resultado, para o modo in-place (A é lida do mapeamento do arquivo
+// de entrada)
+int validate_inverse_by_rows(const double *A, double *Ainv, int n) {
+    int valid;
+    invmat_check(invmat_validate_by_rows(shared_context(omp_get_max_threads()), A, Ainv, n, &valid));
+    return valid;
+}
+
+// Número padrão de vetores aleatórios da validação probabilística
+#define VALIDATION_PROBES 3
+
+// Diferença relativa máxima aceita entre uma tarefa do DAG e o método por
+// linhas (as duas ordens de operação diferem só no arredondamento, ampliado
+// pelo condicionamento de A)
+#define TASK_CHECK_TOLERANCE 1e-6
+
+// Função para validar a inversa sem formar A * A^-1 (teste de Freivalds,
+// invmat_validate_freivalds, paralelizado): O(n^2) e sem buffer n^2, com
+// probabilidade <= 2^-probes de aceitar uma inversa errada. Retorna o maior
+// ||r||_inf
+double validate_inverse_freivalds(const double *A, const double *Ainv, int n, int probes) {
+    double residual;
+    invmat_check(invmat_validate_freivalds(shared_context(omp_get_max_threads()), A, Ainv, n, probes,
+                                           (unsigned int)time(NULL), &residual));
+    return residual;
+}
+
+// Relatório de NUMA dos métodos em que cada thread elimina um bloco fixo de
+// linhas (1, 3 e 5): fração das páginas de M no nó da thread dona e banda de
+// memória por socket na eliminação, estimada pelo volume (em cada passo, as
+// linhas de cada matriz (arrays: 2 para temp_A e Ainv, 1 no in-place)
+// são lidas e escritas uma vez). Com measure_bandwidth, compara com o triad
+void report_numa(const topology_t *topo, const double *M, int n, int num_threads, int arrays,
+                 double elapsed, int measure_bandwidth) {
+    double local = topology_local_page_fraction(topo, M, n*sizeof(double), n, num_threads);
+    if (local >= 0.0) {
+        printf("Páginas da inversa no nó NUMA da thread dona: %.1f%%\n", 100.0 * local);
+    }
     
-    // Cria uma cópia da matriz A para não modificá-la
-    double *temp_A = (double*)malloc(n*n*sizeof(double));
-    memcpy(temp_A, A, n*n*sizeof(double));
+    long *rows = (long*)malloc(topo->num_sockets*sizeof(long));
+    double *peak = (double*)calloc(topo->num_sockets, sizeof(double));
+    if (rows == NULL || peak == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
     
-    // Inicializa Ainv como matriz identidade (paralelizado)
-    #pragma omp parallel for
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            Ainv[i*n + j] = (i == j) ? 1.0 : 0.0;
-        }
+    topology_rows_per_socket(topo, n, num_threads, rows);
+    if (measure_bandwidth) {
+        topology_stream_bandwidth(topo, num_threads, peak);
     }
     
-    // Algoritmo de Gauss-Jordan
-    for (int k = 0; k < n; k++) {
-        // Encontra o pivô (valor máximo na coluna k)
-        int pivot_row = k;
-        double pivot_value = fabs(temp_A[k*n + k]);
-        
-        // Usando redução para encontrar o pivô em paralelo
-        #pragma omp parallel
-        {
-            int local_pivot_row = pivot_row;
-            double local_pivot_value = pivot_value;
-            
-            #pragma omp for nowait
-            for (int i = k + 1; i < n; i++) {
-                double abs_value = fabs(temp_A[i*n + k]);
-                if (abs_value > local_pivot_value) {
-                    local_pivot_value = abs_value;
-                    local_pivot_row = i;
-                }
-            }
-            
-            // Redução crítica para encontrar o pivô global
-            #pragma omp critical
-            {
-                if (local_pivot_value > pivot_value) {
-                    pivot_value = local_pivot_value;
-                    pivot_row = local_pivot_row;
-                }
-            }
+    for (int s = 0; s < topo->num_sockets; s++) {
+        if (rows[s] == 0) {
+            continue;
         }
-        
-        // Se o pivô for muito pequeno, a matriz pode ser singular
-        if (pivot_value < 1e-10) {
-            fprintf(stderr, "Erro: A matriz parece ser singular ou mal condicionada\n");
-            free(temp_A);
-            exit(EXIT_FAILURE);
-        }
-        
-        // Troca as linhas se necessário (serial, pois é dependente)
-        if (pivot_row != k) {
-            for (int j = 0; j < n; j++) {
-                double temp = temp_A[k*n + j];
-                temp_A[k*n + j] = temp_A[pivot_row*n + j];
-                temp_A[pivot_row*n + j] = temp;
-                
-                temp = Ainv[k*n + j];
-                Ainv[k*n + j] = Ainv[pivot_row*n + j];
-                Ainv[pivot_row*n + j] = temp;
-            }
-        }
-        
-        // Normaliza a linha do pivô (paralelizado)
-        double pivot = temp_A[k*n + k];
-        #pragma omp parallel for
-        for (int j = 0; j < n; j++) {
-            temp_A[k*n + j] /= pivot;
-            Ainv[k*n + j] /= pivot;
-        }
-        
-        // Eliminação de Gauss (paralelizado)
-        #pragma omp parallel for schedule(dynamic)
-        for (int i = 0; i < n; i++) {
-            if (i != k) {
-                double factor = temp_A[i*n + k];
-                for (int j = 0; j < n; j++) {
-                    temp_A[i*n + j] -= factor * temp_A[k*n + j];
-                    Ainv[i*n + j] -= factor * Ainv[k*n + j];
-                }
-            }
+        double gbs = rows[s] * (double)n * arrays * 2.0 * n * sizeof(double) / (elapsed * 1e9);
+        if (measure_bandwidth && peak[s] > 0.0) {
+            // Acima de 100%, as linhas da thread cabem no cache e a
+            // eliminação não é limitada pela memória
+            printf("Socket %d: %ld linhas, %.2f GB/s na eliminação (%.0f%% dos %.2f GB/s do triad%s)\n",
+                   s, rows[s], gbs, 100.0 * gbs / peak[s], peak[s],
+                   gbs > peak[s] ? "; os dados cabem no cache" : "");
+        } else {
+            printf("Socket %d: %ld linhas, %.2f GB/s na eliminação\n", s, rows[s], gbs);
         }
     }
     
-    free(temp_A);
+    free(rows);
+    free(peak);
 }
 
-// Função para validar a inversa calculada (A * A^-1 deve ser aproximadamente I)
-int validate_inverse(double *A, double *Ainv, int n) {
-    double *result = (double*)malloc(n*n*sizeof(double));
-    double epsilon = 1e-6;
+// Uma execução de inversão + validação exata do método 1 como antes do
+// plano: temp_A e o produto A * A^-1 alocados com malloc e liberados a cada
+// chamada, e o GEMM com os próprios buffers. Devolve 1 se a inversa é válida
+int invert_and_validate_malloc(const double *A, double *Ainv, int n, int num_threads) {
+    double *temp_A = (double*)malloc((size_t)n*n*sizeof(double));
+    if (temp_A == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+    invmat_check(invmat_gauss_jordan_openmp(A, Ainv, temp_A, n, num_threads));
+    free(temp_A);
     
-    // Calcula A * A^-1 (paralelizado)
-    #pragma omp parallel for
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            result[i*n + j] = 0.0;
-            for (int k = 0; k < n; k++) {
-                result[i*n + j] += A[i*n + k] * Ainv[k*n + j];
-            }
-        }
+    double *result = (double*)malloc((size_t)n*n*sizeof(double));
+    if (result == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
     }
+    gemm(n, n, n, 1.0, A, n, Ainv, n, 0.0, result, n);
     
-    // Verifica se o resultado é aproximadamente a matriz identidade
-    for (int i = 0; i < n; i++) {
+    int valid = 1;
+    for (int i = 0; i < n && valid; i++) {
         for (int j = 0; j < n; j++) {
             double expected = (i == j) ? 1.0 : 0.0;
-            if (fabs(result[i*n + j] - expected) > epsilon) {
-                free(result);
-                return 0; // Falha na validação
+            if (fabs(result[(size_t)i*n + j] - expected) > 1e-6) {
+                valid = 0;
+                break;
             }
         }
     }
-    
     free(result);
-    return 1; // Validação bem-sucedida
+    return valid;
+}
+
+// Compara reps execuções de inversão + validação exata do método 1 com
+// malloc/free de temp_A e do produto a cada chamada (o código anterior ao
+// plano) e com um plano: um contexto da libinvmat com a área de trabalho
+// reservada uma vez para n e reaproveitada. Tempo e faltas de página
+void report_plan(double *A, double *Ainv, int n, int num_threads, int reps) {
+    int valid_call = 0, valid_plan = 0, valid;
+    
+    long faults = arena_page_faults();
+    double start = get_time();
+    for (int r = 0; r < reps; r++) {
+        valid_call += invert_and_validate_malloc(A, Ainv, n, num_threads);
+    }
+    double call_time = get_time() - start;
+    long call_faults = arena_page_faults() - faults;
+    
+    invmat_context_t *plan;
+    faults = arena_page_faults();
+    start = get_time();
+    invmat_check(invmat_context_create(INVMAT_BACKEND_OPENMP, num_threads, &plan));
+    invmat_check(invmat_context_reserve(plan, n));
+    double setup_time = get_time() - start;
+    long setup_faults = arena_page_faults() - faults;
+    
+    faults = arena_page_faults();
+    start = get_time();
+    for (int r = 0; r < reps; r++) {
+        invmat_check(invmat_invert_buffer(plan, A, Ainv, n));
+        invmat_check(invmat_validate_exact(plan, A, Ainv, n, &valid));
+        valid_plan += valid;
+    }
+    double plan_time = get_time() - start;
+    long plan_faults = arena_page_faults() - faults;
+    
+    size_t arena_bytes;
+    long huge_bytes;
+    const char *backing;
+    invmat_context_scratch(plan, &arena_bytes, &huge_bytes, &backing);
+    
+    printf("Plano reutilizável (%d execuções de inversão + validação exata):\n", reps);
+    printf("  malloc por chamada: %.3f s (%.4f s por execução), %ld faltas de página (%.0f por execução), %d/%d válidas\n",
+           call_time, call_time / reps, call_faults, (double)call_faults / reps, valid_call, reps);
+    printf("  plano: criação %.3f s com %ld faltas de página; execuções %.3f s (%.4f s por execução), %ld faltas de página (%.0f por execução), %d/%d válidas\n",
+           setup_time, setup_faults, plan_time, plan_time / reps, plan_faults, (double)plan_faults / reps, valid_plan, reps);
+    printf("  arena: %.1f MB, %s", arena_bytes / 1048576.0, backing);
+    if (huge_bytes >= 0) {
+        printf(", %.1f MB em páginas grandes", huge_bytes / 1048576.0);
+    }
+    printf("\n");
+    
+    double saved = (call_time - plan_time) / reps;
+    if (saved > 0.0) {
+        printf("  tempo economizado: %.4f s por execução (%.1f%%); a criação do plano se paga em %.1f execuções\n",
+               saved, 100.0 * saved / (call_time / reps), setup_time / saved);
+    } else {
+        printf("  tempo economizado: nenhum (%.4f s por execução a mais com o plano)\n", -saved);
+    }
+    
+    invmat_context_destroy(plan);
+}
+
+// Retira de argv as opções, aceitas em qualquer posição:
+//   --exato      confere A * A^-1 = I entrada a entrada (O(n^3))
+//   --sondas=K   número de vetores do teste de Freivalds (padrão VALIDATION_PROBES)
+//   --banda      mede a banda de memória de cada socket (triad) para o relatório
+//   --plano=R    compara R execuções com malloc por chamada e com o plano reutilizável
+//   --tarefas    confere cada tarefa do DAG do método 4 com o método por linhas
+void parse_options(int *argc, char *argv[], int *exact, int *probes, int *bandwidth, int *plan_reps,
+                   int *check_tasks) {
+    int kept = 1;
+    for (int a = 1; a < *argc; a++) {
+        if (strcmp(argv[a], "--exato") == 0) {
+            *exact = 1;
+        } else if (strcmp(argv[a], "--tarefas") == 0) {
+            *check_tasks = 1;
+        } else if (strcmp(argv[a], "--banda") == 0) {
+            *bandwidth = 1;
+        } else if (strncmp(argv[a], "--sondas=", 9) == 0) {
+            *probes = atoi(argv[a] + 9);
+            if (*probes <= 0) {
+                fprintf(stderr, "Erro: O número de sondas deve ser positivo\n");
+                exit(EXIT_FAILURE);
+            }
+        } else if (strncmp(argv[a], "--plano=", 8) == 0) {
+            *plan_reps = atoi(argv[a] + 8);
+            if (*plan_reps <= 0) {
+                fprintf(stderr, "Erro: O número de execuções do plano deve ser positivo\n");
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            argv[kept++] = argv[a];
+        }
+    }
+    *argc = kept;
+    argv[kept] = NULL;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        fprintf(stderr, "Uso: %s <tamanho_da_matriz> <num_threads>\n", argv[0]);
+    // Opções da validação e do relatório de banda (as demais são posicionais)
+    int exact_validation = 0;
+    int probes = VALIDATION_PROBES;
+    int measure_bandwidth = 0;
+    int plan_reps = 0;
+    int check_tasks = 0;
+    parse_options(&argc, argv, &exact_validation, &probes, &measure_bandwidth, &plan_reps, &check_tasks);
+    
+    if (argc < 3 || argc > 6) {
+        fprintf(stderr, "Uso: %s <tamanho_da_matriz> <num_threads> [metodo] [tamanho_tile] [lookahead] [--exato] [--sondas=K] [--banda] [--plano=R] [--tarefas]\n", argv[0]);
+        fprintf(stderr, "     %s <tamanho_da_matriz> <num_threads> 7 <inversa_anterior.bin> [--exato] [--sondas=K]\n", argv[0]);
+        fprintf(stderr, "metodo: 1 para Gauss-Jordan (padrão), 2 para fatoração LU, 3 para Gauss-Jordan com região paralela persistente, 4 para Gauss-Jordan por tiles com escalonamento de tarefas, 5 para Gauss-Jordan in-place, 6 para precisão mista com refinamento, 7 para Newton-Schulz a partir de uma inversa anterior\n");
+        fprintf(stderr, "validação: teste de Freivalds com K vetores aleatórios (padrão %d); --exato confere A * A^-1 = I inteira\n", VALIDATION_PROBES);
+        fprintf(stderr, "--banda: mede a banda de memória de cada socket e informa a fração usada pela eliminação (métodos 1, 3 e 5)\n");
+        fprintf(stderr, "--plano=R: compara R inversões + validações exatas com malloc por chamada e com um plano em páginas grandes (método 1)\n");
+        fprintf(stderr, "--tarefas: confere cada tarefa de atualização do método 4 com o estado do método por linhas no mesmo passo\n");
+        fprintf(stderr, "IM_PIN=spread|compact|none: fixação das threads nas CPUs (padrão spread)\n");
         return EXIT_FAILURE;
     }
     
-    // Obtem o tamanho da matriz e número de threads dos argumentos
+    // Obtem o tamanho da matriz, número de threads e método dos argumentos
     int n = atoi(argv[1]);
     int num_threads = atoi(argv[2]);
+    int method = (argc >= 4) ? atoi(argv[3]) : 1;
+    int tile = DEFAULT_TILE_SIZE;
+    int lookahead = DEFAULT_LOOKAHEAD;
+    const char *guess_filename = NULL;
+    
+    // No método 7 o quarto argumento é o arquivo da inversa anterior
+    if (method == 7) {
+        if (argc != 5) {
+            fprintf(stderr, "Erro: O método 7 requer o arquivo da inversa anterior\n");
+            return EXIT_FAILURE;
+        }
+        guess_filename = argv[4];
+    } else {
+        tile = (argc >= 5) ? atoi(argv[4]) : DEFAULT_TILE_SIZE;
+        lookahead = (argc >= 6) ? atoi(argv[5]) : DEFAULT_LOOKAHEAD;
+    }
     
     if (n <= 0) {
         fprintf(stderr, "Erro: O tamanho da matriz deve ser positivo\n");
@@ -226,66 +391,208 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
     
-    // Aloca memória para as matrizes
-    double *A = (double*)malloc(n*n*sizeof(double));
-    double *Ainv = (double*)malloc(n*n*sizeof(double));
+    if (method < 1 || method > 7) {
+        fprintf(stderr, "Erro: Método deve ser 1 (Gauss-Jordan), 2 (LU), 3 (Gauss-Jordan persistente), 4 (tiles), 5 (in-place), 6 (precisão mista) ou 7 (Newton-Schulz)\n");
+        return EXIT_FAILURE;
+    }
     
-    if (A == NULL || Ainv == NULL) {
-        fprintf(stderr, "Erro: Falha na alocação de memória\n");
-        free(A);
-        free(Ainv);
+    if (tile <= 0 || lookahead < 0) {
+        fprintf(stderr, "Erro: O tamanho do tile deve ser positivo e o lookahead não negativo\n");
         return EXIT_FAILURE;
     }
     
+    if (plan_reps > 0 && method != 1) {
+        fprintf(stderr, "Erro: --plano=R só se aplica ao método 1\n");
+        return EXIT_FAILURE;
+    }
+    
+    // Topologia da máquina e fixação das threads, antes de qualquer região
+    // paralela que toque as matrizes (para o primeiro toque valer)
+    topology_t topo;
+    topology_detect(&topo);
+    topology_print(&topo);
+    omp_set_num_threads(num_threads);
+    if (topology_pin_threads(&topo, num_threads)) {
+        printf("Threads fixadas nas CPUs (IM_PIN=%s)\n", topology_policy_name(&topo));
+    } else {
+        printf("Threads sem fixação\n");
+    }
+    if (num_threads > topo.num_cpus) {
+        printf("Aviso: %d threads para %d CPUs lógicas; as threads excedentes dividem CPUs\n", num_threads, topo.num_cpus);
+    }
+    
+    // Prefixo dos arquivos de saída de cada método (Gauss-Jordan mantém os nomes originais)
+    const char *method_tags[] = { "omp", "omp_lu", "omp_persist", "omp_tiled", "omp_inp", "omp_mixed", "omp_ns" };
+    const char *method_tag = method_tags[method - 1];
+    
+    // No modo in-place a inversa sobrescreve a cópia de A no arquivo de saída
+    int in_place = (method == 5);
+    
     // Define o nome dos arquivos de entrada e saída
     char input_filename[100], output_filename[100];
     sprintf(input_filename, "matrix_%d.bin", n);
-    sprintf(output_filename, "inverse_matrix_%d_omp_%d.bin", n, num_threads);
+    sprintf(output_filename, "inverse_matrix_%d_%s_%d.bin", n, method_tag, num_threads);
+    
+    // Entrada e saída são mapeadas em memória (formato de Comum/matrix_file.h)
+    matrix_map_t in_map, out_map;
     
     // Verifica se o arquivo de entrada existe, se não, gera e salva uma matriz
     FILE *test_file = fopen(input_filename, "rb");
     if (test_file == NULL) {
         printf("Arquivo de matriz de entrada não encontrado. Gerando nova matriz %dx%d...\n", n, n);
         
-        // Configura a semente para números aleatórios
-        srand(time(NULL));
-        
-        // Gera uma matriz inversível aleatória
-        generate_invertible_matrix(A, n);
-        
-        // Salva a matriz no arquivo
-        save_matrix_to_file(A, n, input_filename);
+        // Gera uma matriz inversível aleatória diretamente no arquivo
+        double *M = matrix_file_create(input_filename, n, MATRIX_ROW_MAJOR, &in_map);
+        invmat_generate(M, n, (unsigned int)time(NULL));
+        matrix_file_close(&in_map);
         printf("Matriz salva em %s\n", input_filename);
     } else {
         fclose(test_file);
         printf("Carregando matriz %dx%d do arquivo %s\n", n, n, input_filename);
-        load_matrix_from_file(A, n, input_filename);
     }
     
+    double map_start = get_time();
+    double *A = matrix_file_open(input_filename, n, &in_map);
+    double map_time = get_time() - map_start;
+    
+    if (in_map.n != n) {
+        fprintf(stderr, "Erro: %s contém uma matriz %dx%d\n", input_filename, in_map.n, in_map.n);
+        matrix_file_close(&in_map);
+        return EXIT_FAILURE;
+    }
+    printf("Formato do arquivo: %s (mapeado e verificado em %.3f s)\n",
+           matrix_file_format_name(&in_map), map_time);
+    
+    // Inversa anterior usada como ponto de partida (método 7), na mesma ordem
+    matrix_map_t guess_map;
+    double *guess = NULL;
+    if (method == 7) {
+        guess = matrix_file_open(guess_filename, n, &guess_map);
+        if (guess_map.n != n || guess_map.layout != in_map.layout) {
+            fprintf(stderr, "Erro: %s não é uma matriz %dx%d na mesma ordem da entrada\n", guess_filename, n, n);
+            return EXIT_FAILURE;
+        }
+        printf("Ponto de partida: %s (%s)\n", guess_filename, matrix_file_format_name(&guess_map));
+    }
+    
+    // A inversa é escrita diretamente no arquivo de saída mapeado, na mesma
+    // ordem da entrada (uma matriz por colunas é A^T, e inv(A^T) = inv(A)^T)
+    double *Ainv = matrix_file_create(output_filename, n, in_map.layout, &out_map);
+    if (in_place) {
+        // Cópia por primeiro toque, com o mesmo schedule(static) da eliminação
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++) {
+            memcpy(Ainv + (size_t)i*n, A + (size_t)i*n, n*sizeof(double));
+        }
+    }
+    
+    // Seleciona os kernels SIMD de acordo com a CPU (ou IM_ISA)
+    simd_init();
+    printf("Kernels SIMD: %s\n", simd_isa_name());
+    
     // Mede o tempo de execução
     double start_time = get_time();
     
-    // Calcula a matriz inversa usando o método paralelo
-    printf("Calculando inversa (paralela com OpenMP, %d threads)...\n", num_threads);
-    calculate_inverse_row_oriented_parallel(A, Ainv, n, num_threads);
+    // Calcula a matriz inversa usando o método paralelo escolhido
+    if (method == 1) {
+        printf("Calculando inversa (paralela com OpenMP, %d threads)...\n", num_threads);
+        calculate_inverse_row_oriented_parallel(A, Ainv, n, num_threads);
+    } else if (method == 2) {
+        printf("Calculando inversa (fatoração LU paralela com OpenMP, %d threads)...\n", num_threads);
+        calculate_inverse_lu_parallel(A, Ainv, n, num_threads);
+    } else if (method == 3) {
+        printf("Calculando inversa (região paralela persistente com OpenMP, %d threads)...\n", num_threads);
+        calculate_inverse_persistent_parallel(A, Ainv, n, num_threads);
+    } else if (method == 4) {
+        printf("Calculando inversa (tiles de %d colunas, lookahead %d, %d threads)...\n", tile, lookahead, num_threads);
+        calculate_inverse_tiled_parallel(A, Ainv, n, num_threads, tile, lookahead);
+    } else if (method == 5) {
+        printf("Calculando inversa (in-place com OpenMP, %d threads)...\n", num_threads);
+        calculate_inverse_in_place_parallel(Ainv, n, num_threads);
+    } else if (method == 6) {
+        printf("Calculando inversa (precisão mista float/double com OpenMP, %d threads)...\n", num_threads);
+        calculate_inverse_mixed_parallel(A, Ainv, n, num_threads);
+    } else {
+        printf("Calculando inversa (Newton-Schulz a partir da inversa anterior, %d threads)...\n", num_threads);
+        calculate_inverse_newton_schulz_parallel(A, Ainv, guess, n, num_threads);
+    }
     
     double end_time = get_time();
     double execution_time = end_time - start_time;
     
-    // Valida a matriz inversa calculada
-    if (validate_inverse(A, Ainv, n)) {
-        printf("Validação da matriz inversa: SUCESSO\n");
+    // Método 4: o mesmo escalonamento com 1 thread, fora da medição, dá T1
+    // para a eficiência paralela T1 / (p * Tp)
+    double tiled_reference_time = 0.0;
+    if (method == 4 && num_threads > 1) {
+        invmat_tiled_stats_t stats = tiled_stats;
+        invmat_context_t *reference_context;
+        invmat_check(invmat_context_create(INVMAT_BACKEND_OPENMP, 1, &reference_context));
+        double *reference = (double*)malloc(n*n*sizeof(double));
+        if (reference == NULL) {
+            fprintf(stderr, "Erro: Falha na alocação de memória\n");
+            exit(EXIT_FAILURE);
+        }
+        printf("Referência com 1 thread para a eficiência paralela...\n");
+        double reference_start = get_time();
+        invmat_check(invmat_invert_tiled(reference_context, A, reference, n, tile, lookahead, NULL));
+        tiled_reference_time = get_time() - reference_start;
+        free(reference);
+        invmat_context_destroy(reference_context);
+        tiled_stats = stats;
+    }
+    
+    // Método 4 com --tarefas: cada faixa atualizada pelo DAG é comparada com o
+    // estado do método por linhas ao fim do mesmo painel (fora da medição)
+    if (method == 4 && check_tasks) {
+        double task_error;
+        invmat_check(invmat_check_tiled(shared_context(num_threads), A, n, tile, lookahead, &task_error));
+        printf("Conferência das tarefas do DAG com o método por linhas: %s, maior diferença relativa %.3e\n",
+               task_error < TASK_CHECK_TOLERANCE ? "SUCESSO" : "FALHA", task_error);
+    }
+    
+    // Localidade e banda por socket nos métodos com blocos de linhas por thread
+    if ((method == 1 || method == 3 || method == 5) && n > FIXED_SIZE_MAX) {
+        report_numa(&topo, Ainv, n, num_threads, in_place ? 1 : 2, execution_time, measure_bandwidth);
+    }
+    
+    // Valida a matriz inversa calculada: por padrão com o teste de Freivalds
+    // (O(n^2)); com --exato, forma A * A^-1 (no modo in-place, sem buffer n^2)
+    double validation_start = get_time();
+    if (exact_validation) {
+        int valid = in_place ? validate_inverse_by_rows(A, Ainv, n)
+                             : validate_inverse(A, Ainv, n);
+        if (valid) {
+            printf("Validação da matriz inversa (exata): SUCESSO");
+        } else {
+            printf("Validação da matriz inversa (exata): FALHA");
+        }
     } else {
-        printf("Validação da matriz inversa: FALHA\n");
+        double residual = validate_inverse_freivalds(A, Ainv, n, probes);
+        if (residual < 1e-6) {
+            printf("Validação da matriz inversa (Freivalds, %d sondas): SUCESSO, resíduo ||A*(A^-1*x) - x||_inf = %.3e", probes, residual);
+        } else {
+            printf("Validação da matriz inversa (Freivalds, %d sondas): FALHA, resíduo ||A*(A^-1*x) - x||_inf = %.3e", probes, residual);
+        }
     }
+    printf(" (%.3f s)\n", get_time() - validation_start);
     
-    // Salva a matriz inversa em um arquivo
-    save_matrix_to_file(Ainv, n, output_filename);
-    printf("Matriz inversa salva em %s\n", output_filename);
+    // Execuções repetidas com um contexto por chamada e com o plano reutilizável
+    if (plan_reps > 0) {
+        report_plan(A, Ainv, n, num_threads, plan_reps);
+    }
+    
+    // Fecha a saída (grava o checksum); as páginas já estão no arquivo
+    double store_start = get_time();
+    matrix_file_close(&out_map);
+    matrix_file_close(&in_map);
+    if (method == 7) {
+        matrix_file_close(&guess_map);
+    }
+    printf("Matriz inversa salva em %s (%.3f s)\n", output_filename, get_time() - store_start);
     
     // Grava os resultados em um arquivo CSV para análise de escalabilidade
     char results_filename[100];
-    sprintf(results_filename, "results_omp.csv");
+    sprintf(results_filename, "results_%s.csv", method_tag);
     
     FILE *results_file = fopen(results_filename, "a");
     if (results_file == NULL) {
@@ -306,11 +613,36 @@ int main(int argc, char *argv[]) {
     
     printf("Tamanho da matriz: %d x %d\n", n, n);
     printf("Número de threads: %d\n", num_threads);
+    if (method == 4) {
+        // Fração do tempo em que as threads executaram tarefas (o resto é
+        // espera por dependências ou pelo lock do escalonador)
+        printf("Utilização das threads: %.1f%% (tempo em tarefas / (threads x tempo total))\n",
+               100.0 * tiled_stats.busy_time / (num_threads * tiled_stats.wall_time));
+        if (num_threads > 1) {
+            printf("Eficiência paralela: %.1f%% (T1 = %.6f s / (%d threads x Tp = %.6f s))\n",
+                   100.0 * tiled_reference_time / (num_threads * execution_time),
+                   tiled_reference_time, num_threads, execution_time);
+        }
+    }
+    if (method == 6 || method == 7) {
+        // Convergência: resíduo antes de cada iteração de Newton-Schulz
+        for (int i = 0; i < ns_info.history_len; i++) {
+            printf("Iteração %d: ||I - A*X||_inf = %.3e\n", i, ns_info.history[i]);
+        }
+        if (ns_info.fallback) {
+            printf("Inversa recalculada por Gauss-Jordan após %d iterações de Newton-Schulz: %s\n", ns_info.iterations,
+                   invmat_fallback_reason(ns_info.reason));
+        } else {
+            printf("Iterações de Newton-Schulz: %d (%d produtos de matrizes)\n", ns_info.iterations, 2*ns_info.iterations + 1);
+        }
+        if (method == 6) {
+            printf("Estimativa de condicionamento pelos pivôs em float (max|A| / min|pivô|): %.3e\n", ns_info.condition_estimate);
+        }
+        printf("Resíduo final ||A*Ainv - I||_inf: %.3e\n", ns_info.residual);
+    }
     printf("Tempo de execução: %.6f segundos\n", execution_time);
     
-    // Libera a memória
-    free(A);
-    free(Ainv);
-    
+    invmat_context_destroy(openmp_context);
+    topology_free(&topo);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
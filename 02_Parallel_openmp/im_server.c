@@ -0,0 +1,706 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <omp.h>  // Inclusão da biblioteca OpenMP
+
+#include "simd_kernels.h"
+#include "fixed_size_kernels.h"
+#include "matrix_file.h"
+#include "arena.h"
+#include "invmat.h"
+#include "service_protocol.h"
+
+// Até este n, as requisições são invertidas em lote, uma por thread ou em
+// grupos de BATCH_LANES matrizes de mesmo tamanho; acima, uma por vez com
+// todas as threads
+#define DEFAULT_SMALL_N 128
+
+// Maior número de requisições de um lote e espera máxima por mais
+// requisições quando o lote ainda não ocupa todas as threads
+#define DEFAULT_BATCH_MAX 64
+#define DEFAULT_BATCH_WAIT_US 200
+#define BATCH_LIMIT 4096
+
+// Maior --pequena aceito (cada thread guarda um grupo de BATCH_LANES
+// matrizes desse tamanho, duas vezes)
+#define SMALL_N_LIMIT 256
+
+// Matrizes de um grupo intercaladas, como em im_batch.c
+#define BATCH_LANES INVMAT_BATCH_LANES
+
+// Função para medir o tempo em segundos
+double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Requisição em andamento. Cada conexão tem a sua, reaproveitada entre as
+// requisições da conexão (os buffers só crescem)
+typedef struct job {
+    double *A;              // n x n (A^T se a requisição é por colunas)
+    double *Ainv;
+    void *raw;              // dados recebidos em float32
+    size_t capacity;        // doubles alocados em A e Ainv
+    size_t raw_capacity;
+    int n;
+    int status;             // SERVICE_*
+    int done;
+    unsigned batch_size;
+    double arrival;         // requisição recebida por inteiro
+    double start;           // início da inversão
+    double finish;
+    pthread_cond_t cond;    // sinalizada quando done = 1
+    struct job *next;
+} job_t;
+
+// Fila de requisições, consumida pela thread principal (dona do pool OpenMP)
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static job_t *queue_head = NULL;
+static job_t *queue_tail = NULL;
+
+// Estatísticas do servidor (tempo no servidor de cada requisição)
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static double *latencies = NULL;
+static long latency_count = 0;
+static long latency_capacity = 0;
+static long failed_requests = 0;
+static long batches = 0;
+static long batched_requests = 0;
+
+static volatile sig_atomic_t stop = 0;
+
+static int num_threads;
+static int small_n = DEFAULT_SMALL_N;
+static int batch_max = DEFAULT_BATCH_MAX;
+static int batch_wait_us = DEFAULT_BATCH_WAIT_US;
+
+// Buffers de trabalho mantidos entre requisições: W e V de um grupo por
+// thread (lotes) e temp_A das matrizes grandes, que cresce com o maior n visto
+static arena_t small_arena;
+static double **group_W;
+static double **group_V;
+static arena_t large_arena;
+static double *large_temp_A = NULL;
+static int large_capacity_n = 0;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+// Lê exatamente bytes bytes; retorna 0 no fim da conexão ou em erro
+static int read_full(int fd, void *buffer, size_t bytes) {
+    char *p = (char*)buffer;
+    while (bytes > 0) {
+        ssize_t r = read(fd, p, bytes);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            return 0;
+        }
+        p += r;
+        bytes -= r;
+    }
+    return 1;
+}
+
+static int write_full(int fd, const void *buffer, size_t bytes) {
+    const char *p = (const char*)buffer;
+    while (bytes > 0) {
+        ssize_t w = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w <= 0) {
+            return 0;
+        }
+        p += w;
+        bytes -= w;
+    }
+    return 1;
+}
+
+// Status do serviço para um status da libinvmat
+static int service_status(invmat_status_t status) {
+    return (status == INVMAT_OK) ? SERVICE_OK : SERVICE_SINGULAR;
+}
+
+// Gauss-Jordan orientado a linhas com temp_A fornecido (kernels de tamanho
+// fixo até FIXED_SIZE_MAX, senão invmat_gauss_jordan_serial), retornando
+// SERVICE_SINGULAR em vez de terminar o programa
+static int invert_serial(const double *A, double *Ainv, double *temp_A, int n) {
+    int fixed = invert_fixed_size(A, Ainv, n);
+    if (fixed >= 0) {
+        return fixed ? SERVICE_OK : SERVICE_SINGULAR;
+    }
+    return service_status(invmat_gauss_jordan_serial(A, Ainv, temp_A, n));
+}
+
+// Gauss-Jordan paralelo orientado a linhas (método 1 de im_parallel.c,
+// invmat_gauss_jordan_openmp), com todas as threads do pool sobre uma matriz
+static int invert_parallel(const double *A, double *Ainv, double *temp_A, int n) {
+    return service_status(invmat_gauss_jordan_openmp(A, Ainv, temp_A, n, num_threads));
+}
+
+// Inverte as matrizes jobs[0..count-1] de mesmo tamanho n com o grupo
+// intercalado da thread (count <= BATCH_LANES, invmat_invert_lanes)
+static void invert_lanes(job_t **jobs, int count, int n, double *W, double *V) {
+    const double *A[BATCH_LANES];
+    double *Ainv[BATCH_LANES];
+    int ok[BATCH_LANES];
+    for (int l = 0; l < count; l++) {
+        A[l] = jobs[l]->A;
+        Ainv[l] = jobs[l]->Ainv;
+    }
+
+    invmat_invert_lanes(A, Ainv, ok, count, n, W, V);
+
+    for (int l = 0; l < count; l++) {
+        jobs[l]->status = ok[l] ? SERVICE_OK : SERVICE_SINGULAR;
+    }
+}
+
+static int compare_job_size(const void *a, const void *b) {
+    int na = (*(job_t * const *)a)->n;
+    int nb = (*(job_t * const *)b)->n;
+    return (na > nb) - (na < nb);
+}
+
+// Inverte um lote de requisições pequenas. As de mesmo n são agrupadas de
+// BATCH_LANES em BATCH_LANES (uma pista SIMD por matriz); as que sobram
+// sozinhas usam o Gauss-Jordan serial. Os grupos são distribuídos entre as
+// threads do pool, cada uma com os seus buffers W e V
+static void invert_batch(job_t **jobs, int count) {
+    qsort(jobs, count, sizeof(job_t*), compare_job_size);
+
+    // Tarefas: trechos de jobs com o mesmo n e até BATCH_LANES requisições
+    int task_begin[BATCH_LIMIT];
+    int task_count[BATCH_LIMIT];
+    int tasks = 0;
+    for (int b = 0; b < count; ) {
+        int e = b + 1;
+        while (e < count && e - b < BATCH_LANES && jobs[e]->n == jobs[b]->n) {
+            e++;
+        }
+        task_begin[tasks] = b;
+        task_count[tasks] = e - b;
+        tasks++;
+        b = e;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < tasks; t++) {
+        int tid = omp_get_thread_num();
+        job_t **group = jobs + task_begin[t];
+        int lanes = task_count[t];
+        int n = group[0]->n;
+
+        double start = get_time();
+        if (lanes == 1 || n <= FIXED_SIZE_MAX) {
+            // Sem outra matriz do mesmo tamanho (ou com kernel de tamanho
+            // fixo), o grupo intercalado só desperdiçaria pistas
+            for (int l = 0; l < lanes; l++) {
+                group[l]->start = get_time();
+                group[l]->status = invert_serial(group[l]->A, group[l]->Ainv, group_W[tid], n);
+                group[l]->finish = get_time();
+            }
+        } else {
+            invert_lanes(group, lanes, n, group_W[tid], group_V[tid]);
+            double finish = get_time();
+            for (int l = 0; l < lanes; l++) {
+                group[l]->start = start;
+                group[l]->finish = finish;
+            }
+        }
+    }
+}
+
+// Garante temp_A para uma matriz grande n x n. A arena é recriada (e tocada
+// com a partição schedule(static) da eliminação) só quando n passa do maior
+// já visto. Retorna 0 se a nova arena não puder ser reservada; a anterior
+// continua valendo para as próximas requisições
+static int ensure_large_scratch(int n) {
+    if (n <= large_capacity_n) {
+        return 1;
+    }
+    arena_t arena;
+    if (!arena_try_create(&arena, (size_t)n*n*sizeof(double))) {
+        return 0;
+    }
+    arena_destroy(&large_arena);
+    large_arena = arena;
+    large_temp_A = (double*)arena_alloc(&large_arena, (size_t)n*n*sizeof(double));
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        memset(large_temp_A + (size_t)i*n, 0, n*sizeof(double));
+    }
+    large_capacity_n = n;
+    return 1;
+}
+
+// Marca as requisições como concluídas e acorda as conexões
+static void complete_jobs(job_t **jobs, int count) {
+    pthread_mutex_lock(&queue_lock);
+    for (int b = 0; b < count; b++) {
+        jobs[b]->batch_size = count;
+        jobs[b]->done = 1;
+        pthread_cond_signal(&jobs[b]->cond);
+    }
+    pthread_mutex_unlock(&queue_lock);
+}
+
+// Laço da thread principal: retira requisições da fila e as inverte com o
+// pool OpenMP, que fica ativo entre as requisições
+static void dispatch_loop(void) {
+    job_t *jobs[BATCH_LIMIT];
+
+    while (!stop) {
+        pthread_mutex_lock(&queue_lock);
+        while (queue_head == NULL && !stop) {
+            // Espera com prazo para perceber o sinal de término
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 100000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&queue_cond, &queue_lock, &deadline);
+        }
+        if (stop) {
+            pthread_mutex_unlock(&queue_lock);
+            break;
+        }
+
+        int count = 0;
+        if (queue_head->n > small_n) {
+            // Matriz grande: sozinha, com todas as threads
+            jobs[count++] = queue_head;
+            queue_head = queue_head->next;
+        } else {
+            // Se as requisições pequenas da fila ainda não ocupam as threads,
+            // espera um pouco por outras para formar um lote maior
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += (long)batch_wait_us * 1000;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000;
+            deadline.tv_nsec %= 1000000000;
+            for (;;) {
+                int small = 0;
+                for (job_t *j = queue_head; j != NULL && j->n <= small_n && small < batch_max; j = j->next) {
+                    small++;
+                }
+                if (small >= num_threads * BATCH_LANES || small >= batch_max || batch_wait_us == 0 || stop) {
+                    break;
+                }
+                if (pthread_cond_timedwait(&queue_cond, &queue_lock, &deadline) == ETIMEDOUT) {
+                    break;
+                }
+            }
+            while (queue_head != NULL && queue_head->n <= small_n && count < batch_max) {
+                jobs[count++] = queue_head;
+                queue_head = queue_head->next;
+            }
+        }
+        if (queue_head == NULL) {
+            queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&queue_lock);
+
+        if (jobs[0]->n > small_n) {
+            job_t *job = jobs[0];
+            job->start = get_time();
+            if (ensure_large_scratch(job->n)) {
+                job->status = invert_parallel(job->A, job->Ainv, large_temp_A, job->n);
+            } else {
+                job->status = SERVICE_NO_MEMORY;
+            }
+            job->finish = get_time();
+        } else {
+            invert_batch(jobs, count);
+            pthread_mutex_lock(&stats_lock);
+            batches++;
+            batched_requests += count;
+            pthread_mutex_unlock(&stats_lock);
+        }
+        complete_jobs(jobs, count);
+    }
+}
+
+// Garante os buffers da requisição de uma conexão para uma matriz n x n
+static int ensure_job_buffers(job_t *job, int n, size_t raw_bytes) {
+    size_t elems = (size_t)n*n;
+    if (elems > job->capacity) {
+        free(job->A);
+        free(job->Ainv);
+        job->A = (double*)aligned_alloc(64, (elems*sizeof(double) + 63) & ~(size_t)63);
+        job->Ainv = (double*)aligned_alloc(64, (elems*sizeof(double) + 63) & ~(size_t)63);
+        job->capacity = (job->A != NULL && job->Ainv != NULL) ? elems : 0;
+        if (job->capacity == 0) {
+            return 0;
+        }
+    }
+    if (raw_bytes > job->raw_capacity) {
+        free(job->raw);
+        job->raw = malloc(raw_bytes);
+        job->raw_capacity = (job->raw != NULL) ? raw_bytes : 0;
+        if (job->raw == NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void record_latency(double seconds, int status) {
+    pthread_mutex_lock(&stats_lock);
+    if (latency_count == latency_capacity) {
+        long capacity = latency_capacity ? 2*latency_capacity : 4096;
+        double *grown = (double*)realloc(latencies, capacity*sizeof(double));
+        if (grown != NULL) {
+            latencies = grown;
+            latency_capacity = capacity;
+        }
+    }
+    if (latency_count < latency_capacity) {
+        latencies[latency_count++] = seconds;
+    }
+    if (status != SERVICE_OK) {
+        failed_requests++;
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Envia a resposta de uma requisição; com SERVICE_OK, também a inversa
+static int send_response(int fd, job_t *job, int layout) {
+    service_response_t response;
+    memset(&response, 0, sizeof(response));
+    memcpy(response.magic, SERVICE_RESPONSE_MAGIC, 8);
+    response.status = job->status;
+    response.batch_size = job->batch_size;
+    response.queue_seconds = job->start - job->arrival;
+    response.compute_seconds = job->finish - job->start;
+    response.server_seconds = get_time() - job->arrival;
+
+    if (!write_full(fd, &response, sizeof(response))) {
+        return 0;
+    }
+    if (job->status != SERVICE_OK) {
+        return 1;
+    }
+
+    size_t data_bytes = (size_t)job->n*job->n*sizeof(double);
+    matrix_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MATRIX_FILE_MAGIC, 8);
+    header.version = MATRIX_FILE_VERSION;
+    header.elem_type = MATRIX_ELEM_F64;
+    header.layout = layout;
+    header.data_offset = sizeof(header);
+    header.n = job->n;
+    header.checksum = matrix_checksum(job->Ainv, data_bytes);
+    return write_full(fd, &header, sizeof(header)) && write_full(fd, job->Ainv, data_bytes);
+}
+
+// Resposta de erro sem inversa, para requisições que não chegam à fila
+static void send_error(int fd, job_t *job, int status) {
+    job->status = status;
+    job->batch_size = 0;
+    job->arrival = job->start = job->finish = get_time();
+    send_response(fd, job, MATRIX_ROW_MAJOR);
+    record_latency(0.0, status);
+}
+
+// Thread de uma conexão: lê as requisições, põe cada uma na fila, espera a
+// inversão e devolve a resposta
+static void *connection_thread(void *arg) {
+    int fd = (int)(long)arg;
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    pthread_cond_init(&job.cond, NULL);
+
+    matrix_file_header_t header;
+    while (read_full(fd, &header, sizeof(header))) {
+        // Cabeçalho no formato de Comum/matrix_file.h; com um cabeçalho
+        // inválido não há como achar a próxima matriz, então a conexão fecha
+        if (memcmp(header.magic, MATRIX_FILE_MAGIC, 8) != 0 || header.version != MATRIX_FILE_VERSION ||
+            (header.elem_type != MATRIX_ELEM_F64 && header.elem_type != MATRIX_ELEM_F32) ||
+            (header.layout != MATRIX_ROW_MAJOR && header.layout != MATRIX_COL_MAJOR) ||
+            header.n == 0 || header.n > SERVICE_MAX_N ||
+            header.data_offset < sizeof(header) || header.data_offset > MATRIX_FILE_DATA_OFFSET) {
+            send_error(fd, &job, SERVICE_BAD_HEADER);
+            break;
+        }
+
+        // Preenchimento entre o cabeçalho e os dados (um .bin enviado inteiro)
+        char padding[MATRIX_FILE_DATA_OFFSET];
+        if (!read_full(fd, padding, header.data_offset - sizeof(header))) {
+            break;
+        }
+
+        int n = (int)header.n;
+        size_t elem_size = (header.elem_type == MATRIX_ELEM_F64) ? sizeof(double) : sizeof(float);
+        size_t data_bytes = (size_t)n*n*elem_size;
+        if (!ensure_job_buffers(&job, n, header.elem_type == MATRIX_ELEM_F32 ? data_bytes : 0)) {
+            send_error(fd, &job, SERVICE_NO_MEMORY);
+            break;
+        }
+
+        // float64 vai direto para A; float32 é convertido (a inversão é em double)
+        void *target = (header.elem_type == MATRIX_ELEM_F64) ? (void*)job.A : job.raw;
+        if (!read_full(fd, target, data_bytes)) {
+            break;
+        }
+        if (matrix_checksum(target, data_bytes) != header.checksum) {
+            send_error(fd, &job, SERVICE_BAD_CHECKSUM);
+            continue;
+        }
+        if (header.elem_type == MATRIX_ELEM_F32) {
+            const float *src = (const float*)job.raw;
+            for (size_t i = 0; i < (size_t)n*n; i++) {
+                job.A[i] = src[i];
+            }
+        }
+
+        // Uma matriz por colunas é A^T, e inv(A^T) = inv(A)^T: a inversa
+        // calculada já está na ordem da requisição
+        job.n = n;
+        job.done = 0;
+        job.next = NULL;
+        job.arrival = get_time();
+
+        pthread_mutex_lock(&queue_lock);
+        if (queue_tail != NULL) {
+            queue_tail->next = &job;
+        } else {
+            queue_head = &job;
+        }
+        queue_tail = &job;
+        pthread_cond_signal(&queue_cond);
+        while (!job.done) {
+            pthread_cond_wait(&job.cond, &queue_lock);
+        }
+        pthread_mutex_unlock(&queue_lock);
+
+        int sent = send_response(fd, &job, (int)header.layout);
+        record_latency(get_time() - job.arrival, job.status);
+        if (!sent) {
+            break;
+        }
+    }
+
+    close(fd);
+    pthread_cond_destroy(&job.cond);
+    free(job.A);
+    free(job.Ainv);
+    free(job.raw);
+    return NULL;
+}
+
+// Aceita conexões e cria uma thread leve para cada uma (as inversões ficam
+// com o pool OpenMP da thread principal)
+static void *accept_thread(void *arg) {
+    int listen_fd = (int)(long)arg;
+    for (;;) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            fprintf(stderr, "Erro ao aceitar conexão: %s\n", strerror(errno));
+            stop = 1;
+            return NULL;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, connection_thread, (void*)(long)fd) != 0) {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil p (0..100) de valores ordenados
+static double percentile(const double *sorted, long count, double p) {
+    long index = (long)ceil(p / 100.0 * count) - 1;
+    if (index < 0) {
+        index = 0;
+    }
+    return sorted[index];
+}
+
+// Resumo impresso ao encerrar o servidor
+static void print_summary(double uptime) {
+    pthread_mutex_lock(&stats_lock);
+    printf("\nRequisições atendidas: %ld (%ld com erro) em %.1f s\n", latency_count, failed_requests, uptime);
+    if (batches > 0) {
+        printf("Lotes: %ld, %.1f requisições por lote em média\n", batches, (double)batched_requests / batches);
+    }
+    if (latency_count > 0) {
+        qsort(latencies, latency_count, sizeof(double), compare_double);
+        printf("Tempo no servidor: p50 %.3f ms, p99 %.3f ms, máximo %.3f ms\n",
+               1e3 * percentile(latencies, latency_count, 50.0),
+               1e3 * percentile(latencies, latency_count, 99.0),
+               1e3 * latencies[latency_count - 1]);
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+// Retira de argv as opções, aceitas em qualquer posição:
+//   --pequena=N  maior n invertido em lote (padrão DEFAULT_SMALL_N)
+//   --lote=B     máximo de requisições por lote (padrão DEFAULT_BATCH_MAX)
+//   --espera=U   espera máxima, em microssegundos, por mais requisições de um lote
+void parse_options(int *argc, char *argv[]) {
+    int kept = 1;
+    for (int a = 1; a < *argc; a++) {
+        if (strncmp(argv[a], "--pequena=", 10) == 0) {
+            small_n = atoi(argv[a] + 10);
+        } else if (strncmp(argv[a], "--lote=", 7) == 0) {
+            batch_max = atoi(argv[a] + 7);
+            if (batch_max <= 0 || batch_max > BATCH_LIMIT) {
+                fprintf(stderr, "Erro: O tamanho máximo do lote deve estar entre 1 e %d\n", BATCH_LIMIT);
+                exit(EXIT_FAILURE);
+            }
+        } else if (strncmp(argv[a], "--espera=", 9) == 0) {
+            batch_wait_us = atoi(argv[a] + 9);
+            if (batch_wait_us < 0) {
+                fprintf(stderr, "Erro: A espera do lote não pode ser negativa\n");
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            argv[kept++] = argv[a];
+        }
+    }
+    *argc = kept;
+    argv[kept] = NULL;
+}
+
+int main(int argc, char *argv[]) {
+    parse_options(&argc, argv);
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Uso: %s <num_threads> [socket] [--pequena=N] [--lote=B] [--espera=U]\n", argv[0]);
+        fprintf(stderr, "socket: caminho do socket Unix (padrão %s)\n", SERVICE_DEFAULT_SOCKET);
+        fprintf(stderr, "--pequena=N: matrizes até N x N são invertidas em lote (padrão %d)\n", DEFAULT_SMALL_N);
+        fprintf(stderr, "--lote=B: máximo de requisições por lote (padrão %d)\n", DEFAULT_BATCH_MAX);
+        fprintf(stderr, "--espera=U: espera máxima por mais requisições de um lote, em microssegundos (padrão %d)\n", DEFAULT_BATCH_WAIT_US);
+        return EXIT_FAILURE;
+    }
+
+    num_threads = atoi(argv[1]);
+    const char *socket_path = (argc == 3) ? argv[2] : SERVICE_DEFAULT_SOCKET;
+
+    if (num_threads <= 0) {
+        fprintf(stderr, "Erro: O número de threads deve ser positivo\n");
+        return EXIT_FAILURE;
+    }
+
+    if (small_n < 0 || small_n > SMALL_N_LIMIT) {
+        fprintf(stderr, "Erro: O tamanho das matrizes em lote deve estar entre 0 e %d\n", SMALL_N_LIMIT);
+        return EXIT_FAILURE;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Erro: O caminho do socket é longo demais\n");
+        return EXIT_FAILURE;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    // Seleciona os kernels SIMD de acordo com a CPU (ou IM_ISA)
+    simd_init();
+    printf("Kernels SIMD: %s\n", simd_isa_name());
+
+    // Pool OpenMP e buffers dos lotes criados antes da primeira requisição:
+    // cada thread toca o seu W e V (primeiro toque), e o pool segue ativo
+    omp_set_num_threads(num_threads);
+    size_t group_bytes = (size_t)small_n*small_n*BATCH_LANES*sizeof(double);
+    arena_create(&small_arena, 2*num_threads*(group_bytes + ARENA_ALIGN));
+    group_W = (double**)malloc(num_threads*sizeof(double*));
+    group_V = (double**)malloc(num_threads*sizeof(double*));
+    if (group_W == NULL || group_V == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        return EXIT_FAILURE;
+    }
+    for (int t = 0; t < num_threads; t++) {
+        group_W[t] = (double*)arena_alloc(&small_arena, group_bytes);
+        group_V[t] = (double*)arena_alloc(&small_arena, group_bytes);
+    }
+    #pragma omp parallel
+    {
+        int tid = omp_get_thread_num();
+        memset(group_W[tid], 0, group_bytes);
+        memset(group_V[tid], 0, group_bytes);
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        fprintf(stderr, "Erro ao criar o socket: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    // Remove um socket deixado por uma execução anterior
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listen_fd, 128) != 0) {
+        fprintf(stderr, "Erro ao escutar em %s: %s\n", socket_path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    // SIGINT/SIGTERM encerram o laço e imprimem o resumo (sem SA_RESTART,
+    // para que as esperas sejam interrompidas)
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    // As demais threads não recebem os sinais
+    sigset_t signals, previous;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+    pthread_t acceptor;
+    if (pthread_create(&acceptor, NULL, accept_thread, (void*)(long)listen_fd) != 0) {
+        fprintf(stderr, "Erro ao criar a thread de conexões\n");
+        return EXIT_FAILURE;
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    printf("Servidor de inversão em %s (%d threads, lotes de até %d matrizes até %dx%d, espera de %d us)\n",
+           socket_path, num_threads, batch_max, small_n, small_n, batch_wait_us);
+    printf("Arena dos lotes: %.1f MB, %s\n", small_arena.size / 1048576.0, arena_backing_name(&small_arena));
+    fflush(stdout);
+
+    double start_time = get_time();
+    dispatch_loop();
+
+    print_summary(get_time() - start_time);
+    close(listen_fd);
+    unlink(socket_path);
+    arena_destroy(&small_arena);
+    arena_destroy(&large_arena);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,322 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>  // Inclusão da biblioteca OpenMP
+
+#include "simd_kernels.h"
+#include "matrix_file.h"
+#include "woodbury.h"
+#include "invmat.h"
+
+/*
+ * im_update.c - Atualiza uma inversa já calculada quando poucas linhas e/ou
+ * colunas da matriz mudam. A diferença entre a matriz antiga e a nova é
+ * escrita como U*Vt de posto k e a inversa nova sai da fórmula de
+ * Sherman-Morrison-Woodbury em O(n^2 k), em vez dos O(n^3) da inversão
+ * completa. Se a matriz de capacitância for mal condicionada, nenhuma saída é
+ * gravada e a inversão completa é recomendada.
+ */
+
+// A partir de k = n/UPDATE_RANK_NOTE a inversão completa tende a ser mais barata
+#define UPDATE_RANK_NOTE 4
+
+// Número de vetores do teste de Freivalds
+#define VALIDATION_PROBES 3
+
+// Função para medir o tempo de execução
+double get_time() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Decomposição da diferença: linhas atualizadas inteiras (u = e_i, v = linha
+// da diferença) e colunas atualizadas inteiras (u = coluna da diferença,
+// v = e_j). Uma entrada alterada só precisa estar coberta por uma delas
+typedef struct {
+    int *rows;
+    int num_rows;
+    int *cols;
+    int num_cols;
+} update_plan_t;
+
+// Escolhe a cobertura de menor posto entre: só linhas, só colunas, ou as
+// linhas com duas ou mais entradas alteradas mais as colunas das entradas
+// restantes (uma por linha)
+void plan_update(const double *A_old, const double *A_new, int n, update_plan_t *plan) {
+    int *row_changes = (int*)calloc(n, sizeof(int));
+    int *col_changed = (int*)calloc(n, sizeof(int));
+    int *mixed_col = (int*)calloc(n, sizeof(int));
+    plan->rows = (int*)malloc(n*sizeof(int));
+    plan->cols = (int*)malloc(n*sizeof(int));
+
+    if (row_changes == NULL || col_changed == NULL || mixed_col == NULL ||
+        plan->rows == NULL || plan->cols == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Contagem por linha (paralela) e marcação das colunas alteradas
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        int count = 0;
+        for (int j = 0; j < n; j++) {
+            if (A_new[(size_t)i*n + j] != A_old[(size_t)i*n + j]) {
+                count++;
+                #pragma omp atomic write
+                col_changed[j] = 1;
+            }
+        }
+        row_changes[i] = count;
+    }
+
+    int rows_only = 0, cols_only = 0, mixed_rows = 0;
+    for (int i = 0; i < n; i++) {
+        if (row_changes[i] > 0) {
+            rows_only++;
+        }
+        if (row_changes[i] > 1) {
+            mixed_rows++;
+        }
+        cols_only += col_changed[i];
+    }
+
+    // Colunas necessárias para as linhas com uma única entrada alterada
+    for (int i = 0; i < n; i++) {
+        if (row_changes[i] == 1) {
+            for (int j = 0; j < n; j++) {
+                if (A_new[(size_t)i*n + j] != A_old[(size_t)i*n + j]) {
+                    mixed_col[j] = 1;
+                    break;
+                }
+            }
+        }
+    }
+    int mixed_cols = 0;
+    for (int j = 0; j < n; j++) {
+        mixed_cols += mixed_col[j];
+    }
+
+    plan->num_rows = 0;
+    plan->num_cols = 0;
+    if (rows_only <= cols_only && rows_only <= mixed_rows + mixed_cols) {
+        for (int i = 0; i < n; i++) {
+            if (row_changes[i] > 0) {
+                plan->rows[plan->num_rows++] = i;
+            }
+        }
+    } else if (cols_only <= mixed_rows + mixed_cols) {
+        for (int j = 0; j < n; j++) {
+            if (col_changed[j]) {
+                plan->cols[plan->num_cols++] = j;
+            }
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            if (row_changes[i] > 1) {
+                plan->rows[plan->num_rows++] = i;
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            if (mixed_col[j]) {
+                plan->cols[plan->num_cols++] = j;
+            }
+        }
+    }
+
+    free(row_changes);
+    free(col_changed);
+    free(mixed_col);
+}
+
+// Monta U (n x k) e Vt (k x n) com A_new - A_old = U*Vt. As linhas do plano
+// levam a diferença inteira; as colunas levam a diferença fora dessas linhas
+void build_factors(const double *A_old, const double *A_new, int n, const update_plan_t *plan,
+                   double *U, double *Vt) {
+    int k = plan->num_rows + plan->num_cols;
+    memset(U, 0, (size_t)n*k*sizeof(double));
+    memset(Vt, 0, (size_t)k*n*sizeof(double));
+
+    char *in_plan_row = (char*)calloc(n, 1);
+    if (in_plan_row == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int t = 0; t < plan->num_rows; t++) {
+        int i = plan->rows[t];
+        in_plan_row[i] = 1;
+        U[(size_t)i*k + t] = 1.0;
+        for (int j = 0; j < n; j++) {
+            Vt[(size_t)t*n + j] = A_new[(size_t)i*n + j] - A_old[(size_t)i*n + j];
+        }
+    }
+
+    for (int c = 0; c < plan->num_cols; c++) {
+        int t = plan->num_rows + c;
+        int j = plan->cols[c];
+        Vt[(size_t)t*n + j] = 1.0;
+        for (int i = 0; i < n; i++) {
+            if (!in_plan_row[i]) {
+                U[(size_t)i*k + t] = A_new[(size_t)i*n + j] - A_old[(size_t)i*n + j];
+            }
+        }
+    }
+
+    free(in_plan_row);
+}
+
+// Encerra com a mensagem da libinvmat se status não for INVMAT_OK
+void invmat_check(invmat_status_t status) {
+    if (status != INVMAT_OK) {
+        fprintf(stderr, "Erro: %s\n", invmat_error_message());
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 5 && argc != 6) {
+        fprintf(stderr, "Uso: %s <num_threads> <inversa_antiga.bin> <matriz_antiga.bin> <matriz_nova.bin> [saida.bin]\n", argv[0]);
+        fprintf(stderr, "A inversa nova é obtida da antiga pela fórmula de Sherman-Morrison-Woodbury, a partir das linhas/colunas alteradas\n");
+        return EXIT_FAILURE;
+    }
+
+    int num_threads = atoi(argv[1]);
+    const char *inverse_filename = argv[2];
+    const char *old_filename = argv[3];
+    const char *new_filename = argv[4];
+
+    if (num_threads <= 0) {
+        fprintf(stderr, "Erro: O número de threads deve ser positivo\n");
+        return EXIT_FAILURE;
+    }
+
+    omp_set_num_threads(num_threads);
+
+    // As três matrizes vêm do formato de Comum/matrix_file.h; n é lido do
+    // cabeçalho da matriz nova
+    matrix_map_t inv_map, old_map, new_map, out_map;
+    double *A_new = matrix_file_open(new_filename, 0, &new_map);
+    int n = new_map.n;
+    double *A_old = matrix_file_open(old_filename, n, &old_map);
+    double *Ainv_old = matrix_file_open(inverse_filename, n, &inv_map);
+
+    if (old_map.n != n || inv_map.n != n) {
+        fprintf(stderr, "Erro: as matrizes não têm o mesmo tamanho (%d, %d e %d)\n", inv_map.n, old_map.n, n);
+        return EXIT_FAILURE;
+    }
+    // Com a mesma ordem, os dados gravados por colunas são as transpostas e
+    // inv(A^T + V*U^T) = inv(A + U*V^T)^T: a atualização vale igual
+    if (old_map.layout != new_map.layout || inv_map.layout != new_map.layout) {
+        fprintf(stderr, "Erro: as matrizes devem estar gravadas na mesma ordem (por linhas ou por colunas)\n");
+        return EXIT_FAILURE;
+    }
+
+    char output_filename[100];
+    if (argc == 6) {
+        snprintf(output_filename, sizeof(output_filename), "%s", argv[5]);
+    } else {
+        sprintf(output_filename, "inverse_matrix_%d_upd.bin", n);
+    }
+
+    // Seleciona os kernels SIMD de acordo com a CPU (ou IM_ISA)
+    simd_init();
+    printf("Kernels SIMD: %s\n", simd_isa_name());
+
+    double start_time = get_time();
+
+    update_plan_t plan;
+    plan_update(A_old, A_new, n, &plan);
+    int k = plan.num_rows + plan.num_cols;
+    printf("Alteração de posto %d: %d linha(s) e %d coluna(s)\n", k, plan.num_rows, plan.num_cols);
+
+    if (k >= n / UPDATE_RANK_NOTE && k > 0) {
+        printf("Aviso: posto %d >= n/%d; a inversão completa provavelmente é mais rápida\n", k, UPDATE_RANK_NOTE);
+    }
+
+    // A inversa antiga é copiada para a saída e atualizada no lugar
+    double *Ainv = matrix_file_create(output_filename, n, new_map.layout, &out_map);
+    memcpy(Ainv, Ainv_old, (size_t)n*n*sizeof(double));
+
+    double cond = 1.0;
+    if (k > 0) {
+        double *U = (double*)malloc((size_t)n*k*sizeof(double));
+        double *Vt = (double*)malloc((size_t)k*n*sizeof(double));
+        if (U == NULL || Vt == NULL) {
+            fprintf(stderr, "Erro: Falha na alocação de memória\n");
+            return EXIT_FAILURE;
+        }
+        build_factors(A_old, A_new, n, &plan, U, Vt);
+
+        printf("Atualizando inversa (%s, %d threads)...\n",
+               k == 1 ? "Sherman-Morrison" : "Woodbury", num_threads);
+        int status = woodbury_update(Ainv, U, Vt, n, k, &cond);
+        free(U);
+        free(Vt);
+
+        if (status == WOODBURY_ILL_CONDITIONED) {
+            fprintf(stderr, "Erro: matriz de capacitância mal condicionada (condicionamento estimado %.3e > %.0e)\n",
+                    cond, WOODBURY_MAX_COND);
+            fprintf(stderr, "A atualização perderia precisão; recalcule a inversa completa de %s (ex.: ./im_parallel)\n",
+                    new_filename);
+            // Nada é gravado: a saída parcial é descartada
+            matrix_file_close(&out_map);
+            remove(output_filename);
+            return EXIT_FAILURE;
+        }
+    } else {
+        printf("As matrizes são iguais; a inversa não muda\n");
+    }
+
+    double end_time = get_time();
+    double execution_time = end_time - start_time;
+
+    // Valida a inversa atualizada contra a matriz nova (teste de Freivalds
+    // da libinvmat, O(n^2))
+    invmat_context_t *ctx;
+    invmat_check(invmat_context_create(INVMAT_BACKEND_OPENMP, num_threads, &ctx));
+    double residual;
+    invmat_check(invmat_validate_freivalds(ctx, A_new, Ainv, n, VALIDATION_PROBES, (unsigned int)time(NULL), &residual));
+    invmat_context_destroy(ctx);
+    if (residual < 1e-6) {
+        printf("Validação da matriz inversa (Freivalds, %d sondas): SUCESSO, resíduo ||A*(A^-1*x) - x||_inf = %.3e\n", VALIDATION_PROBES, residual);
+    } else {
+        printf("Validação da matriz inversa (Freivalds, %d sondas): FALHA, resíduo ||A*(A^-1*x) - x||_inf = %.3e\n", VALIDATION_PROBES, residual);
+    }
+
+    matrix_file_close(&out_map);
+    matrix_file_close(&inv_map);
+    matrix_file_close(&old_map);
+    matrix_file_close(&new_map);
+    printf("Matriz inversa salva em %s\n", output_filename);
+
+    // Grava os resultados em um arquivo CSV para comparar com a inversão completa
+    FILE *results_file = fopen("results_update.csv", "a");
+    if (results_file == NULL) {
+        fprintf(stderr, "Erro ao abrir o arquivo de resultados results_update.csv\n");
+    } else {
+        // Verifica se o arquivo está vazio para adicionar o cabeçalho
+        fseek(results_file, 0, SEEK_END);
+        long size = ftell(results_file);
+
+        if (size == 0) {
+            fprintf(results_file, "tamanho_matriz,num_threads,posto,tempo_execucao,condicionamento\n");
+        }
+
+        // Adiciona os resultados
+        fprintf(results_file, "%d,%d,%d,%.6f,%.6e\n", n, num_threads, k, execution_time, cond);
+        fclose(results_file);
+    }
+
+    printf("Tamanho da matriz: %d x %d\n", n, n);
+    printf("Número de threads: %d\n", num_threads);
+    printf("Condicionamento estimado da capacitância: %.3e\n", cond);
+    printf("Tempo de execução: %.6f segundos\n", execution_time);
+
+    free(plan.rows);
+    free(plan.cols);
+    return EXIT_SUCCESS;
+}
@@ -1,13 +1,32 @@
 #!/bin/bash
 
-# Compile o programa
-gcc -O3 -fopenmp -o inversion_omp im_parallel.c -lm
+# Compile a biblioteca e o programa
+make -C ../Comum
+gcc -O3 -fopenmp -I../Comum -o inversion_omp im_parallel.c ../Comum/topology.c -L../Comum -linvmat -Wl,-rpath,'$ORIGIN/../Comum' -lm
 
 # Tamanhos de matriz para testar
 SIZES=(10 100 500 1000 2000 3000 4000)
 
-# Número de threads para testar
-THREADS=(1 2 4 8 16)
+# Topologia da máquina (a mesma leitura de /sys de Comum/topology.c)
+LOGICAL=$(nproc)
+SOCKETS=$(cat /sys/devices/system/cpu/cpu[0-9]*/topology/physical_package_id 2>/dev/null | sort -u | wc -l)
+CORES=$(cat /sys/devices/system/cpu/cpu[0-9]*/topology/thread_siblings_list 2>/dev/null | sort -u | wc -l)
+[ "$SOCKETS" -ge 1 ] || SOCKETS=1
+[ "$CORES" -ge 1 ] || CORES=$LOGICAL
+# Com a afinidade restrita (taskset, cgroups), nproc pode ser menor
+[ "$CORES" -le "$LOGICAL" ] || CORES=$LOGICAL
+
+# Número de threads para testar: potências de 2 abaixo do número de núcleos,
+# os núcleos de um socket, todos os núcleos e, com SMT, todas as CPUs lógicas
+# (nunca mais threads que CPUs)
+THREADS=()
+for (( t=1; t<CORES; t*=2 )); do
+    THREADS+=($t)
+done
+THREADS+=($((CORES / SOCKETS)) $CORES $LOGICAL)
+THREADS=($(printf "%s\n" "${THREADS[@]}" | awk '$1 > 0' | sort -n -u))
+
+echo "Topologia: $SOCKETS socket(s), $CORES núcleos, $LOGICAL CPUs lógicas; threads: ${THREADS[*]}"
 
 # Limpa o arquivo de resultados se existir
 > results_omp.csv
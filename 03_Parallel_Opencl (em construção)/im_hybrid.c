@@ -0,0 +1,609 @@
+/*
+ * im_hybrid.c - Gauss-Jordan híbrido: a eliminação de cada coluna é dividida
+ * entre threads OpenMP no host e um dispositivo OpenCL, com a fração de linhas
+ * de cada lado ajustada a cada iteração pela vazão medida dos dois lados
+ */
+
+#define CL_TARGET_OPENCL_VERSION 120
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <omp.h>
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include "err_code.h"
+#include "simd_kernels.h"
+#include "gemm.h"
+
+double wtime(void);
+
+// Cada lado mantém ao menos 2% das linhas (e no mínimo uma), para que sua
+// vazão continue sendo medida e a divisão possa voltar a crescer se o outro
+// lado ficar mais lento
+#define HYBRID_MIN_FRACTION 0.02
+// Peso da última medição na média móvel da fração do dispositivo
+#define HYBRID_SMOOTHING 0.5
+
+size_t round_up(size_t value, size_t multiple) {
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+// Kernels sobre a matriz aumentada M = [A | A^-1] (n linhas de width = 2n
+// doubles), restritos às linhas [0, row_end) que pertencem ao dispositivo
+const char *hybrid_kernel_source = "\n" \
+"#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n\n" \
+"__kernel void find_pivot_rows(__global const double* M,\n" \
+"                              const int width,\n" \
+"                              const int k,\n" \
+"                              const int row_end,\n" \
+"                              __global double* result,\n" \
+"                              __local double* best_val,\n" \
+"                              __local int* best_row) {\n" \
+"    int lid = get_local_id(0);\n" \
+"    int lsize = get_local_size(0);\n" \
+"    double my_val = -1.0;\n" \
+"    int my_row = k;\n" \
+"    for (int i = k + lid; i < row_end; i += lsize) {\n" \
+"        double v = fabs(M[i * width + k]);\n" \
+"        if (v > my_val) { my_val = v; my_row = i; }\n" \
+"    }\n" \
+"    best_val[lid] = my_val;\n" \
+"    best_row[lid] = my_row;\n" \
+"    barrier(CLK_LOCAL_MEM_FENCE);\n" \
+"    for (int s = lsize / 2; s > 0; s >>= 1) {\n" \
+"        if (lid < s) {\n" \
+"            double v = best_val[lid + s];\n" \
+"            int r = best_row[lid + s];\n" \
+"            if (v > best_val[lid] || (v == best_val[lid] && r < best_row[lid])) {\n" \
+"                best_val[lid] = v;\n" \
+"                best_row[lid] = r;\n" \
+"            }\n" \
+"        }\n" \
+"        barrier(CLK_LOCAL_MEM_FENCE);\n" \
+"    }\n" \
+"    if (lid == 0) {\n" \
+"        result[0] = best_val[0];\n" \
+"        result[1] = (double)best_row[0];\n" \
+"    }\n" \
+"}\n\n" \
+"__kernel void save_factors(__global const double* M,\n" \
+"                           const int width,\n" \
+"                           const int k,\n" \
+"                           const int row_end,\n" \
+"                           __global double* factors) {\n" \
+"    int i = get_global_id(0);\n" \
+"    if (i < row_end) factors[i] = (i == k) ? 0.0 : M[i * width + k];\n" \
+"}\n\n" \
+"__kernel void eliminate_rows(__global double* M,\n" \
+"                             const int width,\n" \
+"                             const int k,\n" \
+"                             const int row_end,\n" \
+"                             __global const double* factors,\n" \
+"                             __local double4* pivot_row,\n" \
+"                             __local double* factor_tile) {\n" \
+"    int lx = get_local_id(0);\n" \
+"    int ly = get_local_id(1);\n" \
+"    int j = k + get_global_id(0) * 4;\n" \
+"    int i = get_global_id(1);\n" \
+"    if (ly == 0) {\n" \
+"        if (j + 4 <= width) {\n" \
+"            pivot_row[lx] = vload4(0, M + k * width + j);\n" \
+"        } else {\n" \
+"            double4 t = (double4)(0.0);\n" \
+"            if (j < width) t.s0 = M[k * width + j];\n" \
+"            if (j + 1 < width) t.s1 = M[k * width + j + 1];\n" \
+"            if (j + 2 < width) t.s2 = M[k * width + j + 2];\n" \
+"            pivot_row[lx] = t;\n" \
+"        }\n" \
+"    }\n" \
+"    if (lx == 0) factor_tile[ly] = (i < row_end) ? factors[i] : 0.0;\n" \
+"    barrier(CLK_LOCAL_MEM_FENCE);\n" \
+"    double f = factor_tile[ly];\n" \
+"    if (i >= row_end || j >= width || f == 0.0) return;\n" \
+"    __global double* row = M + i * width + j;\n" \
+"    if (j + 4 <= width) {\n" \
+"        vstore4(vload4(0, row) - f * pivot_row[lx], 0, row);\n" \
+"    } else {\n" \
+"        double4 p = pivot_row[lx];\n" \
+"        row[0] -= f * p.s0;\n" \
+"        if (j + 1 < width) row[1] -= f * p.s1;\n" \
+"        if (j + 2 < width) row[2] -= f * p.s2;\n" \
+"    }\n" \
+"}\n";
+
+enum { K_FIND_PIVOT_ROWS, K_SAVE_FACTORS, K_ELIMINATE_ROWS, NUM_KERNELS };
+
+static const char* kernel_names[NUM_KERNELS] = {
+    "find_pivot_rows", "save_factors", "eliminate_rows"
+};
+
+// Lado OpenCL: cópia completa de M no dispositivo, da qual apenas as linhas
+// [0, d) estão atualizadas a cada passo (as demais pertencem ao host)
+typedef struct {
+    cl_command_queue queue;
+    cl_kernel kernels[NUM_KERNELS];
+    cl_mem m_mem, factors_mem, pivot_mem;
+    int n, width;
+    size_t reduce_local;
+    size_t tile_local[2];
+} hybrid_device_t;
+
+// Bytes copiados entre host e dispositivo
+size_t bytes_to_device = 0, bytes_to_host = 0;
+
+// Copia as linhas [first, first + count) de M do host para o dispositivo
+void write_rows(hybrid_device_t *dev, const double *M, int first, int count, cl_bool blocking) {
+    if (count <= 0) return;
+    size_t offset = (size_t)first * dev->width * sizeof(double);
+    size_t bytes = (size_t)count * dev->width * sizeof(double);
+    cl_int err = clEnqueueWriteBuffer(dev->queue, dev->m_mem, blocking, offset, bytes,
+                                      M + (size_t)first * dev->width, 0, NULL, NULL);
+    checkError(err, "clEnqueueWriteBuffer (linhas)");
+    bytes_to_device += bytes;
+}
+
+// Copia as linhas [first, first + count) de M do dispositivo para o host
+void read_rows(hybrid_device_t *dev, double *M, int first, int count) {
+    if (count <= 0) return;
+    size_t offset = (size_t)first * dev->width * sizeof(double);
+    size_t bytes = (size_t)count * dev->width * sizeof(double);
+    cl_int err = clEnqueueReadBuffer(dev->queue, dev->m_mem, CL_TRUE, offset, bytes,
+                                     M + (size_t)first * dev->width, 0, NULL, NULL);
+    checkError(err, "clEnqueueReadBuffer (linhas)");
+    bytes_to_host += bytes;
+}
+
+// Maior potência de 2 que não excede value
+size_t floor_pow2(size_t value) {
+    size_t p = 1;
+    while (p * 2 <= value) p *= 2;
+    return p;
+}
+
+// Formato do work-group de eliminate_rows (colunas de double4 x linhas): a
+// largura é o múltiplo preferido do kernel e a altura completa o work-group,
+// até 64 linhas, dentro da memória local disponível
+void choose_tile_shape(cl_device_id device, cl_kernel kernel, size_t local[2]) {
+    size_t kernel_max, multiple, item_sizes[3];
+    cl_ulong local_mem;
+    cl_int err = clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(kernel_max), &kernel_max, NULL);
+    err |= clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE, sizeof(multiple), &multiple, NULL);
+    err |= clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof(item_sizes), item_sizes, NULL);
+    err |= clGetDeviceInfo(device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(local_mem), &local_mem, NULL);
+    checkError(err, "clGetKernelWorkGroupInfo (eliminate_rows)");
+
+    local[0] = (multiple > 0) ? multiple : 1;
+    while (local[0] > 1 && (local[0] > kernel_max || local[0] > item_sizes[0])) {
+        local[0] /= 2;
+    }
+    local[1] = kernel_max / local[0];
+    if (local[1] > item_sizes[1]) local[1] = item_sizes[1];
+    if (local[1] > 64) local[1] = 64;
+    while (local[1] > 1 && local[0] * 4 * sizeof(double) + local[1] * sizeof(double) > local_mem) {
+        local[1] /= 2;
+    }
+    if (local[1] == 0) local[1] = 1;
+}
+
+// Eliminação das linhas [row_begin, row_end) do host com OpenMP. O fator é
+// lido antes de a linha ser atualizada, e a linha do pivô só é lida
+void host_eliminate(double *M, int width, int k, int row_begin, int row_end) {
+    const double *pivot_row = M + (size_t)k * width;
+    #pragma omp parallel for schedule(static)
+    for (int i = row_begin; i < row_end; i++) {
+        if (i == k) continue;
+        double *row = M + (size_t)i * width;
+        double factor = row[k];
+        if (factor != 0.0) {
+            // As colunas de A anteriores a k já são zero na linha do pivô
+            simd_axpy(row + k, pivot_row + k, factor, width - k);
+        }
+    }
+}
+
+// Linhas do dispositivo para a fração dada. Na divisão adaptativa, cada lado
+// fica com ao menos ceil(2% de n) linhas, nunca zero (com n >= 2)
+int device_share(double fraction, int n, int adaptive) {
+    int d = (int)lround(fraction * n);
+    if (adaptive && n >= 2) {
+        int min_rows = (int)ceil(HYBRID_MIN_FRACTION * n);
+        if (min_rows < 1) min_rows = 1;
+        if (2 * min_rows > n) min_rows = n / 2;
+        if (d < min_rows) d = min_rows;
+        if (d > n - min_rows) d = n - min_rows;
+    }
+    return d;
+}
+
+// Instante de início ou fim de um comando, em segundos (relógio do dispositivo)
+double event_time(cl_event event, cl_profiling_info which) {
+    cl_ulong ns;
+    cl_int err = clGetEventProfilingInfo(event, which, sizeof(ns), &ns, NULL);
+    checkError(err, "clGetEventProfilingInfo");
+    return ns * 1e-9;
+}
+
+int main(int argc, char* argv[]) {
+    double fixed_fraction = -1.0;
+    int requested_units = 0;
+    int bad_args = (argc < 3);
+    for (int a = 3; a < argc && !bad_args; a++) {
+        if (strncmp(argv[a], "--fracao=", 9) == 0) {
+            fixed_fraction = atof(argv[a] + 9);
+            bad_args = (fixed_fraction < 0.0 || fixed_fraction > 1.0);
+        } else if (strncmp(argv[a], "--unidades=", 11) == 0) {
+            requested_units = atoi(argv[a] + 11);
+            bad_args = (requested_units <= 0);
+        } else {
+            bad_args = 1;
+        }
+    }
+    if (bad_args) {
+        printf("Uso: %s <tamanho_da_matriz> <num_threads_host> [--unidades=U] [--fracao=F]\n", argv[0]);
+        return 1;
+    }
+
+    int n = atoi(argv[1]);
+    int host_threads = atoi(argv[2]);
+    if (n <= 0 || host_threads <= 0) {
+        printf("Erro: O tamanho da matriz e o número de threads devem ser maiores que zero.\n");
+        return 1;
+    }
+    int width = 2 * n;
+
+    omp_set_num_threads(host_threads);
+    simd_init();
+
+    cl_platform_id platform_id = NULL;
+    cl_device_id device_id = NULL, sub_device = NULL;
+    cl_int err;
+    cl_uint num_platforms, num_devices;
+
+    err = clGetPlatformIDs(1, &platform_id, &num_platforms);
+    checkError(err, "clGetPlatformIDs");
+
+    cl_device_type device_type = CL_DEVICE_TYPE_GPU;
+    err = clGetDeviceIDs(platform_id, device_type, 1, &device_id, &num_devices);
+    if (err == CL_DEVICE_NOT_FOUND) {
+        printf("GPU não encontrada, tentando CPU...\n");
+        device_type = CL_DEVICE_TYPE_CPU;
+        err = clGetDeviceIDs(platform_id, device_type, 1, &device_id, &num_devices);
+        checkError(err, "clGetDeviceIDs (CPU)");
+    } else {
+        checkError(err, "clGetDeviceIDs (GPU)");
+    }
+
+    char device_name[1024];
+    cl_uint compute_units;
+    err = clGetDeviceInfo(device_id, CL_DEVICE_NAME, sizeof(device_name), device_name, NULL);
+    err |= clGetDeviceInfo(device_id, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(compute_units), &compute_units, NULL);
+    checkError(err, "clGetDeviceInfo");
+
+    // Com um dispositivo CPU, os núcleos são divididos (device fission): o
+    // sub-dispositivo OpenCL fica com as unidades que sobram das threads do host
+    if (device_type == CL_DEVICE_TYPE_CPU) {
+        cl_uint max_sub_devices = 0;
+        clGetDeviceInfo(device_id, CL_DEVICE_PARTITION_MAX_SUB_DEVICES, sizeof(max_sub_devices), &max_sub_devices, NULL);
+
+        int units = requested_units > 0 ? requested_units : (int)compute_units - host_threads;
+        if (max_sub_devices > 1 && units > 0 && units < (int)compute_units) {
+            cl_device_partition_property props[] = {
+                CL_DEVICE_PARTITION_BY_COUNTS, units, CL_DEVICE_PARTITION_BY_COUNTS_LIST_END, 0
+            };
+            err = clCreateSubDevices(device_id, props, 1, &sub_device, NULL);
+            checkError(err, "clCreateSubDevices");
+            device_id = sub_device;
+            compute_units = (cl_uint)units;
+        } else {
+            printf("Aviso: dispositivo CPU sem divisão em sub-dispositivos; host e OpenCL disputam os mesmos %u núcleos\n",
+                   compute_units);
+        }
+    }
+    printf("Dispositivo: %s (%u unidades de computação), host: %d threads OpenMP, kernels SIMD: %s\n",
+           device_name, compute_units, host_threads, simd_isa_name());
+
+    cl_context context = clCreateContext(NULL, 1, &device_id, NULL, NULL, &err);
+    checkError(err, "clCreateContext");
+
+    hybrid_device_t dev;
+    dev.n = n;
+    dev.width = width;
+
+    // Perfilamento ligado: o tempo do lado OpenCL vem dos eventos
+    dev.queue = clCreateCommandQueue(context, device_id, CL_QUEUE_PROFILING_ENABLE, &err);
+    checkError(err, "clCreateCommandQueue");
+
+    cl_program program = clCreateProgramWithSource(context, 1, (const char **)&hybrid_kernel_source, NULL, &err);
+    checkError(err, "clCreateProgramWithSource");
+    err = clBuildProgram(program, 1, &device_id, NULL, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        size_t log_size;
+        clGetProgramBuildInfo(program, device_id, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
+        char *log = (char *)malloc(log_size);
+        clGetProgramBuildInfo(program, device_id, CL_PROGRAM_BUILD_LOG, log_size, log, NULL);
+        printf("Erro de compilação:\n%s\n", log);
+        free(log);
+        return 1;
+    }
+    for (int i = 0; i < NUM_KERNELS; i++) {
+        dev.kernels[i] = clCreateKernel(program, kernel_names[i], &err);
+        checkError(err, "clCreateKernel");
+    }
+
+    size_t reduce_max;
+    err = clGetKernelWorkGroupInfo(dev.kernels[K_FIND_PIVOT_ROWS], device_id, CL_KERNEL_WORK_GROUP_SIZE,
+                                   sizeof(reduce_max), &reduce_max, NULL);
+    checkError(err, "clGetKernelWorkGroupInfo (find_pivot_rows)");
+    dev.reduce_local = floor_pow2(reduce_max < 256 ? reduce_max : 256);
+    choose_tile_shape(device_id, dev.kernels[K_ELIMINATE_ROWS], dev.tile_local);
+
+    // Matriz aumentada [A | I] no host e cópia de A para a verificação
+    double *M = (double *)malloc((size_t)n * width * sizeof(double));
+    double *A = (double *)malloc((size_t)n * n * sizeof(double));
+    if (M == NULL || A == NULL) {
+        fprintf(stderr, "Erro: falha na alocação de memória no host.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Inicializar matriz A com valores não singulares
+    srand(time(NULL));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            A[(size_t)i * n + j] = (i == j) ? (double)(rand() % 100 + n + 1) : (double)(rand() % 10) * 0.1;
+            M[(size_t)i * width + j] = A[(size_t)i * n + j];
+            M[(size_t)i * width + n + j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    dev.m_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, (size_t)n * width * sizeof(double), NULL, &err);
+    checkError(err, "clCreateBuffer (M)");
+    dev.factors_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, n * sizeof(double), NULL, &err);
+    checkError(err, "clCreateBuffer (factors)");
+    dev.pivot_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, 2 * sizeof(double), NULL, &err);
+    checkError(err, "clCreateBuffer (pivot)");
+
+    // Argumentos fixos dos kernels
+    cl_kernel find_pivot = dev.kernels[K_FIND_PIVOT_ROWS];
+    cl_kernel save_factors = dev.kernels[K_SAVE_FACTORS];
+    cl_kernel eliminate = dev.kernels[K_ELIMINATE_ROWS];
+    err = clSetKernelArg(find_pivot, 0, sizeof(cl_mem), &dev.m_mem);
+    err |= clSetKernelArg(find_pivot, 1, sizeof(int), &width);
+    err |= clSetKernelArg(find_pivot, 4, sizeof(cl_mem), &dev.pivot_mem);
+    err |= clSetKernelArg(find_pivot, 5, dev.reduce_local * sizeof(double), NULL);
+    err |= clSetKernelArg(find_pivot, 6, dev.reduce_local * sizeof(int), NULL);
+    err |= clSetKernelArg(save_factors, 0, sizeof(cl_mem), &dev.m_mem);
+    err |= clSetKernelArg(save_factors, 1, sizeof(int), &width);
+    err |= clSetKernelArg(save_factors, 4, sizeof(cl_mem), &dev.factors_mem);
+    err |= clSetKernelArg(eliminate, 0, sizeof(cl_mem), &dev.m_mem);
+    err |= clSetKernelArg(eliminate, 1, sizeof(int), &width);
+    err |= clSetKernelArg(eliminate, 4, sizeof(cl_mem), &dev.factors_mem);
+    err |= clSetKernelArg(eliminate, 5, dev.tile_local[0] * 4 * sizeof(double), NULL);
+    err |= clSetKernelArg(eliminate, 6, dev.tile_local[1] * sizeof(double), NULL);
+    checkError(err, "clSetKernelArg");
+
+    // Fração inicial: metade das linhas, ou a fração fixa pedida
+    double fraction = (fixed_fraction >= 0.0) ? fixed_fraction : 0.5;
+    int adaptive = (fixed_fraction < 0.0);
+    int d = device_share(fraction, n, adaptive);   // linhas [0, d) no dispositivo, [d, n) no host
+    double initial_fraction = fraction, fraction_sum = 0.0;
+    double host_rows_total = 0.0, host_time_total = 0.0;
+    double device_rows_total = 0.0, device_time_total = 0.0;
+    int trace_step = n >= 8 ? n / 8 : 1;
+
+    double start_time = wtime();
+
+    write_rows(&dev, M, 0, d, CL_TRUE);
+
+    for (int k = 0; k < n; k++) {
+        // 1. Pivô: máximo do host nas suas linhas e redução no dispositivo nas dele
+        double max_value = -1.0;
+        int pivot = k;
+        if (k < d) {
+            size_t local = dev.reduce_local;
+            err = clSetKernelArg(find_pivot, 2, sizeof(int), &k);
+            err |= clSetKernelArg(find_pivot, 3, sizeof(int), &d);
+            checkError(err, "clSetKernelArg (find_pivot_rows)");
+            err = clEnqueueNDRangeKernel(dev.queue, find_pivot, 1, NULL, &local, &local, 0, NULL, NULL);
+            checkError(err, "clEnqueueNDRangeKernel (find_pivot_rows)");
+
+            double device_pivot[2];
+            err = clEnqueueReadBuffer(dev.queue, dev.pivot_mem, CL_TRUE, 0, sizeof(device_pivot), device_pivot, 0, NULL, NULL);
+            checkError(err, "clEnqueueReadBuffer (pivot)");
+            bytes_to_host += sizeof(device_pivot);
+            max_value = device_pivot[0];
+            pivot = (int)device_pivot[1];
+        }
+        int host_start = (k > d) ? k : d;
+        if (host_start < n) {
+            double host_max;
+            int host_pivot = simd_abs_argmax(M + k, width, host_start, n, &host_max);
+            // Empate: fica a linha de menor índice (a do dispositivo)
+            if (host_max > max_value) {
+                max_value = host_max;
+                pivot = host_pivot;
+            }
+        }
+
+        if (max_value < 1e-10) {
+            fprintf(stderr, "Erro: A matriz parece ser singular ou mal condicionada\n");
+            exit(EXIT_FAILURE);
+        }
+
+        // 2. Linhas k e do pivô atualizadas no host, troca e normalização
+        if (k < d) read_rows(&dev, M, k, 1);
+        if (pivot != k && pivot < d) read_rows(&dev, M, pivot, 1);
+
+        double *row_k = M + (size_t)k * width;
+        if (pivot != k) {
+            double *row_p = M + (size_t)pivot * width;
+            for (int j = 0; j < width; j++) {
+                double temp = row_k[j];
+                row_k[j] = row_p[j];
+                row_p[j] = temp;
+            }
+        }
+        simd_scale(row_k, row_k[k], width);
+
+        // 3. Linha do pivô enviada ao dispositivo (e a linha trocada, se for
+        // dele). As cópias leem M no host sem bloquear: a espera pelo kernel
+        // de eliminação garante que terminaram antes de o host voltar a
+        // escrever nessas linhas. Sem linhas no dispositivo não há o que enviar
+        if (d > 0) {
+            write_rows(&dev, M, k, 1, CL_FALSE);
+            if (pivot != k && pivot < d) write_rows(&dev, M, pivot, 1, CL_FALSE);
+        }
+
+        // 4. Eliminação: dispositivo nas linhas [0, d), host em [d, n) ao mesmo tempo
+        cl_event factors_event = NULL, eliminate_event = NULL;
+        if (d > 0) {
+            size_t factors_global = round_up(d, 64), factors_local = 64;
+            size_t global[2] = {
+                round_up((width - k + 3) / 4, dev.tile_local[0]),
+                round_up(d, dev.tile_local[1])
+            };
+            err = clSetKernelArg(save_factors, 2, sizeof(int), &k);
+            err |= clSetKernelArg(save_factors, 3, sizeof(int), &d);
+            err |= clSetKernelArg(eliminate, 2, sizeof(int), &k);
+            err |= clSetKernelArg(eliminate, 3, sizeof(int), &d);
+            checkError(err, "clSetKernelArg (eliminação)");
+            err = clEnqueueNDRangeKernel(dev.queue, save_factors, 1, NULL, &factors_global, &factors_local, 0, NULL, &factors_event);
+            checkError(err, "clEnqueueNDRangeKernel (save_factors)");
+            err = clEnqueueNDRangeKernel(dev.queue, eliminate, 2, NULL, global, dev.tile_local, 0, NULL, &eliminate_event);
+            checkError(err, "clEnqueueNDRangeKernel (eliminate_rows)");
+            clFlush(dev.queue);
+        }
+
+        double host_start_time = wtime();
+        host_eliminate(M, width, k, d, n);
+        double host_time = wtime() - host_start_time;
+        int host_rows = (n - d) - (k >= d ? 1 : 0);
+
+        double device_time = 0.0;
+        int device_rows = d - (k < d ? 1 : 0);
+        if (d > 0) {
+            err = clWaitForEvents(1, &eliminate_event);
+            checkError(err, "clWaitForEvents");
+            device_time = event_time(eliminate_event, CL_PROFILING_COMMAND_END) -
+                          event_time(factors_event, CL_PROFILING_COMMAND_START);
+            clReleaseEvent(factors_event);
+            clReleaseEvent(eliminate_event);
+        }
+
+        host_rows_total += host_rows;
+        host_time_total += host_time;
+        device_rows_total += device_rows;
+        device_time_total += device_time;
+        fraction_sum += (double)d / n;
+
+        if (k % trace_step == 0) {
+            printf("k = %6d: %6d linhas no dispositivo (%5.1f%%), host %8.3f ms, dispositivo %8.3f ms\n",
+                   k, d, 100.0 * d / n, 1e3 * host_time, 1e3 * device_time);
+        }
+
+        // 5. Nova divisão a partir da vazão (linhas por segundo) de cada lado
+        if (adaptive && host_rows > 0 && device_rows > 0 && host_time > 0.0 && device_time > 0.0) {
+            double host_rate = host_rows / host_time;
+            double device_rate = device_rows / device_time;
+            double target = device_rate / (device_rate + host_rate);
+            fraction = (1.0 - HYBRID_SMOOTHING) * fraction + HYBRID_SMOOTHING * target;
+            if (fraction < HYBRID_MIN_FRACTION) fraction = HYBRID_MIN_FRACTION;
+            if (fraction > 1.0 - HYBRID_MIN_FRACTION) fraction = 1.0 - HYBRID_MIN_FRACTION;
+
+            // Linhas que mudam de lado são copiadas no estado após o passo k
+            int new_d = device_share(fraction, n, adaptive);
+            if (new_d < d) {
+                read_rows(&dev, M, new_d, d - new_d);
+            } else if (new_d > d) {
+                write_rows(&dev, M, d, new_d - d, CL_FALSE);
+            }
+            d = new_d;
+        }
+    }
+
+    // Linhas que terminaram no dispositivo, depois de concluídas todas as
+    // cópias pendentes que ainda leem M
+    err = clFinish(dev.queue);
+    checkError(err, "clFinish");
+    read_rows(&dev, M, 0, d);
+
+    double end_time = wtime();
+
+    printf("Tempo de execução híbrido: %.6f segundos\n", end_time - start_time);
+    printf("Fração de linhas no dispositivo: inicial %.2f, final %.2f, média %.2f\n",
+           initial_fraction, (double)d / n, fraction_sum / n);
+    printf("Vazão média: host %.1f linhas/ms, dispositivo %.1f linhas/ms\n",
+           host_time_total > 0.0 ? host_rows_total / (1e3 * host_time_total) : 0.0,
+           device_time_total > 0.0 ? device_rows_total / (1e3 * device_time_total) : 0.0);
+    printf("Bytes transferidos host<->dispositivo: %zu para o dispositivo, %zu para o host (%.2f MB)\n",
+           bytes_to_device, bytes_to_host, (bytes_to_device + bytes_to_host) / (1024.0 * 1024.0));
+
+    // Verificação: A * A^-1 deve ser a identidade
+    double *Ainv = (double *)malloc((size_t)n * n * sizeof(double));
+    double *result = (double *)malloc((size_t)n * n * sizeof(double));
+    if (Ainv == NULL || result == NULL) {
+        fprintf(stderr, "Erro: falha na alocação de memória no host.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) {
+        memcpy(Ainv + (size_t)i * n, M + (size_t)i * width + n, n * sizeof(double));
+    }
+    gemm(n, n, n, 1.0, A, n, Ainv, n, 0.0, result, n);
+
+    int valid = 1;
+    double tolerance = 1e-4;
+    for (int i = 0; i < n && valid; i++) {
+        for (int j = 0; j < n; j++) {
+            double expected = (i == j) ? 1.0 : 0.0;
+            if (fabs(result[(size_t)i * n + j] - expected) > tolerance) {
+                valid = 0;
+                printf("Erro na posição [%d,%d]: %.6f vs %.1f\n", i, j, result[(size_t)i * n + j], expected);
+                break;
+            }
+        }
+    }
+    printf("Verificação: %s\n", valid ? "SUCESSO" : "FALHA");
+
+    // Grava os resultados em um arquivo CSV
+    FILE *results_file = fopen("results_hybrid.csv", "a");
+    if (results_file == NULL) {
+        fprintf(stderr, "Erro ao abrir o arquivo de resultados results_hybrid.csv\n");
+    } else {
+        // Verifica se o arquivo está vazio para adicionar o cabeçalho
+        fseek(results_file, 0, SEEK_END);
+        long size = ftell(results_file);
+
+        if (size == 0) {
+            fprintf(results_file, "tamanho_matriz,num_threads,unidades_dispositivo,fracao_dispositivo,tempo_execucao\n");
+        }
+
+        // Adiciona os resultados
+        fprintf(results_file, "%d,%d,%u,%.3f,%.6f\n", n, host_threads, compute_units,
+                fraction_sum / n, end_time - start_time);
+        fclose(results_file);
+    }
+
+    // Liberar recursos
+    for (int i = 0; i < NUM_KERNELS; i++) clReleaseKernel(dev.kernels[i]);
+    clReleaseProgram(program);
+    clReleaseMemObject(dev.m_mem);
+    clReleaseMemObject(dev.factors_mem);
+    clReleaseMemObject(dev.pivot_mem);
+    clReleaseCommandQueue(dev.queue);
+    clReleaseContext(context);
+    if (sub_device != NULL) clReleaseDevice(sub_device);
+
+    free(M);
+    free(A);
+    free(Ainv);
+    free(result);
+
+    return 0;
+}
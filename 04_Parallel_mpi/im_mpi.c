@@ -0,0 +1,968 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <mpi.h>
+#include <omp.h>  // Inclusão da biblioteca OpenMP
+
+#include "simd_kernels.h"
+#include "matrix_file.h"
+#include "gemm.h"
+#include "invmat.h"
+
+/*
+ * im_mpi.c - Inversão com memória distribuída (MPI + OpenMP), para matrizes
+ * que não cabem na memória ou nos núcleos de um único nó.
+ *
+ * Os processos formam uma grade Pr x Pc e a matriz é distribuída em blocos
+ * nb x nb de forma cíclica nas duas dimensões (2D block-cyclic, como no
+ * ScaLAPACK): o bloco (I, J) fica no processo (I mod Pr, J mod Pc). Cada
+ * processo guarda os seus blocos numa matriz local contígua, por linhas.
+ *
+ * O algoritmo é o Gauss-Jordan in-place por blocos (o mesmo de im_ooc.c):
+ * temp_A é sobrescrita pela inversa, sem a metade da identidade. No passo K,
+ * a coluna de processos dona do painel (colunas K*nb .. K*nb + b - 1) o
+ * fatora: o pivô de cada coluna sai de um MPI_Allreduce(MAXLOC) entre os
+ * donos da coluna e a linha do pivô é difundida na coluna de processos. O
+ * painel fatorado V = T*E_K descreve a transformação T do passo. Os fatores
+ * (o painel original) e a fatoração LU do bloco diagonal são difundidos ao
+ * longo das linhas de processos e as b linhas dos pivôs, já resolvidas com
+ * os fatores L e U desse bloco, ao longo das colunas de processos; cada
+ * processo atualiza as suas demais colunas com um GEMM local (OpenMP), o
+ * equivalente a X <- T*X (ver update_columns).
+ * No fim, as trocas de linhas são desfeitas como trocas de colunas.
+ *
+ * Entrada e saída usam o formato de Comum/matrix_file.h, lido e escrito por
+ * todos os processos ao mesmo tempo com MPI-IO (visão do arquivo do tipo
+ * MPI_Type_create_darray, que descreve exatamente os blocos de cada processo)
+ */
+
+// Largura padrão dos blocos da distribuição (e dos painéis)
+#define DEFAULT_BLOCK_SIZE 64
+
+// Colunas por faixa nas substituições das linhas dos pivôs
+#define SOLVE_COLS 256
+
+// Número padrão de vetores do teste de Freivalds
+#define VALIDATION_PROBES 3
+
+// Maior n aceito no cabeçalho (o mesmo limite de Comum/matrix_file.c)
+#define MATRIX_MAX_N 46340
+
+// Trecho do arquivo lido por vez no cálculo do checksum
+#define CHECKSUM_CHUNK (4 << 20)
+
+// Matriz n x n distribuída na grade de processos
+typedef struct {
+    int n;
+    int nb;                 // largura dos blocos
+    int nprocs, rank;
+    int grid_rows, grid_cols;   // Pr x Pc
+    int prow, pcol;         // posição deste processo na grade
+    MPI_Comm row_comm;      // processos da mesma linha da grade (rank = pcol)
+    MPI_Comm col_comm;      // processos da mesma coluna da grade (rank = prow)
+    int local_rows, local_cols;
+    int *row_global;        // índice global de cada linha local
+    int *col_global;        // índice global de cada coluna local
+    double *M;              // local_rows x local_cols, por linhas
+} dist_matrix_t;
+
+// Cabeçalho do arquivo de entrada, lido pelo processo 0 e difundido
+typedef struct {
+    int n;
+    int elem_type;
+    int layout;
+    int legacy;
+    long long offset;
+    unsigned long long checksum;
+} file_info_t;
+
+// Tempo gasto nas chamadas MPI da inversão (comunicação e espera)
+static double comm_time = 0.0;
+
+// Função para medir o tempo em segundos
+double get_time() {
+    return MPI_Wtime();
+}
+
+// Equivalente de exit(EXIT_FAILURE) com MPI: encerra todos os processos
+static void abort_all(void) {
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+}
+
+static void *checked_malloc(size_t bytes) {
+    // Processos sem blocos ainda recebem um ponteiro válido
+    void *p = malloc(bytes > 0 ? bytes : 1);
+    if (p == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        abort_all();
+    }
+    return p;
+}
+
+// Quantidade de índices de 0..n-1 que ficam no processo p de np (blocos de nb)
+static int local_count(int n, int nb, int p, int np) {
+    int blocks = n / nb;
+    int count = (blocks / np) * nb;
+    int extra = blocks % np;
+    if (p < extra) {
+        count += nb;
+    } else if (p == extra) {
+        count += n % nb;
+    }
+    return count;
+}
+
+// Processo (linha ou coluna da grade) dono do índice global g
+static int owner_of(int g, int nb, int np) {
+    return (g / nb) % np;
+}
+
+// Posição local do índice global g no processo dono
+static int local_index(int g, int nb, int np) {
+    return (g / nb / np) * nb + g % nb;
+}
+
+// Índice global da posição local l do processo p
+static int global_index(int l, int nb, int p, int np) {
+    return ((l / nb) * np + p) * nb + l % nb;
+}
+
+// Monta a grade de processos e os comunicadores de linha e de coluna
+static void setup_grid(dist_matrix_t *D, int n, int nb, int grid_rows, int grid_cols) {
+    MPI_Comm_size(MPI_COMM_WORLD, &D->nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &D->rank);
+
+    int dims[2] = { grid_rows, grid_cols };
+    if (grid_rows == 0) {
+        dims[0] = dims[1] = 0;
+        MPI_Dims_create(D->nprocs, 2, dims);
+    }
+    if (dims[0] * dims[1] != D->nprocs) {
+        if (D->rank == 0) {
+            fprintf(stderr, "Erro: A grade %dx%d não corresponde aos %d processos\n", dims[0], dims[1], D->nprocs);
+        }
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+
+    // Sem reordenação: o rank é prow*Pc + pcol, a mesma ordem que
+    // MPI_Type_create_darray usa para a grade (MPI_ORDER_C)
+    int periods[2] = { 0, 0 };
+    int coords[2];
+    MPI_Comm grid;
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &grid);
+    MPI_Cart_coords(grid, D->rank, 2, coords);
+
+    int keep_cols[2] = { 0, 1 };
+    int keep_rows[2] = { 1, 0 };
+    MPI_Cart_sub(grid, keep_cols, &D->row_comm);
+    MPI_Cart_sub(grid, keep_rows, &D->col_comm);
+    MPI_Comm_free(&grid);
+
+    D->n = n;
+    D->nb = nb;
+    D->grid_rows = dims[0];
+    D->grid_cols = dims[1];
+    D->prow = coords[0];
+    D->pcol = coords[1];
+    D->local_rows = local_count(n, nb, D->prow, D->grid_rows);
+    D->local_cols = local_count(n, nb, D->pcol, D->grid_cols);
+
+    D->row_global = (int*)checked_malloc(D->local_rows*sizeof(int));
+    D->col_global = (int*)checked_malloc(D->local_cols*sizeof(int));
+    for (int l = 0; l < D->local_rows; l++) {
+        D->row_global[l] = global_index(l, nb, D->prow, D->grid_rows);
+    }
+    for (int l = 0; l < D->local_cols; l++) {
+        D->col_global[l] = global_index(l, nb, D->pcol, D->grid_cols);
+    }
+    D->M = (double*)checked_malloc((size_t)D->local_rows*D->local_cols*sizeof(double));
+}
+
+static void free_grid(dist_matrix_t *D) {
+    free(D->M);
+    free(D->row_global);
+    free(D->col_global);
+    MPI_Comm_free(&D->row_comm);
+    MPI_Comm_free(&D->col_comm);
+}
+
+// Tipo MPI com os blocos deste processo dentro da matriz global n x n
+static MPI_Datatype block_cyclic_type(const dist_matrix_t *D, MPI_Datatype elem) {
+    int gsizes[2] = { D->n, D->n };
+    int distribs[2] = { MPI_DISTRIBUTE_CYCLIC, MPI_DISTRIBUTE_CYCLIC };
+    int dargs[2] = { D->nb, D->nb };
+    int psizes[2] = { D->grid_rows, D->grid_cols };
+    MPI_Datatype type;
+    MPI_Type_create_darray(D->nprocs, D->rank, 2, gsizes, distribs, dargs, psizes,
+                           MPI_ORDER_C, elem, &type);
+    MPI_Type_commit(&type);
+    return type;
+}
+
+// Checksum (FNV-1a, Comum/matrix_file.c) dos bytes [offset, offset + bytes)
+// do arquivo. O FNV-1a é sequencial: o arquivo é dividido em P trechos e cada
+// processo continua, sobre o seu trecho, o hash recebido do anterior. Nenhum
+// processo lê mais que n^2/P elementos, e o resultado vale para todos
+static unsigned long long distributed_checksum(MPI_File fh, MPI_Offset offset, size_t bytes, int rank, int nprocs) {
+    size_t words = bytes / 8;
+    size_t begin = (words * rank / nprocs) * 8;
+    size_t end = (rank == nprocs - 1) ? bytes : (words * (rank + 1) / nprocs) * 8;
+
+    uint64_t hash = MATRIX_CHECKSUM_INIT;
+    if (rank > 0) {
+        MPI_Recv(&hash, 1, MPI_UINT64_T, rank - 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+
+    unsigned char *buffer = (unsigned char*)checked_malloc(CHECKSUM_CHUNK);
+    for (size_t pos = begin; pos < end; pos += CHECKSUM_CHUNK) {
+        int len = (end - pos < CHECKSUM_CHUNK) ? (int)(end - pos) : CHECKSUM_CHUNK;
+        MPI_File_read_at(fh, offset + (MPI_Offset)pos, buffer, len, MPI_BYTE, MPI_STATUS_IGNORE);
+        hash = matrix_checksum_update(hash, buffer, (size_t)len);
+    }
+    free(buffer);
+
+    if (rank < nprocs - 1) {
+        MPI_Send(&hash, 1, MPI_UINT64_T, rank + 1, 0, MPI_COMM_WORLD);
+    }
+    MPI_Bcast(&hash, 1, MPI_UINT64_T, nprocs - 1, MPI_COMM_WORLD);
+    return (unsigned long long)hash;
+}
+
+// Lê o cabeçalho no processo 0, com as mesmas verificações de
+// matrix_file_open, e o difunde para os demais
+static void read_file_info(MPI_File fh, const char *filename, int expected_n, int rank, file_info_t *info) {
+    if (rank == 0) {
+        MPI_Offset size;
+        MPI_File_get_size(fh, &size);
+
+        matrix_file_header_t header;
+        int has_header = 0;
+        if (size >= MATRIX_FILE_DATA_OFFSET) {
+            MPI_File_read_at(fh, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+            has_header = (memcmp(header.magic, MATRIX_FILE_MAGIC, 8) == 0);
+        }
+
+        memset(info, 0, sizeof(*info));
+        if (has_header) {
+            if (header.version != MATRIX_FILE_VERSION) {
+                fprintf(stderr, "Erro: %s usa a versão %u do formato (suportada: %d)\n",
+                        filename, header.version, MATRIX_FILE_VERSION);
+                abort_all();
+            }
+            if (header.elem_type != MATRIX_ELEM_F64 && header.elem_type != MATRIX_ELEM_F32) {
+                fprintf(stderr, "Erro: tipo de elemento desconhecido (%u) em %s\n", header.elem_type, filename);
+                abort_all();
+            }
+            if (header.layout != MATRIX_ROW_MAJOR && header.layout != MATRIX_COL_MAJOR) {
+                fprintf(stderr, "Erro: ordem dos elementos desconhecida (%u) em %s\n", header.layout, filename);
+                abort_all();
+            }
+            if (header.n == 0 || header.n > MATRIX_MAX_N || header.data_offset != MATRIX_FILE_DATA_OFFSET) {
+                fprintf(stderr, "Erro: cabeçalho inválido em %s\n", filename);
+                abort_all();
+            }
+            info->n = (int)header.n;
+            info->elem_type = (int)header.elem_type;
+            info->layout = (int)header.layout;
+            info->offset = header.data_offset;
+            info->checksum = header.checksum;
+
+            size_t elem_size = (info->elem_type == MATRIX_ELEM_F64) ? sizeof(double) : sizeof(float);
+            if ((size_t)size < info->offset + (size_t)info->n*info->n*elem_size) {
+                fprintf(stderr, "Erro: %s está truncado (esperados %zu bytes de dados)\n",
+                        filename, (size_t)info->n*info->n*elem_size);
+                abort_all();
+            }
+        } else {
+            // Formato antigo: n*n doubles crus, n conhecido apenas pelo chamador
+            if (expected_n <= 0 || (size_t)size != (size_t)expected_n*expected_n*sizeof(double)) {
+                fprintf(stderr, "Erro: %s não tem cabeçalho e o tamanho não corresponde a uma matriz %dx%d\n",
+                        filename, expected_n, expected_n);
+                abort_all();
+            }
+            info->n = expected_n;
+            info->elem_type = MATRIX_ELEM_F64;
+            info->layout = MATRIX_ROW_MAJOR;
+            info->legacy = 1;
+        }
+    }
+    MPI_Bcast(info, sizeof(*info), MPI_BYTE, 0, MPI_COMM_WORLD);
+}
+
+// Lê os blocos deste processo de um arquivo já aberto (leitura coletiva)
+static void read_local_blocks(MPI_File fh, const file_info_t *info, dist_matrix_t *D) {
+    int count = D->local_rows * D->local_cols;
+
+    if (info->elem_type == MATRIX_ELEM_F64) {
+        MPI_Datatype filetype = block_cyclic_type(D, MPI_DOUBLE);
+        MPI_File_set_view(fh, info->offset, MPI_DOUBLE, filetype, "native", MPI_INFO_NULL);
+        MPI_File_read_all(fh, D->M, count, MPI_DOUBLE, MPI_STATUS_IGNORE);
+        MPI_Type_free(&filetype);
+    } else {
+        // float32: as rotinas trabalham em double, então os blocos são convertidos
+        float *buffer = (float*)checked_malloc((size_t)count*sizeof(float));
+        MPI_Datatype filetype = block_cyclic_type(D, MPI_FLOAT);
+        MPI_File_set_view(fh, info->offset, MPI_FLOAT, filetype, "native", MPI_INFO_NULL);
+        MPI_File_read_all(fh, buffer, count, MPI_FLOAT, MPI_STATUS_IGNORE);
+        MPI_Type_free(&filetype);
+        for (int i = 0; i < count; i++) {
+            D->M[i] = buffer[i];
+        }
+        free(buffer);
+    }
+    MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, "native", MPI_INFO_NULL);
+}
+
+// Abre filename e lê os blocos deste processo; com verify, confere também o
+// checksum do cabeçalho
+static void read_distributed(const char *filename, int verify, file_info_t *info, dist_matrix_t *D) {
+    MPI_File fh;
+    if (MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (D->rank == 0) {
+            fprintf(stderr, "Erro ao abrir o arquivo %s para leitura\n", filename);
+        }
+        abort_all();
+    }
+
+    if (verify && !info->legacy) {
+        size_t elem_size = (info->elem_type == MATRIX_ELEM_F64) ? sizeof(double) : sizeof(float);
+        unsigned long long checksum = distributed_checksum(fh, info->offset, (size_t)info->n*info->n*elem_size,
+                                                           D->rank, D->nprocs);
+        if (checksum != info->checksum) {
+            if (D->rank == 0) {
+                fprintf(stderr, "Erro: checksum não confere em %s (arquivo corrompido?)\n", filename);
+            }
+            abort_all();
+        }
+    }
+    read_local_blocks(fh, info, D);
+    MPI_File_close(&fh);
+}
+
+// Escreve a matriz distribuída em filename (float64, na ordem layout): os
+// blocos vão para filename.tmp com uma escrita coletiva, o checksum é
+// calculado sobre o arquivo e o processo 0 grava o cabeçalho e renomeia,
+// como em matrix_file_create/matrix_file_close
+static void write_distributed(const char *filename, int layout, dist_matrix_t *D) {
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", filename);
+
+    MPI_File fh;
+    if (MPI_File_open(MPI_COMM_WORLD, temp_path, MPI_MODE_CREATE | MPI_MODE_RDWR, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (D->rank == 0) {
+            fprintf(stderr, "Erro ao abrir o arquivo %s para escrita\n", temp_path);
+        }
+        abort_all();
+    }
+
+    size_t data_bytes = (size_t)D->n*D->n*sizeof(double);
+    MPI_File_set_size(fh, MATRIX_FILE_DATA_OFFSET + (MPI_Offset)data_bytes);
+
+    MPI_Datatype filetype = block_cyclic_type(D, MPI_DOUBLE);
+    MPI_File_set_view(fh, MATRIX_FILE_DATA_OFFSET, MPI_DOUBLE, filetype, "native", MPI_INFO_NULL);
+    MPI_File_write_all(fh, D->M, D->local_rows*D->local_cols, MPI_DOUBLE, MPI_STATUS_IGNORE);
+    MPI_Type_free(&filetype);
+
+    // Os dados escritos pelos outros processos precisam estar visíveis antes
+    // da leitura do checksum (sync-barrier-sync da semântica do MPI-IO)
+    MPI_File_set_view(fh, 0, MPI_BYTE, MPI_BYTE, "native", MPI_INFO_NULL);
+    MPI_File_sync(fh);
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_File_sync(fh);
+
+    unsigned long long checksum = distributed_checksum(fh, MATRIX_FILE_DATA_OFFSET, data_bytes, D->rank, D->nprocs);
+
+    if (D->rank == 0) {
+        // Cabeçalho completado com zeros até MATRIX_FILE_DATA_OFFSET
+        char *block = (char*)calloc(1, MATRIX_FILE_DATA_OFFSET);
+        if (block == NULL) {
+            fprintf(stderr, "Erro: Falha na alocação de memória\n");
+            abort_all();
+        }
+        matrix_file_header_t header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MATRIX_FILE_MAGIC, 8);
+        header.version = MATRIX_FILE_VERSION;
+        header.elem_type = MATRIX_ELEM_F64;
+        header.layout = (uint32_t)layout;
+        header.data_offset = MATRIX_FILE_DATA_OFFSET;
+        header.n = (uint64_t)D->n;
+        header.checksum = checksum;
+        memcpy(block, &header, sizeof(header));
+        MPI_File_write_at(fh, 0, block, MATRIX_FILE_DATA_OFFSET, MPI_BYTE, MPI_STATUS_IGNORE);
+        free(block);
+    }
+    MPI_File_close(&fh);
+
+    if (D->rank == 0 && rename(temp_path, filename) != 0) {
+        fprintf(stderr, "Erro ao renomear %s para %s\n", temp_path, filename);
+        abort_all();
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+// Troca as linhas globais r1 e r2 nas colunas [c_begin, c_end) de local
+// (linhas locais de D, com ld doubles cada: D->M ou a cópia do painel). Só
+// os processos das linhas da grade donas de r1 e r2 participam (na coluna de
+// processos, via col_comm)
+static void swap_rows(dist_matrix_t *D, double *local, int ld, int r1, int r2, int c_begin, int c_end) {
+    if (r1 == r2 || c_begin >= c_end) {
+        return;
+    }
+
+    int nb = D->nb, np = D->grid_rows;
+    int owner1 = owner_of(r1, nb, np);
+    int owner2 = owner_of(r2, nb, np);
+    int len = c_end - c_begin;
+
+    if (owner1 == D->prow && owner2 == D->prow) {
+        double *row1 = local + (size_t)local_index(r1, nb, np)*ld + c_begin;
+        double *row2 = local + (size_t)local_index(r2, nb, np)*ld + c_begin;
+        for (int j = 0; j < len; j++) {
+            double temp = row1[j];
+            row1[j] = row2[j];
+            row2[j] = temp;
+        }
+    } else if (owner1 == D->prow || owner2 == D->prow) {
+        int mine = (owner1 == D->prow) ? r1 : r2;
+        int other = (owner1 == D->prow) ? owner2 : owner1;
+        double *row = local + (size_t)local_index(mine, nb, np)*ld + c_begin;
+        double t0 = get_time();
+        MPI_Sendrecv_replace(row, len, MPI_DOUBLE, other, 0, other, 0, D->col_comm, MPI_STATUS_IGNORE);
+        comm_time += get_time() - t0;
+    }
+}
+
+// Troca as colunas globais c1 e c2 em todas as linhas locais (entre as
+// colunas de processos donas, via row_comm)
+static void swap_columns(dist_matrix_t *D, int c1, int c2, double *buffer) {
+    int nb = D->nb, np = D->grid_cols, ld = D->local_cols, m = D->local_rows;
+    int owner1 = owner_of(c1, nb, np);
+    int owner2 = owner_of(c2, nb, np);
+
+    if (owner1 == D->pcol && owner2 == D->pcol) {
+        int l1 = local_index(c1, nb, np);
+        int l2 = local_index(c2, nb, np);
+        for (int i = 0; i < m; i++) {
+            double temp = D->M[(size_t)i*ld + l1];
+            D->M[(size_t)i*ld + l1] = D->M[(size_t)i*ld + l2];
+            D->M[(size_t)i*ld + l2] = temp;
+        }
+    } else if (owner1 == D->pcol || owner2 == D->pcol) {
+        int l = local_index(owner1 == D->pcol ? c1 : c2, nb, np);
+        int other = (owner1 == D->pcol) ? owner2 : owner1;
+        for (int i = 0; i < m; i++) {
+            buffer[i] = D->M[(size_t)i*ld + l];
+        }
+        double t0 = get_time();
+        MPI_Sendrecv_replace(buffer, m, MPI_DOUBLE, other, 0, other, 0, D->row_comm, MPI_STATUS_IGNORE);
+        comm_time += get_time() - t0;
+        for (int i = 0; i < m; i++) {
+            D->M[(size_t)i*ld + l] = buffer[i];
+        }
+    }
+}
+
+// Fatora o painel de colunas globais [k0, k0 + b), copiado das linhas locais
+// dos processos desta coluna da grade para panel (m x 2b): as colunas [0, b)
+// passam pelo Gauss-Jordan in-place e ao fim guardam V = T*E_K; as colunas
+// [b, 2b) guardam o painel original e recebem apenas as trocas de linhas
+// (ipiv[k0..k0+b-1])
+static void factor_panel(dist_matrix_t *D, double *panel, int k0, int b, int *ipiv, double *pivot_row) {
+    int nb = D->nb, np = D->grid_rows, ld = 2*b, m = D->local_rows;
+
+    // Primeira linha local ainda não usada como pivô (as linhas locais estão
+    // em ordem crescente de índice global)
+    int first = 0;
+
+    for (int j = 0; j < b; j++) {
+        int c = k0 + j;
+        while (first < m && D->row_global[first] < c) {
+            first++;
+        }
+
+        // Busca local do pivô na coluna c, seguida da redução entre os donos
+        // da coluna; empates ficam com a menor linha, como na busca serial
+        struct { double value; int row; } local, global;
+        local.value = -1.0;
+        local.row = D->n;
+        if (first < m) {
+            double abs_value;
+            int l = simd_abs_argmax(panel + j, ld, first, m, &abs_value);
+            local.value = abs_value;
+            local.row = D->row_global[l];
+        }
+        double t0 = get_time();
+        MPI_Allreduce(&local, &global, 1, MPI_DOUBLE_INT, MPI_MAXLOC, D->col_comm);
+        comm_time += get_time() - t0;
+
+        // Se o pivô for muito pequeno, a matriz pode ser singular
+        if (global.value < 1e-10) {
+            if (D->prow == 0) {
+                fprintf(stderr, "Erro: A matriz parece ser singular ou mal condicionada\n");
+            }
+            MPI_Barrier(D->col_comm);
+            abort_all();
+        }
+
+        // Troca as linhas no painel e na cópia (nas demais colunas, depois)
+        ipiv[c] = global.row;
+        swap_rows(D, panel, ld, c, global.row, 0, ld);
+
+        // Difunde a linha do pivô (trecho do painel) na coluna de processos
+        int owner = owner_of(c, nb, np);
+        if (owner == D->prow) {
+            memcpy(pivot_row, panel + (size_t)local_index(c, nb, np)*ld, b*sizeof(double));
+        }
+        t0 = get_time();
+        MPI_Bcast(pivot_row, b, MPI_DOUBLE, owner, D->col_comm);
+        comm_time += get_time() - t0;
+
+        // Normaliza a linha do pivô; a posição j passa a ser 1/pivô
+        double pivot = pivot_row[j];
+        pivot_row[j] = 1.0;
+        simd_scale(pivot_row, pivot, b);
+
+        // Eliminação de Gauss nas linhas locais; a posição j passa a ser -fator/pivô
+        #pragma omp parallel for schedule(static)
+        for (int l = 0; l < m; l++) {
+            double *row = panel + (size_t)l*ld;
+            if (D->row_global[l] == c) {
+                memcpy(row, pivot_row, b*sizeof(double));
+            } else {
+                double factor = row[j];
+                row[j] = 0.0;
+                simd_axpy(row, pivot_row, factor, b);
+            }
+        }
+    }
+}
+
+// Fatoração LU in-place (L com diagonal unitária abaixo, U acima) do bloco
+// diagonal D do painel, b x b por linhas. As trocas do painel já levaram para
+// D os pivôs do pivotamento parcial, então não há novas trocas e os
+// multiplicadores de L têm módulo <= 1
+static void factor_pivot_block(double *block, int b) {
+    for (int j = 0; j < b; j++) {
+        const double *pivot_row = block + (size_t)j*b;
+        for (int r = j + 1; r < b; r++) {
+            double *row = block + (size_t)r*b;
+            row[j] /= pivot_row[j];
+            simd_axpy(row + j + 1, pivot_row + j + 1, row[j], b - j - 1);
+        }
+    }
+}
+
+// rows (b x ld, as linhas dos pivôs já trocadas) <- D^-1 * rows, por
+// substituição direta com L e reversa com U (fatores de factor_pivot_block),
+// sem formar D^-1: a inversa explícita do bloco amplificaria o arredondamento
+// pelo condicionamento de D. Faixas de colunas independentes entre as threads
+static void solve_pivot_rows(const double *lu, int b, double *rows, int ld) {
+    #pragma omp parallel for schedule(static)
+    for (int c0 = 0; c0 < ld; c0 += SOLVE_COLS) {
+        int len = (c0 + SOLVE_COLS < ld) ? SOLVE_COLS : ld - c0;
+        for (int r = 1; r < b; r++) {
+            for (int s = 0; s < r; s++) {
+                simd_axpy(rows + (size_t)r*ld + c0, rows + (size_t)s*ld + c0, lu[(size_t)r*b + s], len);
+            }
+        }
+        for (int r = b - 1; r >= 0; r--) {
+            for (int s = r + 1; s < b; s++) {
+                simd_axpy(rows + (size_t)r*ld + c0, rows + (size_t)s*ld + c0, lu[(size_t)r*b + s], len);
+            }
+            simd_scale(rows + (size_t)r*ld + c0, lu[(size_t)r*b + r], len);
+        }
+    }
+}
+
+// Atualiza as colunas locais [c0, c1) pelo passo do painel, na forma da
+// versão por tiles de im_parallel.c: com D = linhas dos pivôs do painel
+// original (já trocadas) e C = demais linhas dele, X[K] <- D^-1 * X[K] e
+// X[i] <- X[i] - C[i] * (D^-1 * X[K]). Em exatidão é o mesmo que somar
+// (V - E_K) * X[K], mas somar (V[K] - I) * X[K] a X[K] cancelaria quase todos
+// os dígitos quando o pivô é grande (1/p - 1 ~ -1). factors guarda -C (com as
+// linhas de K zeradas) e pivot_rows guarda D^-1 * X[K] (de solve_pivot_rows)
+static void update_columns(dist_matrix_t *D, const double *factors, const double *pivot_rows,
+                           int b, int pivot_lr, int owns_pivots, int c0, int c1) {
+    int m = D->local_rows, ld = D->local_cols;
+    if (m == 0 || c0 >= c1) {
+        return;
+    }
+    gemm(m, c1 - c0, b, 1.0, factors, b, pivot_rows + c0, ld, 1.0, D->M + c0, ld);
+    if (owns_pivots) {
+        for (int r = 0; r < b; r++) {
+            memcpy(D->M + (size_t)(pivot_lr + r)*ld + c0, pivot_rows + (size_t)r*ld + c0, (c1 - c0)*sizeof(double));
+        }
+    }
+}
+
+// Gauss-Jordan in-place por blocos sobre a matriz distribuída (ver o
+// comentário no início do arquivo); D->M passa a guardar a inversa
+void calculate_inverse_distributed(dist_matrix_t *D, int num_threads) {
+    // Define o número de threads a ser usado dentro de cada processo
+    omp_set_num_threads(num_threads);
+
+    int n = D->n, nb = D->nb;
+    int m = D->local_rows, ld = D->local_cols;
+
+    int *ipiv = (int*)checked_malloc(n*sizeof(int));
+    double *panel = (double*)checked_malloc((size_t)m*2*nb*sizeof(double));      // [V | painel original], m x 2b
+    double *factors = (double*)checked_malloc((size_t)m*nb*sizeof(double));      // -C, m x b
+    double *pivot_block = (double*)checked_malloc((size_t)nb*nb*sizeof(double)); // LU de D, b x b
+    double *pivot_rows = (double*)checked_malloc((size_t)nb*ld*sizeof(double));  // D^-1 * X[linhas de K], b x ld
+    double *pivot_row = (double*)checked_malloc(nb*sizeof(double));
+    double *column = (double*)checked_malloc(m*sizeof(double));
+
+    for (int k0 = 0; k0 < n; k0 += nb) {
+        int kb = k0 / nb;
+        int b = (n - k0 < nb) ? n - k0 : nb;
+        int panel_pcol = kb % D->grid_cols;
+        int panel_lc = (kb / D->grid_cols) * nb;
+        int pivot_prow = kb % D->grid_rows;
+        int pivot_lr = (kb / D->grid_rows) * nb;
+        int in_panel = (D->pcol == panel_pcol);
+        int owns_pivots = (D->prow == pivot_prow);
+
+        // 1. Fatoração do painel pela coluna de processos dona
+        if (in_panel) {
+            #pragma omp parallel for schedule(static)
+            for (int l = 0; l < m; l++) {
+                memcpy(panel + (size_t)l*2*b, D->M + (size_t)l*ld + panel_lc, b*sizeof(double));
+                memcpy(panel + (size_t)l*2*b + b, D->M + (size_t)l*ld + panel_lc, b*sizeof(double));
+            }
+
+            factor_panel(D, panel, k0, b, ipiv, pivot_row);
+
+            // V volta para as colunas do painel; os fatores são -C
+            #pragma omp parallel for schedule(static)
+            for (int l = 0; l < m; l++) {
+                memcpy(D->M + (size_t)l*ld + panel_lc, panel + (size_t)l*2*b, b*sizeof(double));
+                for (int j = 0; j < b; j++) {
+                    factors[(size_t)l*b + j] = -panel[(size_t)l*2*b + b + j];
+                }
+            }
+            if (owns_pivots) {
+                for (int r = 0; r < b; r++) {
+                    memcpy(pivot_block + (size_t)r*b, panel + (size_t)(pivot_lr + r)*2*b + b, b*sizeof(double));
+                }
+                factor_pivot_block(pivot_block, b);
+            }
+        }
+
+        // 2. Trocas e fatores do painel ao longo das linhas de processos
+        double t0 = get_time();
+        MPI_Bcast(ipiv + k0, b, MPI_INT, panel_pcol, D->row_comm);
+        MPI_Bcast(factors, m*b, MPI_DOUBLE, panel_pcol, D->row_comm);
+        if (owns_pivots) {
+            MPI_Bcast(pivot_block, b*b, MPI_DOUBLE, panel_pcol, D->row_comm);
+            memset(factors + (size_t)pivot_lr*b, 0, (size_t)b*b*sizeof(double));
+        }
+        comm_time += get_time() - t0;
+
+        // 3. Trocas de linhas nas demais colunas locais
+        for (int j = 0; j < b; j++) {
+            if (in_panel) {
+                swap_rows(D, D->M, ld, k0 + j, ipiv[k0 + j], 0, panel_lc);
+                swap_rows(D, D->M, ld, k0 + j, ipiv[k0 + j], panel_lc + b, ld);
+            } else {
+                swap_rows(D, D->M, ld, k0 + j, ipiv[k0 + j], 0, ld);
+            }
+        }
+
+        // 4. Linhas dos pivôs (já trocadas e resolvidas com a LU de D) ao
+        // longo das colunas de processos. Nas colunas do painel a solução não
+        // é usada
+        if (owns_pivots && ld > 0) {
+            memcpy(pivot_rows, D->M + (size_t)pivot_lr*ld, (size_t)b*ld*sizeof(double));
+            solve_pivot_rows(pivot_block, b, pivot_rows, ld);
+        }
+        t0 = get_time();
+        MPI_Bcast(pivot_rows, b*ld, MPI_DOUBLE, pivot_prow, D->col_comm);
+        comm_time += get_time() - t0;
+
+        // 5. Atualização local com o GEMM blocado (OpenMP) de Comum/gemm.c;
+        // as colunas do painel já guardam V
+        if (in_panel) {
+            update_columns(D, factors, pivot_rows, b, pivot_lr, owns_pivots, 0, panel_lc);
+            update_columns(D, factors, pivot_rows, b, pivot_lr, owns_pivots, panel_lc + b, ld);
+        } else {
+            update_columns(D, factors, pivot_rows, b, pivot_lr, owns_pivots, 0, ld);
+        }
+    }
+
+    // Desfaz as trocas de linhas trocando as colunas na ordem inversa
+    for (int k = n - 1; k >= 0; k--) {
+        if (ipiv[k] != k) {
+            swap_columns(D, k, ipiv[k], column);
+        }
+    }
+
+    free(ipiv);
+    free(panel);
+    free(factors);
+    free(pivot_block);
+    free(pivot_rows);
+    free(pivot_row);
+    free(column);
+}
+
+// y = M*x com x e y completos (n) em todos os processos: cada processo soma
+// os seus blocos e as somas parciais são reduzidas
+static void distributed_matvec(const dist_matrix_t *D, const double *x, double *y, double *partial, double *x_local) {
+    int m = D->local_rows, ld = D->local_cols;
+
+    for (int l = 0; l < ld; l++) {
+        x_local[l] = x[D->col_global[l]];
+    }
+    memset(partial, 0, D->n*sizeof(double));
+
+    #pragma omp parallel for schedule(static)
+    for (int l = 0; l < m; l++) {
+        const double *row = D->M + (size_t)l*ld;
+        double sum = 0.0;
+        for (int j = 0; j < ld; j++) {
+            sum += row[j] * x_local[j];
+        }
+        partial[D->row_global[l]] = sum;
+    }
+
+    MPI_Allreduce(partial, y, D->n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+}
+
+// Teste de Freivalds distribuído, sem guardar A e A^-1 ao mesmo tempo: com a
+// inversa em D->M calcula z = A^-1 * x para cada sonda, relê A do arquivo de
+// entrada para D->M e retorna max ||A*z - x||_inf. Nenhum processo tem A e
+// A^-1 inteiras para invmat_validate_freivalds, mas as sondas são as mesmas
+// dela para a mesma semente
+double validate_inverse_freivalds(dist_matrix_t *D, const char *input_filename, const file_info_t *info, int probes,
+                                  unsigned int seed) {
+    int n = D->n;
+    double *x = (double*)checked_malloc((size_t)probes*n*sizeof(double));
+    double *z = (double*)checked_malloc((size_t)probes*n*sizeof(double));
+    double *y = (double*)checked_malloc(n*sizeof(double));
+    double *partial = (double*)checked_malloc(n*sizeof(double));
+    double *x_local = (double*)checked_malloc(D->local_cols*sizeof(double));
+
+    // Vetores de sinais aleatórios, sorteados no processo 0
+    if (D->rank == 0) {
+        for (size_t i = 0; i < (size_t)probes*n; i++) {
+            x[i] = (rand_r(&seed) & 1) ? 1.0 : -1.0;
+        }
+    }
+    MPI_Bcast(x, probes*n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    for (int p = 0; p < probes; p++) {
+        distributed_matvec(D, x + (size_t)p*n, z + (size_t)p*n, partial, x_local);
+    }
+
+    // A inversa já está no arquivo de saída: D->M volta a ser A
+    file_info_t copy = *info;
+    read_distributed(input_filename, 0, &copy, D);
+
+    double residual = 0.0;
+    for (int p = 0; p < probes; p++) {
+        distributed_matvec(D, z + (size_t)p*n, y, partial, x_local);
+        for (int i = 0; i < n; i++) {
+            double r = fabs(y[i] - x[(size_t)p*n + i]);
+            if (r > residual) {
+                residual = r;
+            }
+        }
+    }
+
+    free(x);
+    free(z);
+    free(y);
+    free(partial);
+    free(x_local);
+    return residual;
+}
+
+// Retira de argv as opções, aceitas em qualquer posição: --grade=PxQ e --sondas=K
+void parse_options(int *argc, char *argv[], int *grid_rows, int *grid_cols, int *probes) {
+    int kept = 1;
+    for (int a = 1; a < *argc; a++) {
+        if (strncmp(argv[a], "--grade=", 8) == 0) {
+            if (sscanf(argv[a] + 8, "%dx%d", grid_rows, grid_cols) != 2 || *grid_rows <= 0 || *grid_cols <= 0) {
+                *grid_rows = -1;
+            }
+        } else if (strncmp(argv[a], "--sondas=", 9) == 0) {
+            *probes = atoi(argv[a] + 9);
+        } else {
+            argv[kept++] = argv[a];
+        }
+    }
+    *argc = kept;
+    argv[kept] = NULL;
+}
+
+int main(int argc, char *argv[]) {
+    // Só a thread principal de cada processo chama o MPI
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+    int rank, nprocs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+    int grid_rows = 0, grid_cols = 0;
+    int probes = VALIDATION_PROBES;
+    parse_options(&argc, argv, &grid_rows, &grid_cols, &probes);
+
+    if (argc < 3 || argc > 4) {
+        if (rank == 0) {
+            fprintf(stderr, "Uso: mpirun -np <P> %s <tamanho_da_matriz> <num_threads> [tamanho_bloco] [--grade=PxQ] [--sondas=K]\n", argv[0]);
+            fprintf(stderr, "tamanho_bloco: largura dos blocos da distribuição 2D cíclica (padrão %d)\n", DEFAULT_BLOCK_SIZE);
+            fprintf(stderr, "--grade=PxQ: grade de P x Q processos (padrão: a mais quadrada possível, P >= Q)\n");
+        }
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    int n = atoi(argv[1]);
+    int num_threads = atoi(argv[2]);
+    int nb = (argc == 4) ? atoi(argv[3]) : DEFAULT_BLOCK_SIZE;
+
+    const char *error = NULL;
+    if (n <= 0) {
+        error = "Erro: O tamanho da matriz deve ser positivo";
+    } else if (num_threads <= 0) {
+        error = "Erro: O número de threads deve ser positivo";
+    } else if (nb <= 0) {
+        error = "Erro: O tamanho do bloco deve ser positivo";
+    } else if (grid_rows < 0) {
+        error = "Erro: A grade deve ter o formato PxQ, com P e Q positivos";
+    } else if (probes <= 0) {
+        error = "Erro: O número de sondas deve ser positivo";
+    }
+    if (error != NULL) {
+        if (rank == 0) {
+            fprintf(stderr, "%s\n", error);
+        }
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    // Define o nome dos arquivos de entrada e saída
+    char input_filename[100], output_filename[100];
+    sprintf(input_filename, "matrix_%d.bin", n);
+    sprintf(output_filename, "inverse_matrix_%d_mpi_%d.bin", n, nprocs);
+
+    // Se o arquivo de entrada não existir, o processo 0 gera e salva uma matriz
+    if (rank == 0) {
+        if (access(input_filename, F_OK) != 0) {
+            printf("Arquivo de matriz de entrada não encontrado. Gerando nova matriz %dx%d...\n", n, n);
+            matrix_map_t map;
+            double *A = matrix_file_create(input_filename, n, MATRIX_ROW_MAJOR, &map);
+            invmat_generate(A, n, (unsigned int)time(NULL));
+            matrix_file_close(&map);
+            printf("Matriz salva em %s\n", input_filename);
+        } else {
+            printf("Carregando matriz %dx%d do arquivo %s\n", n, n, input_filename);
+        }
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    // Seleciona os kernels SIMD de acordo com a CPU (ou IM_ISA)
+    simd_init();
+    omp_set_num_threads(num_threads);
+
+    dist_matrix_t D;
+    setup_grid(&D, n, nb, grid_rows, grid_cols);
+
+    // Leitura paralela: cabeçalho no processo 0, checksum em cadeia e blocos
+    // de cada processo numa leitura coletiva
+    MPI_Barrier(MPI_COMM_WORLD);
+    double read_start = get_time();
+    file_info_t info;
+    MPI_File fh;
+    if (MPI_File_open(MPI_COMM_WORLD, input_filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (rank == 0) {
+            fprintf(stderr, "Erro ao abrir o arquivo %s para leitura\n", input_filename);
+        }
+        abort_all();
+    }
+    read_file_info(fh, input_filename, n, rank, &info);
+    MPI_File_close(&fh);
+    if (info.n != n) {
+        if (rank == 0) {
+            fprintf(stderr, "Erro: %s contém uma matriz %dx%d\n", input_filename, info.n, info.n);
+        }
+        abort_all();
+    }
+    read_distributed(input_filename, 1, &info, &D);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double read_time = get_time() - read_start;
+
+    if (rank == 0) {
+        const char *format = info.legacy ? "legado (sem cabeçalho)"
+                           : info.elem_type == MATRIX_ELEM_F32
+                               ? (info.layout == MATRIX_ROW_MAJOR ? "v1, float32, por linhas" : "v1, float32, por colunas")
+                               : (info.layout == MATRIX_ROW_MAJOR ? "v1, float64, por linhas" : "v1, float64, por colunas");
+        printf("Formato do arquivo: %s (lido e verificado em %.3f s)\n", format, read_time);
+        printf("Kernels SIMD: %s, micro-kernel do GEMM: %s\n", simd_isa_name(), gemm_kernel_name());
+        printf("Calculando inversa (MPI, grade %dx%d, blocos de %d, %d threads por processo)...\n",
+               D.grid_rows, D.grid_cols, nb, num_threads);
+    }
+
+    // Mede o tempo de execução (o do processo mais lento, pelas barreiras)
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = get_time();
+    calculate_inverse_distributed(&D, num_threads);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double execution_time = get_time() - start_time;
+
+    double max_comm_time;
+    MPI_Reduce(&comm_time, &max_comm_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    // A inversa é gravada na mesma ordem da entrada (uma matriz por colunas é
+    // A^T, e inv(A^T) = inv(A)^T)
+    double write_start = get_time();
+    write_distributed(output_filename, info.layout, &D);
+    double write_time = get_time() - write_start;
+
+    // Valida a matriz inversa calculada com o teste de Freivalds distribuído
+    double validation_start = get_time();
+    double residual = validate_inverse_freivalds(&D, input_filename, &info, probes, (unsigned int)time(NULL));
+    if (rank == 0) {
+        if (residual < 1e-6) {
+            printf("Validação da matriz inversa (Freivalds, %d sondas): SUCESSO, resíduo ||A*(A^-1*x) - x||_inf = %.3e", probes, residual);
+        } else {
+            printf("Validação da matriz inversa (Freivalds, %d sondas): FALHA, resíduo ||A*(A^-1*x) - x||_inf = %.3e", probes, residual);
+        }
+        printf(" (%.3f s)\n", get_time() - validation_start);
+        printf("Matriz inversa salva em %s (%.3f s)\n", output_filename, write_time);
+
+        // Grava os resultados em um arquivo CSV para análise de escalabilidade
+        FILE *results_file = fopen("results_mpi.csv", "a");
+        if (results_file == NULL) {
+            fprintf(stderr, "Erro ao abrir o arquivo de resultados results_mpi.csv\n");
+        } else {
+            // Verifica se o arquivo está vazio para adicionar o cabeçalho
+            fseek(results_file, 0, SEEK_END);
+            long size = ftell(results_file);
+
+            if (size == 0) {
+                fprintf(results_file, "tamanho_matriz,num_processos,grade,num_threads,tamanho_bloco,tempo_execucao,tempo_comunicacao,tempo_leitura,tempo_escrita\n");
+            }
+
+            // Adiciona os resultados
+            fprintf(results_file, "%d,%d,%dx%d,%d,%d,%.6f,%.6f,%.6f,%.6f\n", n, nprocs, D.grid_rows, D.grid_cols,
+                    num_threads, nb, execution_time, max_comm_time, read_time, write_time);
+            fclose(results_file);
+        }
+
+        printf("Tamanho da matriz: %d x %d\n", n, n);
+        printf("Processos: %d (grade %dx%d), %d threads por processo\n", nprocs, D.grid_rows, D.grid_cols, num_threads);
+        printf("Tempo em comunicação (processo mais lento): %.6f segundos\n", max_comm_time);
+        printf("Tempo de execução: %.6f segundos\n", execution_time);
+    }
+
+    free_grid(&D);
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+}
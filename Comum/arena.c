@@ -0,0 +1,149 @@
+/*
+ * arena.c - Arena em páginas grandes: mmap com MAP_HUGETLB ou região alinhada
+ * a 2 MB com madvise(MADV_HUGEPAGE), alocação sequencial alinhada a 64 bytes
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "arena.h"
+
+static size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// Páginas grandes desabilitadas com IM_HUGEPAGES=0
+static int huge_pages_enabled(void) {
+    const char *env = getenv("IM_HUGEPAGES");
+    return env == NULL || strcmp(env, "0") != 0;
+}
+
+int arena_try_create(arena_t *arena, size_t bytes) {
+    size_t size = round_up(bytes > 0 ? bytes : 1, ARENA_HUGE_PAGE);
+    int huge = huge_pages_enabled();
+
+    arena->size = size;
+    arena->used = 0;
+
+#ifdef MAP_HUGETLB
+    // Páginas grandes reservadas: só existem se o administrador criou o pool
+    if (huge) {
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            arena->base = (char*)p;
+            arena->backing = ARENA_HUGETLB;
+            return 1;
+        }
+    }
+#endif
+
+    // Região com 2 MB a mais, recortada para começar e terminar em fronteiras
+    // de 2 MB (o kernel só usa uma página grande em um trecho alinhado)
+    char *raw = (char*)mmap(NULL, size + ARENA_HUGE_PAGE, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        arena->base = NULL;
+        arena->size = 0;
+        return 0;
+    }
+    char *base = (char*)round_up((uintptr_t)raw, ARENA_HUGE_PAGE);
+    size_t head = base - raw;
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    munmap(base + size, ARENA_HUGE_PAGE - head);
+
+    arena->base = base;
+    arena->backing = ARENA_SMALL_PAGES;
+#ifdef MADV_HUGEPAGE
+    if (huge && madvise(base, size, MADV_HUGEPAGE) == 0) {
+        arena->backing = ARENA_THP;
+    }
+#endif
+#ifdef MADV_NOHUGEPAGE
+    if (!huge) {
+        // Com THP em "always", evita páginas grandes também sem o madvise
+        madvise(base, size, MADV_NOHUGEPAGE);
+    }
+#endif
+    return 1;
+}
+
+void arena_create(arena_t *arena, size_t bytes) {
+    if (!arena_try_create(arena, bytes)) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void arena_destroy(arena_t *arena) {
+    if (arena->base != NULL) {
+        munmap(arena->base, arena->size);
+    }
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+void *arena_alloc(arena_t *arena, size_t bytes) {
+    size_t offset = round_up(arena->used, ARENA_ALIGN);
+    if (offset + bytes > arena->size) {
+        fprintf(stderr, "Erro: A arena de %zu bytes não comporta mais %zu bytes\n", arena->size, bytes);
+        exit(EXIT_FAILURE);
+    }
+    arena->used = offset + bytes;
+    return arena->base + offset;
+}
+
+void arena_reset(arena_t *arena) {
+    arena->used = 0;
+}
+
+long arena_huge_bytes(const arena_t *arena) {
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if (f == NULL) {
+        return -1;
+    }
+
+    // Os campos de um mapeamento vêm depois da linha "início-fim ..."; o
+    // kernel pode dividir a arena em mais de um mapeamento (ex.: após madvise)
+    char line[256];
+    int inside = 0;
+    long kb_total = 0;
+    int found = 0;
+    uintptr_t lo = (uintptr_t)arena->base, hi = lo + arena->size;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        unsigned long start, end;
+        long kb;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2 && strchr(line, '-') < strchr(line, ' ')) {
+            inside = start >= lo && end <= hi;
+            found |= inside;
+        } else if (inside && (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1 ||
+                              sscanf(line, "Private_Hugetlb: %ld kB", &kb) == 1)) {
+            kb_total += kb;
+        }
+    }
+    fclose(f);
+    return found ? kb_total * 1024 : -1;
+}
+
+const char *arena_backing_name(const arena_t *arena) {
+    switch (arena->backing) {
+        case ARENA_HUGETLB: return "páginas grandes reservadas (MAP_HUGETLB)";
+        case ARENA_THP: return "páginas grandes transparentes (MADV_HUGEPAGE)";
+        default: return "páginas de 4 KB";
+    }
+}
+
+long arena_page_faults(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt + usage.ru_majflt;
+}
@@ -0,0 +1,56 @@
+/*
+ * arena.h - Arena de memória para os buffers de trabalho reaproveitados entre
+ * execuções: uma única região reservada com mmap, em páginas grandes de 2 MB
+ * quando o sistema permite, e dividida em blocos alinhados a 64 bytes
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_HUGE_PAGE (2u << 20)  // tamanho de uma página grande (x86-64)
+#define ARENA_ALIGN 64              // alinhamento dos blocos (linha de cache)
+
+// Como as páginas da arena foram obtidas
+typedef enum {
+    ARENA_SMALL_PAGES = 0,  // páginas de 4 KB (IM_HUGEPAGES=0 ou sem suporte)
+    ARENA_THP,              // páginas grandes transparentes (madvise MADV_HUGEPAGE)
+    ARENA_HUGETLB           // páginas grandes reservadas (MAP_HUGETLB)
+} arena_backing_t;
+
+typedef struct {
+    char *base;             // início, alinhado a ARENA_HUGE_PAGE
+    size_t size;            // múltiplo de ARENA_HUGE_PAGE
+    size_t used;
+    arena_backing_t backing;
+} arena_t;
+
+// Reserva pelo menos bytes bytes. Tenta MAP_HUGETLB (pool de
+// /proc/sys/vm/nr_hugepages) e, sem ele, uma região alinhada a 2 MB com
+// MADV_HUGEPAGE. IM_HUGEPAGES=0 força páginas de 4 KB (para comparação).
+// As páginas só são alocadas pelo kernel no primeiro toque
+void arena_create(arena_t *arena, size_t bytes);
+
+// Como arena_create, mas retorna 0 (arena vazia) em vez de terminar o
+// programa quando o mmap falha; 1 em caso de sucesso
+int arena_try_create(arena_t *arena, size_t bytes);
+void arena_destroy(arena_t *arena);
+
+// Próximo bloco de bytes bytes, alinhado a ARENA_ALIGN. Erro fatal se a
+// arena não comporta o bloco
+void *arena_alloc(arena_t *arena, size_t bytes);
+
+// Libera todos os blocos de uma vez (as páginas continuam mapeadas)
+void arena_reset(arena_t *arena);
+
+// Bytes da arena em páginas grandes no momento (AnonHugePages ou
+// Private_Hugetlb do mapeamento em /proc/self/smaps). -1 se não souber
+long arena_huge_bytes(const arena_t *arena);
+
+const char *arena_backing_name(const arena_t *arena);
+
+// Faltas de página do processo até agora (menores + maiores, getrusage)
+long arena_page_faults(void);
+
+#endif
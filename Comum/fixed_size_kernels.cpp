@@ -0,0 +1,281 @@
+/*
+ * fixed_size_kernels.cpp - Kernels de inversão especializados por tamanho.
+ * Para n <= 16 o caminho genérico gasta a maior parte do tempo em controle de
+ * laço, no malloc/memcpy de temp_A e em índices calculados em tempo de
+ * execução. Aqui o tamanho é parâmetro de template: os laços têm limites
+ * constantes (desenrolados pelo compilador), os dados ficam na pilha e não
+ * há alocação no heap
+ */
+
+#include <math.h>
+
+#include "fixed_size_kernels.h"
+
+namespace {
+
+// Pivô mínimo do caminho genérico (calculate_inverse_row_oriented)
+const double PIVOT_MIN = 1e-10;
+
+// Razão |det| / (produto das normas das linhas) abaixo da qual a forma
+// fechada perde precisão; nesse caso o Gauss-Jordan com pivotamento decide
+const double COFACTOR_MIN_RATIO = 1e-12;
+
+// Desigualdade de Hadamard: |det| <= produto das normas das linhas
+template <int N>
+inline bool cofactor_is_safe(const double *A, double det) {
+    double bound = 1.0;
+    for (int i = 0; i < N; i++) {
+        double norm = 0.0;
+        for (int j = 0; j < N; j++) {
+            norm += A[i*N + j] * A[i*N + j];
+        }
+        bound *= sqrt(norm);
+    }
+    return fabs(det) > COFACTOR_MIN_RATIO * bound;
+}
+
+// Critério de singularidade do caminho genérico para a forma fechada: os pivôs
+// da eliminação com pivotamento parcial (os mesmos do Gauss-Jordan, que só
+// difere nas linhas acima do pivô) devem ser >= PIVOT_MIN. Só A é eliminada
+template <int N>
+inline bool pivots_are_safe(const double *A) {
+    double a[N][N];
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            a[i][j] = A[i*N + j];
+        }
+    }
+    for (int k = 0; k < N; k++) {
+        int pivot_row = k;
+        double pivot_value = fabs(a[k][k]);
+        for (int i = k + 1; i < N; i++) {
+            if (fabs(a[i][k]) > pivot_value) {
+                pivot_value = fabs(a[i][k]);
+                pivot_row = i;
+            }
+        }
+        if (pivot_value < PIVOT_MIN) {
+            return false;
+        }
+        if (pivot_row != k) {
+            for (int j = k; j < N; j++) {
+                double temp = a[k][j];
+                a[k][j] = a[pivot_row][j];
+                a[pivot_row][j] = temp;
+            }
+        }
+        for (int i = k + 1; i < N; i++) {
+            double factor = a[i][k] / a[k][k];
+            for (int j = k + 1; j < N; j++) {
+                a[i][j] -= factor * a[k][j];
+            }
+        }
+    }
+    return true;
+}
+
+// Forma fechada por cofatores (adjunta / determinante), N = 2, 3 e 4
+template <int N>
+int invert_cofactor(const double *A, double *Ainv);
+
+template <>
+int invert_cofactor<2>(const double *A, double *Ainv) {
+    double det = A[0]*A[3] - A[1]*A[2];
+    if (!cofactor_is_safe<2>(A, det)) {
+        return -1;
+    }
+    double inv_det = 1.0 / det;
+    Ainv[0] =  A[3] * inv_det;
+    Ainv[1] = -A[1] * inv_det;
+    Ainv[2] = -A[2] * inv_det;
+    Ainv[3] =  A[0] * inv_det;
+    return 1;
+}
+
+template <>
+int invert_cofactor<3>(const double *A, double *Ainv) {
+    double c00 = A[4]*A[8] - A[5]*A[7];
+    double c01 = A[5]*A[6] - A[3]*A[8];
+    double c02 = A[3]*A[7] - A[4]*A[6];
+    double det = A[0]*c00 + A[1]*c01 + A[2]*c02;
+    if (!cofactor_is_safe<3>(A, det)) {
+        return -1;
+    }
+    double inv_det = 1.0 / det;
+    Ainv[0] = c00 * inv_det;
+    Ainv[1] = (A[2]*A[7] - A[1]*A[8]) * inv_det;
+    Ainv[2] = (A[1]*A[5] - A[2]*A[4]) * inv_det;
+    Ainv[3] = c01 * inv_det;
+    Ainv[4] = (A[0]*A[8] - A[2]*A[6]) * inv_det;
+    Ainv[5] = (A[2]*A[3] - A[0]*A[5]) * inv_det;
+    Ainv[6] = c02 * inv_det;
+    Ainv[7] = (A[1]*A[6] - A[0]*A[7]) * inv_det;
+    Ainv[8] = (A[0]*A[4] - A[1]*A[3]) * inv_det;
+    return 1;
+}
+
+template <>
+int invert_cofactor<4>(const double *A, double *Ainv) {
+    // Menores 2x2 das duas primeiras e das duas últimas linhas
+    double s0 = A[0]*A[5] - A[4]*A[1];
+    double s1 = A[0]*A[6] - A[4]*A[2];
+    double s2 = A[0]*A[7] - A[4]*A[3];
+    double s3 = A[1]*A[6] - A[5]*A[2];
+    double s4 = A[1]*A[7] - A[5]*A[3];
+    double s5 = A[2]*A[7] - A[6]*A[3];
+
+    double c5 = A[10]*A[15] - A[14]*A[11];
+    double c4 = A[9]*A[15] - A[13]*A[11];
+    double c3 = A[9]*A[14] - A[13]*A[10];
+    double c2 = A[8]*A[15] - A[12]*A[11];
+    double c1 = A[8]*A[14] - A[12]*A[10];
+    double c0 = A[8]*A[13] - A[12]*A[9];
+
+    double det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+    if (!cofactor_is_safe<4>(A, det)) {
+        return -1;
+    }
+    double inv_det = 1.0 / det;
+
+    Ainv[0]  = ( A[5]*c5  - A[6]*c4  + A[7]*c3)  * inv_det;
+    Ainv[1]  = (-A[1]*c5  + A[2]*c4  - A[3]*c3)  * inv_det;
+    Ainv[2]  = ( A[13]*s5 - A[14]*s4 + A[15]*s3) * inv_det;
+    Ainv[3]  = (-A[9]*s5  + A[10]*s4 - A[11]*s3) * inv_det;
+
+    Ainv[4]  = (-A[4]*c5  + A[6]*c2  - A[7]*c1)  * inv_det;
+    Ainv[5]  = ( A[0]*c5  - A[2]*c2  + A[3]*c1)  * inv_det;
+    Ainv[6]  = (-A[12]*s5 + A[14]*s2 - A[15]*s1) * inv_det;
+    Ainv[7]  = ( A[8]*s5  - A[10]*s2 + A[11]*s1) * inv_det;
+
+    Ainv[8]  = ( A[4]*c4  - A[5]*c2  + A[7]*c0)  * inv_det;
+    Ainv[9]  = (-A[0]*c4  + A[1]*c2  - A[3]*c0)  * inv_det;
+    Ainv[10] = ( A[12]*s4 - A[13]*s2 + A[15]*s0) * inv_det;
+    Ainv[11] = (-A[8]*s4  + A[9]*s2  - A[11]*s0) * inv_det;
+
+    Ainv[12] = (-A[4]*c3  + A[5]*c1  - A[6]*c0)  * inv_det;
+    Ainv[13] = ( A[0]*c3  - A[1]*c1  + A[2]*c0)  * inv_det;
+    Ainv[14] = (-A[12]*s3 + A[13]*s1 - A[14]*s0) * inv_det;
+    Ainv[15] = ( A[8]*s3  - A[9]*s1  + A[10]*s0) * inv_det;
+    return 1;
+}
+
+// Gauss-Jordan com pivotamento parcial para N fixo, mesmo algoritmo de
+// calculate_inverse_row_oriented, com as matrizes de trabalho na pilha
+template <int N>
+int invert_gauss_jordan(const double *A, double *Ainv) {
+    double a[N][N];
+    double inv[N][N];
+
+    #pragma GCC unroll 16
+    for (int i = 0; i < N; i++) {
+        #pragma GCC unroll 16
+        for (int j = 0; j < N; j++) {
+            a[i][j] = A[i*N + j];
+            inv[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    for (int k = 0; k < N; k++) {
+        // Encontra o pivô (valor máximo na coluna k)
+        int pivot_row = k;
+        double pivot_value = fabs(a[k][k]);
+        for (int i = k + 1; i < N; i++) {
+            double abs_value = fabs(a[i][k]);
+            if (abs_value > pivot_value) {
+                pivot_value = abs_value;
+                pivot_row = i;
+            }
+        }
+
+        // Se o pivô for muito pequeno, a matriz pode ser singular
+        if (pivot_value < PIVOT_MIN) {
+            return 0;
+        }
+
+        // Troca as linhas se necessário
+        if (pivot_row != k) {
+            #pragma GCC unroll 16
+            for (int j = 0; j < N; j++) {
+                double temp = a[k][j];
+                a[k][j] = a[pivot_row][j];
+                a[pivot_row][j] = temp;
+
+                temp = inv[k][j];
+                inv[k][j] = inv[pivot_row][j];
+                inv[pivot_row][j] = temp;
+            }
+        }
+
+        // Normaliza a linha do pivô
+        double pivot = a[k][k];
+        #pragma GCC unroll 16
+        for (int j = 0; j < N; j++) {
+            a[k][j] /= pivot;
+            inv[k][j] /= pivot;
+        }
+
+        // Eliminação de Gauss
+        #pragma GCC unroll 16
+        for (int i = 0; i < N; i++) {
+            if (i != k) {
+                double factor = a[i][k];
+                #pragma GCC unroll 16
+                for (int j = 0; j < N; j++) {
+                    a[i][j] -= factor * a[k][j];
+                    inv[i][j] -= factor * inv[k][j];
+                }
+            }
+        }
+    }
+
+    #pragma GCC unroll 16
+    for (int i = 0; i < N; i++) {
+        #pragma GCC unroll 16
+        for (int j = 0; j < N; j++) {
+            Ainv[i*N + j] = inv[i][j];
+        }
+    }
+    return 1;
+}
+
+// Kernel usado para cada N: cofatores até 4x4 (caindo para o Gauss-Jordan
+// quando a forma fechada não é confiável), Gauss-Jordan desenrolado acima.
+// Antes dos cofatores, a singularidade é decidida pelos pivôs, como no
+// caminho genérico (o teste de Hadamard só mede a precisão da forma fechada)
+template <int N>
+int invert_fixed(const double *A, double *Ainv) {
+    if constexpr (N >= 2 && N <= 4) {
+        if (!pivots_are_safe<N>(A)) {
+            return 0;
+        }
+        int result = invert_cofactor<N>(A, Ainv);
+        if (result != -1) {
+            return result;
+        }
+    }
+    return invert_gauss_jordan<N>(A, Ainv);
+}
+
+} // namespace
+
+extern "C" int invert_fixed_size(const double *A, double *Ainv, int n) {
+    switch (n) {
+        case 1:  return invert_fixed<1>(A, Ainv);
+        case 2:  return invert_fixed<2>(A, Ainv);
+        case 3:  return invert_fixed<3>(A, Ainv);
+        case 4:  return invert_fixed<4>(A, Ainv);
+        case 5:  return invert_fixed<5>(A, Ainv);
+        case 6:  return invert_fixed<6>(A, Ainv);
+        case 7:  return invert_fixed<7>(A, Ainv);
+        case 8:  return invert_fixed<8>(A, Ainv);
+        case 9:  return invert_fixed<9>(A, Ainv);
+        case 10: return invert_fixed<10>(A, Ainv);
+        case 11: return invert_fixed<11>(A, Ainv);
+        case 12: return invert_fixed<12>(A, Ainv);
+        case 13: return invert_fixed<13>(A, Ainv);
+        case 14: return invert_fixed<14>(A, Ainv);
+        case 15: return invert_fixed<15>(A, Ainv);
+        case 16: return invert_fixed<16>(A, Ainv);
+        default: return -1;
+    }
+}
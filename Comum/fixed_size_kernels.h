@@ -0,0 +1,27 @@
+/*
+ * fixed_size_kernels.h - Inversão de matrizes pequenas (n <= 16) com kernels
+ * especializados em tempo de compilação (templates C++), chamáveis de C
+ */
+
+#ifndef FIXED_SIZE_KERNELS_H
+#define FIXED_SIZE_KERNELS_H
+
+// Maior tamanho com kernel especializado
+#define FIXED_SIZE_MAX 16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Inverte A (n x n, orientada a linhas) em Ainv usando apenas a pilha: forma
+// fechada por cofatores para 2x2, 3x3 e 4x4 e Gauss-Jordan com pivotamento
+// desenrolado até 16x16. Retorna 1 em caso de sucesso, 0 se a matriz parecer
+// singular (mesmo critério de pivô do caminho genérico) e -1 se não houver
+// kernel para este n (o chamador segue pelo caminho genérico)
+int invert_fixed_size(const double *A, double *Ainv, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,394 @@
+/*
+ * gemm.c - Produto de matrizes em cinco laços (Goto/BLIS):
+ *
+ *   jc: blocos de NC colunas de B/C          (painel de B no L3)
+ *   pc: blocos de KC da dimensão comum       (B e A empacotados)
+ *   tiles (MC linhas x NT colunas de C)      (bloco de A no L2, distribuídos
+ *                                             entre as threads)
+ *   jr: micro-painéis de NR colunas          (micro-painel de B no L1)
+ *   ir: micro-painéis de MR linhas           (micro-kernel MR x NR em
+ *                                             registradores)
+ *
+ * O empacotamento copia cada micro-painel para uma região contígua, na ordem
+ * em que o micro-kernel o lê (passo p: MR valores de A, NR valores de B), de
+ * modo que o laço interno só faz leituras sequenciais e alinhadas. As bordas
+ * são completadas com zeros; o resultado dos micro-kernels de borda passa por
+ * um tile temporário
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simd_kernels.h"
+#include "gemm.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GEMM_X86 1
+#include <immintrin.h>
+#endif
+
+// Profundidade dos blocos (KC x NR doubles de B ficam no L1: 16 a 48 KB)
+#define GEMM_KC 256
+// Largura do painel de B (KC x NC doubles, ~8 MB, no L3); múltiplo de 8 e 24
+#define GEMM_NC 4080
+// Maiores MR e NR entre os micro-kernels (tamanho do tile temporário)
+#define GEMM_MR_MAX 8
+#define GEMM_NR_MAX 24
+
+// Micro-kernel: c[MR x NR] += a * b, com a = micro-painel empacotado de A
+// (kc x MR) e b = micro-painel empacotado de B (kc x NR)
+typedef void (*gemm_kernel_fn)(int kc, const double *a, const double *b, double *c, int ldc);
+
+typedef struct {
+    const char *name;
+    gemm_kernel_fn kernel;
+    int mr, nr;     // dimensões do micro-kernel
+    int mc;         // linhas do bloco de A (MC x KC doubles no L2)
+    int nt;         // colunas de um tile de C distribuído às threads
+} gemm_config_t;
+
+// ---------------------------------------------------------------------------
+// Micro-kernel genérico 4 x 8 (o compilador vetoriza o laço em j)
+// ---------------------------------------------------------------------------
+
+static void kernel_generic(int kc, const double *a, const double *b, double *c, int ldc) {
+    double acc[4][8] = {{0.0}};
+    for (int p = 0; p < kc; p++) {
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 8; j++) {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+        a += 4;
+        b += 8;
+    }
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            c[i*ldc + j] += acc[i][j];
+        }
+    }
+}
+
+#ifdef GEMM_X86
+
+// ---------------------------------------------------------------------------
+// AVX2 + FMA: 6 x 8 (12 acumuladores + 2 registradores de B + 1 de A)
+// ---------------------------------------------------------------------------
+
+#define AVX2_ROW_FMA(r) do { \
+        __m256d a##r = _mm256_broadcast_sd(a + r); \
+        c##r##0 = _mm256_fmadd_pd(a##r, b0, c##r##0); \
+        c##r##1 = _mm256_fmadd_pd(a##r, b1, c##r##1); \
+    } while (0)
+
+#define AVX2_ROW_STORE(r) do { \
+        double *row = c + r*ldc; \
+        _mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), c##r##0)); \
+        _mm256_storeu_pd(row + 4, _mm256_add_pd(_mm256_loadu_pd(row + 4), c##r##1)); \
+    } while (0)
+
+__attribute__((target("avx2,fma")))
+static void kernel_avx2(int kc, const double *a, const double *b, double *c, int ldc) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+    for (int p = 0; p < kc; p++) {
+        __m256d b0 = _mm256_load_pd(b);
+        __m256d b1 = _mm256_load_pd(b + 4);
+        AVX2_ROW_FMA(0);
+        AVX2_ROW_FMA(1);
+        AVX2_ROW_FMA(2);
+        AVX2_ROW_FMA(3);
+        AVX2_ROW_FMA(4);
+        AVX2_ROW_FMA(5);
+        a += 6;
+        b += 8;
+    }
+
+    AVX2_ROW_STORE(0);
+    AVX2_ROW_STORE(1);
+    AVX2_ROW_STORE(2);
+    AVX2_ROW_STORE(3);
+    AVX2_ROW_STORE(4);
+    AVX2_ROW_STORE(5);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512: 8 x 24 (24 acumuladores + 3 registradores de B + 1 de A)
+// ---------------------------------------------------------------------------
+
+#define AVX512_ROW_FMA(r) do { \
+        __m512d a##r = _mm512_set1_pd(a[r]); \
+        c##r##0 = _mm512_fmadd_pd(a##r, b0, c##r##0); \
+        c##r##1 = _mm512_fmadd_pd(a##r, b1, c##r##1); \
+        c##r##2 = _mm512_fmadd_pd(a##r, b2, c##r##2); \
+    } while (0)
+
+#define AVX512_ROW_STORE(r) do { \
+        double *row = c + r*ldc; \
+        _mm512_storeu_pd(row, _mm512_add_pd(_mm512_loadu_pd(row), c##r##0)); \
+        _mm512_storeu_pd(row + 8, _mm512_add_pd(_mm512_loadu_pd(row + 8), c##r##1)); \
+        _mm512_storeu_pd(row + 16, _mm512_add_pd(_mm512_loadu_pd(row + 16), c##r##2)); \
+    } while (0)
+
+#define AVX512_ROW_ZERO(r) \
+    __m512d c##r##0 = _mm512_setzero_pd(), c##r##1 = _mm512_setzero_pd(), c##r##2 = _mm512_setzero_pd()
+
+__attribute__((target("avx512f")))
+static void kernel_avx512(int kc, const double *a, const double *b, double *c, int ldc) {
+    AVX512_ROW_ZERO(0);
+    AVX512_ROW_ZERO(1);
+    AVX512_ROW_ZERO(2);
+    AVX512_ROW_ZERO(3);
+    AVX512_ROW_ZERO(4);
+    AVX512_ROW_ZERO(5);
+    AVX512_ROW_ZERO(6);
+    AVX512_ROW_ZERO(7);
+
+    for (int p = 0; p < kc; p++) {
+        __m512d b0 = _mm512_load_pd(b);
+        __m512d b1 = _mm512_load_pd(b + 8);
+        __m512d b2 = _mm512_load_pd(b + 16);
+        AVX512_ROW_FMA(0);
+        AVX512_ROW_FMA(1);
+        AVX512_ROW_FMA(2);
+        AVX512_ROW_FMA(3);
+        AVX512_ROW_FMA(4);
+        AVX512_ROW_FMA(5);
+        AVX512_ROW_FMA(6);
+        AVX512_ROW_FMA(7);
+        a += 8;
+        b += 24;
+    }
+
+    AVX512_ROW_STORE(0);
+    AVX512_ROW_STORE(1);
+    AVX512_ROW_STORE(2);
+    AVX512_ROW_STORE(3);
+    AVX512_ROW_STORE(4);
+    AVX512_ROW_STORE(5);
+    AVX512_ROW_STORE(6);
+    AVX512_ROW_STORE(7);
+}
+
+#endif
+
+static const gemm_config_t config_generic = { "genérico 4x8", kernel_generic, 4, 8, 64, 128 };
+#ifdef GEMM_X86
+static const gemm_config_t config_avx2 = { "avx2 6x8", kernel_avx2, 6, 8, 72, 128 };
+static const gemm_config_t config_avx512 = { "avx512 8x24", kernel_avx512, 8, 24, 96, 384 };
+#endif
+
+// Micro-kernel correspondente ao nível escolhido por simd_init()
+static const gemm_config_t *select_config(void) {
+#ifdef GEMM_X86
+    switch (simd_isa_level()) {
+        case ISA_AVX512:
+            return &config_avx512;
+        case ISA_AVX2:
+            return &config_avx2;
+        default:
+            break;
+    }
+#endif
+    return &config_generic;
+}
+
+const char *gemm_kernel_name(void) {
+    return select_config()->name;
+}
+
+// ---------------------------------------------------------------------------
+// Empacotamento
+// ---------------------------------------------------------------------------
+
+// Micro-painel de A: linhas [i0, i0+mr) x colunas [p0, p0+kc), multiplicado
+// por alpha, gravado como kc grupos de mr valores (linhas fora de m = 0)
+static void pack_a_panel(const double *A, int lda, int m, int i0, int p0, int kc, int mr,
+                         double alpha, double *dst) {
+    for (int r = 0; r < mr; r++) {
+        int i = i0 + r;
+        if (i < m) {
+            const double *src = A + (size_t)i*lda + p0;
+            for (int p = 0; p < kc; p++) {
+                dst[p*mr + r] = alpha * src[p];
+            }
+        } else {
+            for (int p = 0; p < kc; p++) {
+                dst[p*mr + r] = 0.0;
+            }
+        }
+    }
+}
+
+// Micro-painel de B: linhas [p0, p0+kc) x colunas [j0, j0+nr), gravado como
+// kc grupos de nr valores (colunas fora de n_end = 0)
+static void pack_b_panel(const double *B, int ldb, int n_end, int p0, int j0, int kc, int nr,
+                         double *dst) {
+    int cols = (n_end - j0 < nr) ? n_end - j0 : nr;
+    for (int p = 0; p < kc; p++) {
+        const double *src = B + (size_t)(p0 + p)*ldb + j0;
+        double *d = dst + p*nr;
+        memcpy(d, src, cols*sizeof(double));
+        for (int j = cols; j < nr; j++) {
+            d[j] = 0.0;
+        }
+    }
+}
+
+static double *alloc_aligned(size_t elems) {
+    // Tamanho múltiplo de 64 bytes, exigido por aligned_alloc
+    size_t bytes = (elems*sizeof(double) + 63) & ~(size_t)63;
+    double *p = (double*)aligned_alloc(64, bytes);
+    if (p == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// Produto
+// ---------------------------------------------------------------------------
+
+// Tile de C: linhas [i0, i0+mb) x colunas [j0, j0+nb) do bloco atual, com A e
+// B já empacotados (apanel: micro-painéis de A a partir da linha i0; bpanel:
+// micro-painéis de B a partir da coluna j0)
+static void macro_kernel(const gemm_config_t *cfg, int kc, int mb, int nb,
+                         const double *apanel, const double *bpanel, double *C, int ldc) {
+    int mr = cfg->mr, nr = cfg->nr;
+    double edge[GEMM_MR_MAX * GEMM_NR_MAX];
+
+    for (int jr = 0; jr < nb; jr += nr) {
+        int cols = (nb - jr < nr) ? nb - jr : nr;
+        const double *b = bpanel + (size_t)(jr / nr) * kc * nr;
+
+        for (int ir = 0; ir < mb; ir += mr) {
+            int rows = (mb - ir < mr) ? mb - ir : mr;
+            const double *a = apanel + (size_t)(ir / mr) * kc * mr;
+            double *c = C + (size_t)ir*ldc + jr;
+
+            if (rows == mr && cols == nr) {
+                cfg->kernel(kc, a, b, c, ldc);
+            } else {
+                memset(edge, 0, sizeof(edge));
+                cfg->kernel(kc, a, b, edge, nr);
+                for (int i = 0; i < rows; i++) {
+                    for (int j = 0; j < cols; j++) {
+                        c[(size_t)i*ldc + j] += edge[i*nr + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Doubles de cada buffer de empacotamento, arredondados para manter o
+// segundo alinhado a 64 bytes logo depois do primeiro
+static size_t apack_elems(const gemm_config_t *cfg, int m, int k) {
+    int kc_max = (k < GEMM_KC) ? k : GEMM_KC;
+    size_t elems = (size_t)((m + cfg->mr - 1) / cfg->mr) * cfg->mr * kc_max;
+    return (elems + 7) & ~(size_t)7;
+}
+
+static size_t bpack_elems(const gemm_config_t *cfg, int n, int k) {
+    int nc_max = (n < GEMM_NC) ? n : GEMM_NC;
+    int kc_max = (k < GEMM_KC) ? k : GEMM_KC;
+    size_t elems = (size_t)((nc_max + cfg->nr - 1) / cfg->nr) * cfg->nr * kc_max;
+    return (elems + 7) & ~(size_t)7;
+}
+
+size_t gemm_workspace_size(int m, int n, int k) {
+    if (m <= 0 || n <= 0 || k <= 0) {
+        return 0;
+    }
+    const gemm_config_t *cfg = select_config();
+    return apack_elems(cfg, m, k) + bpack_elems(cfg, n, k);
+}
+
+void gemm(int m, int n, int k, double alpha, const double *A, int lda,
+          const double *B, int ldb, double beta, double *C, int ldc) {
+    size_t elems = gemm_workspace_size(m, n, k);
+    double *workspace = alloc_aligned(elems > 0 ? elems : 1);
+    gemm_workspace(m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, workspace);
+    free(workspace);
+}
+
+void gemm_workspace(int m, int n, int k, double alpha, const double *A, int lda,
+                    const double *B, int ldb, double beta, double *C, int ldc,
+                    double *workspace) {
+    if (m <= 0 || n <= 0) {
+        return;
+    }
+
+    // C = beta*C (com beta = 0, zera sem ler C)
+    if (beta != 1.0) {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < m; i++) {
+            double *row = C + (size_t)i*ldc;
+            if (beta == 0.0) {
+                memset(row, 0, n*sizeof(double));
+            } else {
+                for (int j = 0; j < n; j++) {
+                    row[j] *= beta;
+                }
+            }
+        }
+    }
+    if (k <= 0 || alpha == 0.0) {
+        return;
+    }
+
+    const gemm_config_t *cfg = select_config();
+    int mr = cfg->mr, nr = cfg->nr, mc = cfg->mc, nt = cfg->nt;
+
+    int m_panels = (m + mr - 1) / mr;
+    double *apack = workspace;
+    double *bpack = workspace + apack_elems(cfg, m, k);
+
+    #pragma omp parallel
+    {
+        for (int jc = 0; jc < n; jc += GEMM_NC) {
+            int nc = (n - jc < GEMM_NC) ? n - jc : GEMM_NC;
+            int n_panels = (nc + nr - 1) / nr;
+
+            for (int pc = 0; pc < k; pc += GEMM_KC) {
+                int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+
+                // Empacota B[pc.., jc..] e A[.., pc..] (as barreiras implícitas
+                // dos laços garantem os painéis completos antes do cálculo)
+                #pragma omp for schedule(static)
+                for (int jp = 0; jp < n_panels; jp++) {
+                    pack_b_panel(B, ldb, jc + nc, pc, jc + jp*nr, kc, nr,
+                                 bpack + (size_t)jp * kc * nr);
+                }
+                #pragma omp for schedule(static)
+                for (int ip = 0; ip < m_panels; ip++) {
+                    pack_a_panel(A, lda, m, ip*mr, pc, kc, mr, alpha,
+                                 apack + (size_t)ip * kc * mr);
+                }
+
+                // Tiles MC x NT de C, independentes entre si
+                int m_tiles = (m + mc - 1) / mc;
+                int n_tiles = (nc + nt - 1) / nt;
+                #pragma omp for collapse(2) schedule(dynamic)
+                for (int it = 0; it < m_tiles; it++) {
+                    for (int jt = 0; jt < n_tiles; jt++) {
+                        int i0 = it*mc, j0 = jt*nt;
+                        int mb = (m - i0 < mc) ? m - i0 : mc;
+                        int nb = (nc - j0 < nt) ? nc - j0 : nt;
+                        macro_kernel(cfg, kc, mb, nb,
+                                     apack + (size_t)(i0 / mr) * kc * mr,
+                                     bpack + (size_t)(j0 / nr) * kc * nr,
+                                     C + (size_t)i0*ldc + jc + j0, ldc);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+/*
+ * gemm.h - Produto de matrizes com empacotamento dos operandos, micro-kernel
+ * com blocagem em registradores e blocagem para L1/L2/L3 (esquema de
+ * Goto/BLIS), paralelizado com OpenMP sobre os tiles da saída
+ */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stddef.h>
+
+// C = alpha*A*B + beta*C, com matrizes orientadas a linhas: A (m x k, linhas
+// com lda doubles), B (k x n, ldb) e C (m x n, ldc). C não pode se sobrepor a
+// A nem a B. Com beta = 0, C não é lida (pode conter lixo). O micro-kernel
+// segue o nível escolhido por simd_init() (AVX-512, AVX2+FMA ou genérico).
+// Chamada fora de uma região paralela, usa as threads OpenMP disponíveis;
+// sem -fopenmp, roda serialmente
+void gemm(int m, int n, int k, double alpha, const double *A, int lda,
+          const double *B, int ldb, double beta, double *C, int ldc);
+
+// O mesmo produto com os buffers de empacotamento em workspace (alinhado a
+// 64 bytes, com gemm_workspace_size(m, n, k) doubles), para quem repete
+// produtos do mesmo tamanho sem alocar a cada chamada. O tamanho depende do
+// micro-kernel, então deve ser calculado depois de simd_init()
+size_t gemm_workspace_size(int m, int n, int k);
+void gemm_workspace(int m, int n, int k, double alpha, const double *A, int lda,
+                    const double *B, int ldb, double beta, double *C, int ldc,
+                    double *workspace);
+
+// Nome do micro-kernel em uso (ex.: "avx2 6x8"), para os relatórios
+const char *gemm_kernel_name(void);
+
+#endif
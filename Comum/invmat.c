@@ -0,0 +1,1965 @@
+/*
+ * invmat.c - Biblioteca de inversão (libinvmat): contextos com área de
+ * trabalho numa arena, backends serial por linhas/colunas e OpenMP, as
+ * variantes (blocada, LU, persistente, DAG de tiles, in-place, precisão
+ * mista, Newton-Schulz),
+ * validação e matrizes em arquivo. Os lotes estão em invmat_batch.c e o
+ * backend OpenCL em invmat_opencl.c
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <float.h>
+#include <omp.h>
+#include <pthread.h>
+
+#include "invmat.h"
+#include "invmat_internal.h"
+#include "simd_kernels.h"
+#include "fixed_size_kernels.h"
+#include "matrix_file.h"
+#include "gemm.h"
+#include "arena.h"
+
+// Tolerâncias dos programas de teste
+#define PIVOT_MIN 1e-10
+#define VALIDATION_EPSILON 1e-6
+
+struct invmat_context {
+    invmat_backend_t backend;
+    int num_threads;
+    int capacity;           // maior n que cabe na área de trabalho atual
+    arena_t arena;
+    double *temp_A;         // cópia de A eliminada (backends na CPU)
+    double *product;        // A * A^-1 de invmat_validate_exact
+    double *gemm_workspace;
+#ifdef INVMAT_OPENCL
+    invmat_opencl_t *opencl;
+#endif
+};
+
+struct invmat_matrix {
+    int n;
+    int layout;
+    double *data;
+    matrix_map_t map;       // map.base != NULL se carregada de arquivo
+};
+
+// Mensagem da última falha, por thread
+static __thread char error_message[512];
+
+// Seleção dos kernels SIMD uma vez por processo (os contextos podem ser
+// criados em paralelo). O aviso sobre IM_ISA não vai para stderr: fica em
+// simd_warning e é copiado para a mensagem da thread a cada contexto criado
+static pthread_once_t simd_once = PTHREAD_ONCE_INIT;
+static char simd_warning[256];
+
+static void select_simd(void) {
+    simd_init_quiet(simd_warning, sizeof(simd_warning));
+}
+
+invmat_status_t invmat_fail(invmat_status_t status, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error_message, sizeof(error_message), format, args);
+    va_end(args);
+    return status;
+}
+
+const char *invmat_error_message(void) {
+    return error_message;
+}
+
+const char *invmat_status_string(invmat_status_t status) {
+    switch (status) {
+        case INVMAT_OK: return "ok";
+        case INVMAT_ERR_SINGULAR: return "A matriz parece ser singular ou mal condicionada";
+        case INVMAT_ERR_INVALID_ARG: return "Argumento inválido";
+        case INVMAT_ERR_NO_MEMORY: return "Falha na alocação de memória";
+        case INVMAT_ERR_IO: return "Falha de leitura ou escrita";
+        case INVMAT_ERR_BACKEND: return "Backend indisponível ou com erro";
+        default: return "Status desconhecido";
+    }
+}
+
+static const char *backend_names[] = { "auto", "linhas", "colunas", "openmp", "opencl" };
+
+static const char *fallback_reasons[] = {
+    "convergiu",
+    "estimativa de condicionamento pelos pivôs em float alta demais",
+    "pivô em float muito pequeno",
+    "resíduo inicial >= 1 (fora do raio de convergência)",
+    "convergência lenta demais para o limite de iterações",
+    "resíduo estagnou acima da tolerância"
+};
+
+const char *invmat_fallback_reason(invmat_fallback_t reason) {
+    if (reason < INVMAT_FALLBACK_NONE || reason > INVMAT_FALLBACK_STAGNATED) {
+        return "desconhecido";
+    }
+    return fallback_reasons[reason];
+}
+
+const char *invmat_backend_name(invmat_backend_t backend) {
+    if (backend < INVMAT_BACKEND_AUTO || backend > INVMAT_BACKEND_OPENCL) {
+        return "desconhecido";
+    }
+    return backend_names[backend];
+}
+
+invmat_status_t invmat_backend_from_name(const char *name, invmat_backend_t *backend) {
+    if (name == NULL || backend == NULL) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Nome de backend nulo");
+    }
+    for (int b = INVMAT_BACKEND_AUTO; b <= INVMAT_BACKEND_OPENCL; b++) {
+        if (strcmp(name, backend_names[b]) == 0) {
+            *backend = (invmat_backend_t)b;
+            return INVMAT_OK;
+        }
+    }
+    return invmat_fail(INVMAT_ERR_INVALID_ARG, "Backend desconhecido: %s (use linhas, colunas, openmp ou opencl)", name);
+}
+
+int invmat_backend_available(invmat_backend_t backend) {
+    switch (backend) {
+        case INVMAT_BACKEND_AUTO:
+        case INVMAT_BACKEND_SERIAL_ROW:
+        case INVMAT_BACKEND_SERIAL_COL:
+        case INVMAT_BACKEND_OPENMP:
+            return 1;
+        case INVMAT_BACKEND_OPENCL:
+#ifdef INVMAT_OPENCL
+            return 1;
+#else
+            return 0;
+#endif
+        default:
+            return 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Contexto
+// ---------------------------------------------------------------------------
+
+// options só é usado pelo backend OpenCL (NULL = opções padrão)
+static invmat_status_t create_context(invmat_backend_t backend, int num_threads,
+                                      const invmat_opencl_options_t *options, invmat_context_t **ctx) {
+    if (ctx == NULL || num_threads < 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Contexto nulo ou número de threads negativo");
+    }
+    *ctx = NULL;
+
+    if (backend == INVMAT_BACKEND_AUTO) {
+        const char *env = getenv("INVMAT_BACKEND");
+        backend = INVMAT_BACKEND_OPENMP;
+        if (env != NULL && env[0] != '\0') {
+            invmat_status_t status = invmat_backend_from_name(env, &backend);
+            if (status != INVMAT_OK) {
+                return status;
+            }
+        }
+    }
+    if (backend == INVMAT_BACKEND_AUTO) {
+        backend = INVMAT_BACKEND_OPENMP;
+    }
+    if (!invmat_backend_available(backend)) {
+        return invmat_fail(INVMAT_ERR_BACKEND, "Backend %s indisponível (libinvmat compilada sem ele; ver Comum/Makefile)",
+                           invmat_backend_name(backend));
+    }
+
+    invmat_context_t *c = (invmat_context_t*)calloc(1, sizeof(*c));
+    if (c == NULL) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação do contexto");
+    }
+    c->backend = backend;
+    if (backend == INVMAT_BACKEND_SERIAL_ROW || backend == INVMAT_BACKEND_SERIAL_COL) {
+        c->num_threads = 1;
+    } else {
+        c->num_threads = (num_threads > 0) ? num_threads : omp_get_max_threads();
+    }
+
+    // Os kernels e o tamanho dos buffers do GEMM dependem do nível SIMD
+    pthread_once(&simd_once, select_simd);
+    if (simd_warning[0] != '\0') {
+        invmat_fail(INVMAT_OK, "Aviso: %s", simd_warning);
+    }
+
+#ifdef INVMAT_OPENCL
+    if (backend == INVMAT_BACKEND_OPENCL) {
+        invmat_opencl_options_t defaults = { 0 };
+        if (options == NULL) {
+            defaults.cache_dir = getenv("INVMAT_OPENCL_CACHE");
+            options = &defaults;
+        }
+        invmat_status_t status = invmat_opencl_create(options, &c->opencl);
+        if (status != INVMAT_OK) {
+            free(c);
+            return status;
+        }
+    }
+#else
+    (void)options;
+#endif
+
+    *ctx = c;
+    return INVMAT_OK;
+}
+
+invmat_status_t invmat_context_create(invmat_backend_t backend, int num_threads, invmat_context_t **ctx) {
+    return create_context(backend, num_threads, NULL, ctx);
+}
+
+invmat_status_t invmat_context_create_opencl(const invmat_opencl_options_t *options, invmat_context_t **ctx) {
+    return create_context(INVMAT_BACKEND_OPENCL, 0, options, ctx);
+}
+
+invmat_status_t invmat_context_opencl_stats(const invmat_context_t *ctx, invmat_opencl_stats_t *stats) {
+    if (ctx == NULL || stats == NULL) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Contexto ou medidas nulos");
+    }
+#ifdef INVMAT_OPENCL
+    if (ctx->opencl != NULL) {
+        invmat_opencl_stats(ctx->opencl, stats);
+        return INVMAT_OK;
+    }
+#endif
+    return invmat_fail(INVMAT_ERR_BACKEND, "Contexto %s não tem medidas OpenCL", invmat_backend_name(ctx->backend));
+}
+
+void invmat_context_destroy(invmat_context_t *ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+#ifdef INVMAT_OPENCL
+    if (ctx->opencl != NULL) {
+        invmat_opencl_destroy(ctx->opencl);
+    }
+#endif
+    arena_destroy(&ctx->arena);
+    free(ctx);
+}
+
+invmat_backend_t invmat_context_backend(const invmat_context_t *ctx) {
+    return ctx->backend;
+}
+
+int invmat_context_threads(const invmat_context_t *ctx) {
+    return ctx->num_threads;
+}
+
+const char *invmat_context_device(const invmat_context_t *ctx) {
+#ifdef INVMAT_OPENCL
+    if (ctx->opencl != NULL) {
+        return invmat_opencl_device(ctx->opencl);
+    }
+#else
+    (void)ctx;
+#endif
+    return simd_isa_name();
+}
+
+invmat_status_t invmat_context_reserve(invmat_context_t *ctx, int n) {
+    if (ctx == NULL || n <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Contexto nulo ou tamanho inválido (%d)", n);
+    }
+    if (n <= ctx->capacity) {
+        return INVMAT_OK;
+    }
+
+    size_t matrix_bytes = (size_t)n*n*sizeof(double);
+    size_t temp_bytes = (ctx->backend == INVMAT_BACKEND_OPENCL) ? 0 : matrix_bytes;
+    size_t workspace_bytes = gemm_workspace_size(n, n, n)*sizeof(double);
+
+    // A área anterior não é aproveitada: uma só região, do tamanho do maior n
+    arena_destroy(&ctx->arena);
+    ctx->capacity = 0;
+    ctx->temp_A = ctx->product = ctx->gemm_workspace = NULL;
+    if (!arena_try_create(&ctx->arena, temp_bytes + matrix_bytes + workspace_bytes + 3*ARENA_ALIGN)) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha ao reservar a área de trabalho para n = %d", n);
+    }
+    if (temp_bytes > 0) {
+        ctx->temp_A = (double*)arena_alloc(&ctx->arena, temp_bytes);
+    }
+    ctx->product = (double*)arena_alloc(&ctx->arena, matrix_bytes);
+    ctx->gemm_workspace = (double*)arena_alloc(&ctx->arena, workspace_bytes);
+
+    // Pré-faulting por primeiro toque: cada thread zera as linhas que vai
+    // eliminar, com o mesmo schedule(static) da eliminação
+    double *temp_A = ctx->temp_A, *product = ctx->product;
+    #pragma omp parallel for schedule(static) num_threads(ctx->num_threads)
+    for (int i = 0; i < n; i++) {
+        if (temp_A != NULL) {
+            memset(temp_A + (size_t)i*n, 0, n*sizeof(double));
+        }
+        memset(product + (size_t)i*n, 0, n*sizeof(double));
+    }
+    memset(ctx->gemm_workspace, 0, workspace_bytes);
+
+    ctx->capacity = n;
+    return INVMAT_OK;
+}
+
+void invmat_context_scratch(const invmat_context_t *ctx, size_t *bytes, long *huge_bytes,
+                            const char **backing) {
+    if (bytes != NULL) {
+        *bytes = ctx->arena.size;
+    }
+    if (huge_bytes != NULL) {
+        *huge_bytes = (ctx->arena.base != NULL) ? arena_huge_bytes(&ctx->arena) : -1;
+    }
+    if (backing != NULL) {
+        *backing = arena_backing_name(&ctx->arena);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Backends na CPU (temp_A é a área de trabalho do contexto)
+// ---------------------------------------------------------------------------
+
+static void copy_and_identity(const double *A, double *Ainv, double *temp_A, int n) {
+    memcpy(temp_A, A, (size_t)n*n*sizeof(double));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            Ainv[i*n + j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+}
+
+static void swap_rows(double *temp_A, double *Ainv, int n, int k, int pivot_row) {
+    for (int j = 0; j < n; j++) {
+        double temp = temp_A[k*n + j];
+        temp_A[k*n + j] = temp_A[pivot_row*n + j];
+        temp_A[pivot_row*n + j] = temp;
+
+        temp = Ainv[k*n + j];
+        Ainv[k*n + j] = Ainv[pivot_row*n + j];
+        Ainv[pivot_row*n + j] = temp;
+    }
+}
+
+static invmat_status_t fail_singular(void) {
+    return invmat_fail(INVMAT_ERR_SINGULAR, "%s", invmat_status_string(INVMAT_ERR_SINGULAR));
+}
+
+// Gauss-Jordan orientado a linhas (o de im_serial, orientação 1)
+invmat_status_t invmat_gauss_jordan_serial(const double *A, double *Ainv, double *temp_A, int n) {
+    if (A == NULL || Ainv == NULL || temp_A == NULL || n <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Argumento nulo ou tamanho inválido (%d)", n);
+    }
+    // Sem contexto, os kernels SIMD são escolhidos na primeira chamada
+    pthread_once(&simd_once, select_simd);
+    copy_and_identity(A, Ainv, temp_A, n);
+
+    for (int k = 0; k < n; k++) {
+        // Encontra o pivô (valor máximo na coluna k)
+        double pivot_value;
+        int pivot_row = simd_abs_argmax(temp_A + k, n, k, n, &pivot_value);
+        if (pivot_value < PIVOT_MIN) {
+            return fail_singular();
+        }
+        if (pivot_row != k) {
+            swap_rows(temp_A, Ainv, n, k, pivot_row);
+        }
+
+        // Normaliza a linha do pivô
+        double pivot = temp_A[k*n + k];
+        simd_scale(temp_A + k*n, pivot, n);
+        simd_scale(Ainv + k*n, pivot, n);
+
+        // Eliminação de Gauss
+        for (int i = 0; i < n; i++) {
+            if (i != k) {
+                double factor = temp_A[i*n + k];
+                simd_axpy(temp_A + i*n, temp_A + k*n, factor, n);
+                simd_axpy(Ainv + i*n, Ainv + k*n, factor, n);
+            }
+        }
+    }
+
+    return INVMAT_OK;
+}
+
+// Gauss-Jordan orientado a colunas (im_serial, orientação 2): a eliminação
+// percorre a matriz coluna por coluna. A coluna k de temp_A guarda os fatores
+// durante o passo e só é zerada no fim, e as colunas de Ainv (inclusive a k)
+// usam os mesmos fatores
+static int serial_col_elimination(const double *A, double *Ainv, double *temp_A, int n) {
+    copy_and_identity(A, Ainv, temp_A, n);
+
+    for (int k = 0; k < n; k++) {
+        // Encontra o pivô (valor máximo na coluna k)
+        int pivot_row = k;
+        double pivot_value = fabs(temp_A[k*n + k]);
+        for (int i = k + 1; i < n; i++) {
+            double abs_value = fabs(temp_A[i*n + k]);
+            if (abs_value > pivot_value) {
+                pivot_value = abs_value;
+                pivot_row = i;
+            }
+        }
+        if (pivot_value < PIVOT_MIN) {
+            return 0;
+        }
+        if (pivot_row != k) {
+            swap_rows(temp_A, Ainv, n, k, pivot_row);
+        }
+
+        // Normaliza a linha do pivô
+        double pivot = temp_A[k*n + k];
+        for (int j = 0; j < n; j++) {
+            temp_A[k*n + j] /= pivot;
+            Ainv[k*n + j] /= pivot;
+        }
+
+        // Loop externo sobre colunas (diferente da orientação a linhas)
+        for (int j = 0; j < n; j++) {
+            double a_kj = temp_A[k*n + j];
+            double inv_kj = Ainv[k*n + j];
+            for (int i = 0; i < n; i++) {
+                if (i != k) {
+                    double factor = temp_A[i*n + k];
+                    if (j != k) {
+                        temp_A[i*n + j] -= factor * a_kj;
+                    }
+                    Ainv[i*n + j] -= factor * inv_kj;
+                }
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            if (i != k) {
+                temp_A[i*n + k] = 0.0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+// Busca do pivô da coluna k de M (linhas k..n-1) com num_threads threads:
+// cada uma usa o kernel SIMD no seu trecho contíguo da coluna, com redução
+// crítica para o pivô global. Com uma thread, é uma só chamada do kernel
+static int parallel_pivot(const double *M, int n, int k, int num_threads, double *pivot_value) {
+    int pivot_row = k;
+    double best = fabs(M[(size_t)k*n + k]);
+
+    #pragma omp parallel num_threads(num_threads) if(num_threads > 1)
+    {
+        int local_pivot_row = pivot_row;
+        double local_pivot_value = best;
+
+        int nt = omp_get_num_threads();
+        int tid = omp_get_thread_num();
+        int len = n - (k + 1);
+        int begin = k + 1 + (int)((long)len * tid / nt);
+        int end = k + 1 + (int)((long)len * (tid + 1) / nt);
+        if (begin < end) {
+            double abs_value;
+            int row = simd_abs_argmax(M + k, n, begin, end, &abs_value);
+            if (abs_value > local_pivot_value) {
+                local_pivot_value = abs_value;
+                local_pivot_row = row;
+            }
+        }
+
+        #pragma omp critical
+        {
+            if (local_pivot_value > best) {
+                best = local_pivot_value;
+                pivot_row = local_pivot_row;
+            }
+        }
+    }
+
+    *pivot_value = best;
+    return pivot_row;
+}
+
+// Gauss-Jordan orientado a linhas com OpenMP (im_parallel, método 1)
+invmat_status_t invmat_gauss_jordan_openmp(const double *A, double *Ainv, double *temp_A, int n, int num_threads) {
+    if (A == NULL || Ainv == NULL || temp_A == NULL || n <= 0 || num_threads <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Argumento nulo, tamanho ou número de threads inválido");
+    }
+    pthread_once(&simd_once, select_simd);
+
+    // Cópia de A e identidade em Ainv por primeiro toque, com o mesmo
+    // schedule(static) da eliminação (páginas no nó NUMA da thread dona)
+    #pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < n; i++) {
+        memcpy(temp_A + (size_t)i*n, A + (size_t)i*n, n*sizeof(double));
+        for (int j = 0; j < n; j++) {
+            Ainv[(size_t)i*n + j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    for (int k = 0; k < n; k++) {
+        double pivot_value;
+        int pivot_row = parallel_pivot(temp_A, n, k, num_threads, &pivot_value);
+        if (pivot_value < PIVOT_MIN) {
+            return fail_singular();
+        }
+        if (pivot_row != k) {
+            swap_rows(temp_A, Ainv, n, k, pivot_row);
+        }
+
+        double pivot = temp_A[(size_t)k*n + k];
+        #pragma omp parallel sections num_threads(num_threads)
+        {
+            #pragma omp section
+            simd_scale(temp_A + (size_t)k*n, pivot, n);
+            #pragma omp section
+            simd_scale(Ainv + (size_t)k*n, pivot, n);
+        }
+
+        // Todas as linhas custam o mesmo; schedule(static) mantém cada thread
+        // nas linhas que ela tocou primeiro
+        #pragma omp parallel for schedule(static) num_threads(num_threads)
+        for (int i = 0; i < n; i++) {
+            if (i != k) {
+                double factor = temp_A[(size_t)i*n + k];
+                simd_axpy(temp_A + (size_t)i*n, temp_A + (size_t)k*n, factor, n);
+                simd_axpy(Ainv + (size_t)i*n, Ainv + (size_t)k*n, factor, n);
+            }
+        }
+    }
+
+    return INVMAT_OK;
+}
+
+invmat_status_t invmat_invert_buffer(invmat_context_t *ctx, const double *A, double *Ainv, int n) {
+    if (ctx == NULL || A == NULL || Ainv == NULL || n <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Argumento nulo ou tamanho inválido (%d)", n);
+    }
+
+#ifdef INVMAT_OPENCL
+    if (ctx->backend == INVMAT_BACKEND_OPENCL) {
+        return invmat_opencl_invert(ctx->opencl, A, Ainv, n);
+    }
+#endif
+
+    // Matrizes pequenas usam os kernels de tamanho fixo (sem área de
+    // trabalho), exceto na orientação a colunas, que existe para comparação
+    if (ctx->backend != INVMAT_BACKEND_SERIAL_COL) {
+        int fixed = invert_fixed_size(A, Ainv, n);
+        if (fixed == 1) {
+            return INVMAT_OK;
+        }
+        if (fixed == 0) {
+            return fail_singular();
+        }
+    }
+
+    invmat_status_t status = invmat_context_reserve(ctx, n);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+
+    if (ctx->backend == INVMAT_BACKEND_SERIAL_ROW) {
+        return invmat_gauss_jordan_serial(A, Ainv, ctx->temp_A, n);
+    }
+    if (ctx->backend == INVMAT_BACKEND_SERIAL_COL) {
+        return serial_col_elimination(A, Ainv, ctx->temp_A, n) ? INVMAT_OK : fail_singular();
+    }
+    return invmat_gauss_jordan_openmp(A, Ainv, ctx->temp_A, n, ctx->num_threads);
+}
+
+// ---------------------------------------------------------------------------
+// Variantes (im_serial e im_parallel). As regiões paralelas usam as threads
+// do contexto e, com uma thread (backends seriais), rodam sem criar equipe
+// ---------------------------------------------------------------------------
+
+// Argumentos comuns das variantes; com reserve, garante temp_A, o produto e
+// os buffers do GEMM para n (o in-place não usa área de trabalho n^2)
+static invmat_status_t variant_setup(invmat_context_t *ctx, const void *A, const void *Ainv, int n,
+                                     const char *name, int reserve) {
+    if (ctx == NULL || A == NULL || Ainv == NULL || n <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Argumento nulo ou tamanho inválido (%d)", n);
+    }
+    if (ctx->backend == INVMAT_BACKEND_OPENCL) {
+        return invmat_fail(INVMAT_ERR_BACKEND, "A variante %s não existe no backend opencl", name);
+    }
+    return reserve ? invmat_context_reserve(ctx, n) : INVMAT_OK;
+}
+
+// Tamanho padrão do painel (número de colunas fatoradas por bloco)
+#define DEFAULT_BLOCK_SIZE 64
+
+// Dimensões dos tiles usados na atualização do restante da matriz.
+// Um tile de linhas de X (b x TILE_COLS) mais um tile do destino
+// (TILE_ROWS x TILE_COLS) ocupam ~256 KB para b = 64, cabendo na cache L2
+#define TILE_ROWS 64
+#define TILE_COLS 256
+
+// Aplica M[i, col0..col0+m-1] -= C[i, :] * X[:, 0..m-1] às linhas i em
+// [row_begin, row_end), com C = temp_A[i, k0..k0+bs-1] (fatores L abaixo do
+// painel, coeficientes originais acima), percorrendo a matriz por tiles
+// (atualização BLAS-3). Os tiles de linhas são independentes e divididos
+// entre as threads
+static void blocked_update(double *M, int n, int col0, int m, int row_begin, int row_end,
+                           const double *temp_A, int k0, int bs,
+                           const double *X, int ldx, int num_threads) {
+    #pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+    for (int ii = row_begin; ii < row_end; ii += TILE_ROWS) {
+        int i_end = (ii + TILE_ROWS < row_end) ? ii + TILE_ROWS : row_end;
+        for (int jj = 0; jj < m; jj += TILE_COLS) {
+            int j_end = (jj + TILE_COLS < m) ? jj + TILE_COLS : m;
+            for (int i = ii; i < i_end; i++) {
+                double *M_row = M + (size_t)i*n + col0;
+                for (int r = 0; r < bs; r++) {
+                    double factor = temp_A[(size_t)i*n + k0 + r];
+                    if (factor == 0.0) {
+                        continue;
+                    }
+                    const double *X_row = X + (size_t)r*ldx;
+                    simd_axpy(M_row + jj, X_row + jj, factor, j_end - jj);
+                }
+            }
+        }
+    }
+}
+
+// Substituição in-place em M[P, col0..col0+m-1] (P = linhas k0..k0+bs-1)
+// contra os fatores guardados em temp_A[P, painel]: direta com L (diagonal
+// unitária), M[P] = L^-1 * M[P], ou, com upper, reversa com U
+static void panel_solve(double *M, int n, int col0, int m, const double *temp_A, int k0, int bs,
+                        int upper) {
+    for (int t = 0; t < bs; t++) {
+        int r = upper ? bs - 1 - t : t;
+        double *row = M + (size_t)(k0 + r)*n + col0;
+        int s_begin = upper ? r + 1 : 0;
+        int s_end = upper ? bs : r;
+        for (int s = s_begin; s < s_end; s++) {
+            double factor = temp_A[(size_t)(k0 + r)*n + k0 + s];
+            if (factor != 0.0) {
+                simd_axpy(row, M + (size_t)(k0 + s)*n + col0, factor, m);
+            }
+        }
+        if (upper) {
+            simd_scale(row, temp_A[(size_t)(k0 + r)*n + k0 + r], m);
+        }
+    }
+}
+
+// Fatoração LU com pivotamento parcial das colunas [k0, k0+bs) de temp_A,
+// nas linhas k0..n-1 (as de cima guardam os coeficientes originais do
+// painel). As trocas vão para ipiv; com apply_swaps, também são aplicadas às
+// linhas completas de temp_A e Ainv (senão, só à faixa do painel). Retorna 0
+// se a matriz parecer singular
+static int panel_lu(double *temp_A, double *Ainv, int n, int k0, int bs, int *ipiv, int apply_swaps) {
+    for (int c = 0; c < bs; c++) {
+        int k = k0 + c;
+        double pivot_value;
+        int pivot_row = simd_abs_argmax(temp_A + k0 + c, n, k, n, &pivot_value);
+
+        // Se o pivô for muito pequeno, a matriz pode ser singular
+        if (pivot_value < PIVOT_MIN) {
+            return 0;
+        }
+
+        ipiv[c] = pivot_row;
+        if (pivot_row != k) {
+            if (apply_swaps) {
+                swap_rows(temp_A, Ainv, n, k, pivot_row);
+            } else {
+                for (int j = 0; j < bs; j++) {
+                    double temp = temp_A[(size_t)k*n + k0 + j];
+                    temp_A[(size_t)k*n + k0 + j] = temp_A[(size_t)pivot_row*n + k0 + j];
+                    temp_A[(size_t)pivot_row*n + k0 + j] = temp;
+                }
+            }
+        }
+
+        // Multiplicadores de L (|l| <= 1) no lugar da coluna k e atualização
+        // do restante do painel
+        const double *pivot_row_ptr = temp_A + (size_t)k*n + k0;
+        double pivot = pivot_row_ptr[c];
+        for (int i = k + 1; i < n; i++) {
+            double *row = temp_A + (size_t)i*n + k0;
+            double factor = row[c] / pivot;
+            row[c] = factor;
+            if (factor != 0.0 && c + 1 < bs) {
+                simd_axpy(row + c + 1, pivot_row_ptr + c + 1, factor, bs - c - 1);
+            }
+        }
+    }
+    return 1;
+}
+
+// Gauss-Jordan blocado (im_serial, orientação 3): fatora um painel de b
+// colunas (LU com pivotamento parcial) e aplica a transformação ao restante
+// de [temp_A | Ainv] como produtos matriz-matriz, em vez de uma atualização
+// de posto 1 por pivô. As linhas abaixo do painel usam os multiplicadores
+// pivotados de L e as do pivô são resolvidas contra L e U, nunca com uma
+// inversa explícita do bloco diagonal (que perde precisão quando ele é mal
+// condicionado, mesmo com A bem condicionada)
+invmat_status_t invmat_invert_blocked(invmat_context_t *ctx, const double *A, double *Ainv, int n, int b) {
+    invmat_status_t status = variant_setup(ctx, A, Ainv, n, "blocada", 1);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    if (b < 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Tamanho de bloco negativo (%d)", b);
+    }
+    if (b == 0) {
+        b = DEFAULT_BLOCK_SIZE;
+    }
+    if (b > n) {
+        b = n;
+    }
+
+    double *temp_A = ctx->temp_A;
+    memcpy(temp_A, A, (size_t)n*n*sizeof(double));
+
+    int *ipiv = (int*)malloc(b*sizeof(int));
+    if (ipiv == NULL) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação dos painéis da versão blocada");
+    }
+
+    // Inicializa Ainv como matriz identidade
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            Ainv[(size_t)i*n + j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    for (int k0 = 0; k0 < n; k0 += b) {
+        int bs = (k0 + b < n) ? b : n - k0;
+        int right = k0 + bs;
+        int mA = n - right;
+
+        // Fatoração do painel. As trocas de linha são aplicadas às linhas
+        // completas de temp_A e Ainv, que ainda não foram atualizadas
+        if (!panel_lu(temp_A, Ainv, n, k0, bs, ipiv, 1)) {
+            status = fail_singular();
+            break;
+        }
+
+        // Linhas do pivô: Y = L^-1 * W[P, resto], em que o resto são as
+        // colunas de temp_A à direita do painel e todas as de Ainv
+        panel_solve(temp_A, n, right, mA, temp_A, k0, bs, 0);
+        panel_solve(Ainv, n, 0, n, temp_A, k0, bs, 0);
+
+        // Linhas abaixo do painel: W[i, resto] -= L[i, :] * Y
+        blocked_update(temp_A, n, right, mA, right, n, temp_A, k0, bs,
+                       temp_A + (size_t)k0*n + right, n, ctx->num_threads);
+        blocked_update(Ainv, n, 0, n, right, n, temp_A, k0, bs,
+                       Ainv + (size_t)k0*n, n, ctx->num_threads);
+
+        // Linhas do pivô: X = U^-1 * Y
+        panel_solve(temp_A, n, right, mA, temp_A, k0, bs, 1);
+        panel_solve(Ainv, n, 0, n, temp_A, k0, bs, 1);
+
+        // Linhas acima do painel: W[i, resto] -= C[i, :] * X
+        blocked_update(temp_A, n, right, mA, 0, k0, temp_A, k0, bs,
+                       temp_A + (size_t)k0*n + right, n, ctx->num_threads);
+        blocked_update(Ainv, n, 0, n, 0, k0, temp_A, k0, bs,
+                       Ainv + (size_t)k0*n, n, ctx->num_threads);
+
+        // As colunas do painel viram identidade
+        for (int i = 0; i < n; i++) {
+            for (int c = 0; c < bs; c++) {
+                temp_A[(size_t)i*n + k0 + c] = (i == k0 + c) ? 1.0 : 0.0;
+            }
+        }
+    }
+
+    free(ipiv);
+    return status;
+}
+
+// Largura dos blocos de colunas distribuídos entre as threads na inversão de U
+#define LU_COL_CHUNK 256
+
+// Inversa via fatoração LU com pivotamento parcial (im_serial, orientação 4;
+// im_parallel, método 2): P*A = L*U, inversão de U, resolução de
+// inv(A)*L = inv(U) e desfaz a permutação nas colunas. Custa ~2n^3 flops,
+// contra ~4n^3 do Gauss-Jordan sobre o par [temp_A | Ainv]
+invmat_status_t invmat_invert_lu(invmat_context_t *ctx, const double *A, double *Ainv, int n) {
+    invmat_status_t status = variant_setup(ctx, A, Ainv, n, "LU", 1);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    int num_threads = ctx->num_threads;
+
+    // LU (em temp_A) guarda L (abaixo da diagonal, diagonal unitária
+    // implícita) e U
+    double *LU = ctx->temp_A;
+    int *ipiv = (int*)malloc(n*sizeof(int));
+    if (ipiv == NULL) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação do vetor de pivôs");
+    }
+    memcpy(LU, A, (size_t)n*n*sizeof(double));
+
+    // 1. Fatoração LU (getrf), atualização de posto 1 por linhas
+    for (int k = 0; k < n; k++) {
+        // Encontra o pivô (valor máximo na coluna k)
+        double pivot_value;
+        int pivot_row = simd_abs_argmax(LU + k, n, k, n, &pivot_value);
+
+        // Se o pivô for muito pequeno, a matriz pode ser singular
+        if (pivot_value < PIVOT_MIN) {
+            free(ipiv);
+            return fail_singular();
+        }
+
+        // Troca as linhas se necessário
+        ipiv[k] = pivot_row;
+        if (pivot_row != k) {
+            for (int j = 0; j < n; j++) {
+                double temp = LU[(size_t)k*n + j];
+                LU[(size_t)k*n + j] = LU[(size_t)pivot_row*n + j];
+                LU[(size_t)pivot_row*n + j] = temp;
+            }
+        }
+
+        // Multiplicadores e atualização da submatriz restante
+        double pivot = LU[(size_t)k*n + k];
+        #pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+        for (int i = k + 1; i < n; i++) {
+            LU[(size_t)i*n + k] /= pivot;
+            simd_axpy(LU + (size_t)i*n + k + 1, LU + (size_t)k*n + k + 1, LU[(size_t)i*n + k], n - k - 1);
+        }
+    }
+
+    // 2. inv(U) em Ainv (trtri), da última linha para a primeira:
+    //    linha i = -(1/U[i][i]) * soma_{k>i} U[i][k] * inv(U)[k][:]
+    //    Cada linha depende das de baixo, então as threads dividem as colunas
+    //    da linha corrente
+    int num_chunks = (n + LU_COL_CHUNK - 1) / LU_COL_CHUNK;
+    #pragma omp parallel num_threads(num_threads) if(num_threads > 1)
+    {
+        for (int i = n - 1; i >= 0; i--) {
+            double *row = Ainv + (size_t)i*n;
+            double diag = 1.0 / LU[(size_t)i*n + i];
+
+            #pragma omp for schedule(static)
+            for (int c = 0; c < num_chunks; c++) {
+                int c0 = c * LU_COL_CHUNK;
+                int c1 = (c0 + LU_COL_CHUNK < n) ? c0 + LU_COL_CHUNK : n;
+
+                for (int j = c0; j < c1; j++) {
+                    row[j] = 0.0;
+                }
+                for (int k = i + 1; k < c1; k++) {
+                    int j0 = (k > c0) ? k : c0;
+                    simd_axpy(row + j0, Ainv + (size_t)k*n + j0, LU[(size_t)i*n + k], c1 - j0);
+                }
+                for (int j = c0; j < c1; j++) {
+                    if (j > i) {
+                        row[j] *= diag;
+                    } else if (j == i) {
+                        row[j] = diag;
+                    }
+                }
+            }
+        }
+    }
+
+    // 3. Resolve X*L = inv(U) e 4. desfaz a permutação: inv(A) = X*P,
+    //    trocando colunas na ordem inversa (cada linha é independente)
+    #pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+    for (int i = 0; i < n; i++) {
+        double *row = Ainv + (size_t)i*n;
+        for (int k = n - 1; k > 0; k--) {
+            if (row[k] != 0.0) {
+                simd_axpy(row, LU + (size_t)k*n, row[k], k);
+            }
+        }
+        for (int k = n - 1; k >= 0; k--) {
+            if (ipiv[k] != k) {
+                double temp = row[k];
+                row[k] = row[ipiv[k]];
+                row[ipiv[k]] = temp;
+            }
+        }
+    }
+
+    free(ipiv);
+    return INVMAT_OK;
+}
+
+// Inversa no próprio buffer (im_serial, orientação 5; im_parallel, método 5),
+// por Gauss-Jordan com substituição de colunas. A coluna k de A, que após a
+// eliminação seria a coluna k da identidade, passa a guardar a coluna k da
+// inversa: n^2 doubles mais o vetor de pivôs e metade das operações do laço
+// sobre [temp_A | Ainv], já que o lado da identidade nunca é atualizado
+invmat_status_t invmat_invert_in_place(invmat_context_t *ctx, double *A, int n) {
+    invmat_status_t status = variant_setup(ctx, A, A, n, "in-place", 0);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    int num_threads = ctx->num_threads;
+
+    int *ipiv = (int*)malloc(n*sizeof(int));
+    if (ipiv == NULL) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação do vetor de pivôs");
+    }
+
+    for (int k = 0; k < n; k++) {
+        double pivot_value;
+        int pivot_row = parallel_pivot(A, n, k, num_threads, &pivot_value);
+
+        // Se o pivô for muito pequeno, a matriz pode ser singular
+        if (pivot_value < PIVOT_MIN) {
+            free(ipiv);
+            return fail_singular();
+        }
+
+        // Troca as linhas se necessário (desfeita no fim como troca de colunas)
+        ipiv[k] = pivot_row;
+        if (pivot_row != k) {
+            for (int j = 0; j < n; j++) {
+                double temp = A[(size_t)k*n + j];
+                A[(size_t)k*n + j] = A[(size_t)pivot_row*n + j];
+                A[(size_t)pivot_row*n + j] = temp;
+            }
+        }
+
+        // Normaliza a linha do pivô; A[k][k] passa a ser 1/pivô
+        double pivot = A[(size_t)k*n + k];
+        A[(size_t)k*n + k] = 1.0;
+        simd_scale(A + (size_t)k*n, pivot, n);
+
+        // Eliminação de Gauss; A[i][k] passa a ser -fator/pivô.
+        // schedule(static): as linhas de cada thread são as que ela copiou
+        #pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+        for (int i = 0; i < n; i++) {
+            if (i != k) {
+                double factor = A[(size_t)i*n + k];
+                A[(size_t)i*n + k] = 0.0;
+                simd_axpy(A + (size_t)i*n, A + (size_t)k*n, factor, n);
+            }
+        }
+    }
+
+    // Desfaz as trocas de linhas trocando as colunas na ordem inversa
+    // (cada linha é independente)
+    #pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+    for (int i = 0; i < n; i++) {
+        double *row = A + (size_t)i*n;
+        for (int k = n - 1; k >= 0; k--) {
+            if (ipiv[k] != k) {
+                double temp = row[k];
+                row[k] = row[ipiv[k]];
+                row[ipiv[k]] = temp;
+            }
+        }
+    }
+
+    free(ipiv);
+    return INVMAT_OK;
+}
+
+// Candidato a pivô de cada thread, alinhado a uma linha de cache para evitar
+// falso compartilhamento entre as threads que escrevem lado a lado
+typedef struct {
+    double value;   // fabs do elemento, usado na comparação
+    double pivot;   // elemento com sinal, usado na normalização
+    int row;
+    char padding[64 - 2*sizeof(double) - sizeof(int)];
+} __attribute__((aligned(64))) pivot_candidate_t;
+
+// Gauss-Jordan com uma única região paralela para todo o laço k
+// (im_parallel, método 3). Cada thread é dona de um bloco fixo de linhas
+// (partição estática), a escolha do pivô é uma redução sem lock sobre
+// candidatos por thread, a troca de linhas é dividida por colunas e a busca
+// do próximo pivô é feita na mesma passada da eliminação
+invmat_status_t invmat_invert_persistent(invmat_context_t *ctx, const double *A, double *Ainv, int n) {
+    invmat_status_t status = variant_setup(ctx, A, Ainv, n, "persistente", 1);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    int num_threads = ctx->num_threads;
+
+    double *temp_A = ctx->temp_A;
+    pivot_candidate_t *candidates = (pivot_candidate_t*)aligned_alloc(64, num_threads * sizeof(pivot_candidate_t));
+    if (candidates == NULL) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação dos candidatos a pivô");
+    }
+
+    int singular = 0;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int nt = omp_get_num_threads();
+        int tid = omp_get_thread_num();
+
+        // Bloco de linhas da thread (eliminação) e de colunas (troca de linhas)
+        int row_begin = (int)((long)n * tid / nt);
+        int row_end = (int)((long)n * (tid + 1) / nt);
+        int col_begin = row_begin;
+        int col_end = row_end;
+
+        // Cada thread copia A e inicializa a identidade nas suas próprias linhas
+        for (int i = row_begin; i < row_end; i++) {
+            memcpy(temp_A + (size_t)i*n, A + (size_t)i*n, n*sizeof(double));
+            for (int j = 0; j < n; j++) {
+                Ainv[(size_t)i*n + j] = (i == j) ? 1.0 : 0.0;
+            }
+        }
+
+        // Candidato local para a coluna 0
+        candidates[tid].value = -1.0;
+        candidates[tid].row = -1;
+        for (int i = row_begin; i < row_end; i++) {
+            double abs_value = fabs(temp_A[(size_t)i*n]);
+            if (abs_value > candidates[tid].value) {
+                candidates[tid].value = abs_value;
+                candidates[tid].pivot = temp_A[(size_t)i*n];
+                candidates[tid].row = i;
+            }
+        }
+
+        for (int k = 0; k < n; k++) {
+            #pragma omp barrier
+
+            // Redução sem lock: todas as threads leem os candidatos e chegam
+            // ao mesmo pivô (menor linha em caso de empate, como na serial)
+            int pivot_row = -1;
+            double pivot_value = -1.0;
+            double pivot = 0.0;
+            for (int t = 0; t < nt; t++) {
+                if (candidates[t].value > pivot_value) {
+                    pivot_value = candidates[t].value;
+                    pivot = candidates[t].pivot;
+                    pivot_row = candidates[t].row;
+                }
+            }
+
+            // Se o pivô for muito pequeno, a matriz pode ser singular.
+            // Todas as threads tomam a mesma decisão, então saem juntas
+            if (pivot_value < PIVOT_MIN) {
+                if (tid == 0) {
+                    singular = 1;
+                }
+                break;
+            }
+
+            // Troca as linhas e normaliza a linha do pivô, dividindo por colunas.
+            // O pivô vem do candidato, pois a coluna k pode estar sendo trocada
+            for (int j = col_begin; j < col_end; j++) {
+                double temp = temp_A[(size_t)pivot_row*n + j];
+                temp_A[(size_t)pivot_row*n + j] = temp_A[(size_t)k*n + j];
+                temp_A[(size_t)k*n + j] = temp / pivot;
+
+                temp = Ainv[(size_t)pivot_row*n + j];
+                Ainv[(size_t)pivot_row*n + j] = Ainv[(size_t)k*n + j];
+                Ainv[(size_t)k*n + j] = temp / pivot;
+            }
+
+            #pragma omp barrier
+
+            // Eliminação nas linhas da thread, já buscando o candidato a pivô
+            // da coluna k+1 enquanto a linha ainda está na cache
+            candidates[tid].value = -1.0;
+            candidates[tid].row = -1;
+            for (int i = row_begin; i < row_end; i++) {
+                if (i != k) {
+                    double factor = temp_A[(size_t)i*n + k];
+                    simd_axpy(temp_A + (size_t)i*n, temp_A + (size_t)k*n, factor, n);
+                    simd_axpy(Ainv + (size_t)i*n, Ainv + (size_t)k*n, factor, n);
+                }
+                if (i > k && k + 1 < n) {
+                    double abs_value = fabs(temp_A[(size_t)i*n + k + 1]);
+                    if (abs_value > candidates[tid].value) {
+                        candidates[tid].value = abs_value;
+                        candidates[tid].pivot = temp_A[(size_t)i*n + k + 1];
+                        candidates[tid].row = i;
+                    }
+                }
+            }
+        }
+    }
+
+    free(candidates);
+    return singular ? fail_singular() : INVMAT_OK;
+}
+
+// Parâmetros padrão da versão com escalonamento por tarefas (DAG de tiles)
+#define DEFAULT_TILE_SIZE 64
+
+// Atualização da faixa de colunas [col0, col0+w) de M pelo passo do painel k0
+// (tarefa do DAG), com os fatores LU do painel guardados na faixa k0 de
+// temp_A (panel_lu): aplica as trocas do painel, resolve as linhas do pivô
+// contra L, atualiza as linhas abaixo com os multiplicadores de L, resolve
+// contra U e atualiza as linhas acima com os coeficientes originais do painel
+static void tiled_update(double *M, int n, int col0, int w, const double *temp_A,
+                         int k0, int bs, const int *ipiv) {
+    for (int c = 0; c < bs; c++) {
+        int k = k0 + c;
+        if (ipiv[c] != k) {
+            double *row1 = M + (size_t)k*n + col0;
+            double *row2 = M + (size_t)ipiv[c]*n + col0;
+            for (int j = 0; j < w; j++) {
+                double temp = row1[j];
+                row1[j] = row2[j];
+                row2[j] = temp;
+            }
+        }
+    }
+
+    const double *X = M + (size_t)k0*n + col0;
+    panel_solve(M, n, col0, w, temp_A, k0, bs, 0);
+    blocked_update(M, n, col0, w, k0 + bs, n, temp_A, k0, bs, X, n, 1);
+    panel_solve(M, n, col0, w, temp_A, k0, bs, 1);
+    blocked_update(M, n, col0, w, 0, k0, temp_A, k0, bs, X, n, 1);
+}
+
+// Estados de [temp_A | Ainv] do Gauss-Jordan por linhas ao fim de cada painel
+// de tile colunas (snapshots[K] tem 2n^2 doubles: temp_A e depois Ainv), para
+// conferir as tarefas do DAG. Retorna 0 se a matriz parecer singular
+static int row_method_snapshots(const double *A, int n, int tile, double *snapshots) {
+    double *temp_A = snapshots;
+    double *Ainv = snapshots + (size_t)n*n;
+    copy_and_identity(A, Ainv, temp_A, n);
+
+    for (int k = 0; k < n; k++) {
+        double pivot_value;
+        int pivot_row = simd_abs_argmax(temp_A + k, n, k, n, &pivot_value);
+        if (pivot_value < PIVOT_MIN) {
+            return 0;
+        }
+        if (pivot_row != k) {
+            swap_rows(temp_A, Ainv, n, k, pivot_row);
+        }
+        double pivot = temp_A[(size_t)k*n + k];
+        simd_scale(temp_A + (size_t)k*n, pivot, n);
+        simd_scale(Ainv + (size_t)k*n, pivot, n);
+        for (int i = 0; i < n; i++) {
+            if (i != k) {
+                double factor = temp_A[(size_t)i*n + k];
+                simd_axpy(temp_A + (size_t)i*n, temp_A + (size_t)k*n, factor, n);
+                simd_axpy(Ainv + (size_t)i*n, Ainv + (size_t)k*n, factor, n);
+            }
+        }
+
+        // Fim de um painel: o próximo estado começa como cópia deste
+        if ((k + 1) % tile == 0 && k + 1 < n) {
+            memcpy(Ainv + (size_t)n*n, temp_A, 2*(size_t)n*n*sizeof(double));
+            temp_A += 2*(size_t)n*n;
+            Ainv += 2*(size_t)n*n;
+        }
+    }
+    return 1;
+}
+
+// Maior diferença entre a faixa [col0, col0+w) de M e a mesma faixa de ref,
+// relativa ao maior elemento da faixa de ref
+static double strip_error(const double *M, const double *ref, int n, int col0, int w) {
+    double diff = 0.0, scale = 0.0;
+    for (int i = 0; i < n; i++) {
+        for (int j = col0; j < col0 + w; j++) {
+            double d = fabs(M[(size_t)i*n + j] - ref[(size_t)i*n + j]);
+            double r = fabs(ref[(size_t)i*n + j]);
+            if (d > diff) diff = d;
+            if (r > scale) scale = r;
+        }
+    }
+    return (scale > 0.0) ? diff / scale : diff;
+}
+
+// Gauss-Jordan blocado com um escalonador de DAG (im_parallel, método 4).
+// [temp_A | Ainv] é dividido em faixas de tile colunas; as tarefas são
+// PAINEL(K), que depende da faixa K estar atualizada até o passo K-1, e
+// ATUALIZA(K, faixa), que depende de PAINEL(K) e do passo K-1 naquela faixa.
+// Não há barreira entre passos: o painel K+1 é fatorado assim que sua faixa
+// recebe a atualização do passo K, enquanto o restante dessa atualização
+// ainda roda. O lookahead limita quantos passos podem ter atualizações
+// pendentes quando um novo painel começa (0 = síncrono)
+// Com snapshots (row_method_snapshots), cada tarefa de atualização tem a
+// faixa conferida com o estado do método por linhas no mesmo passo, e a maior
+// diferença relativa vai para *task_error
+static invmat_status_t tiled_run(invmat_context_t *ctx, const double *A, double *Ainv, int n,
+                                 int tile, int lookahead, invmat_tiled_stats_t *stats,
+                                 const double *snapshots, double *task_error) {
+    invmat_status_t status = INVMAT_OK;
+    int num_threads = ctx->num_threads;
+    int num_panels = (n + tile - 1) / tile;         // faixas de temp_A (= passos)
+    int num_strips = 2 * num_panels;                // faixas de temp_A e de Ainv
+
+    double *temp_A = ctx->temp_A;
+    int *ipiv = (int*)malloc((size_t)num_panels*tile*sizeof(int));
+    int *version = (int*)calloc(num_strips, sizeof(int));       // passos já aplicados a cada faixa
+    int *busy = (int*)calloc(num_strips, sizeof(int));
+    int *panel_done = (int*)calloc(num_panels, sizeof(int));
+    int *step_remaining = (int*)malloc(num_panels*sizeof(int)); // atualizações pendentes por passo
+    double *busy_time = (double*)calloc(num_threads, sizeof(double));
+
+    if (ipiv == NULL || version == NULL ||
+        busy == NULL || panel_done == NULL || step_remaining == NULL || busy_time == NULL) {
+        status = invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação do escalonador de tiles");
+        goto done;
+    }
+
+    int total_tasks = num_panels;
+    for (int K = 0; K < num_panels; K++) {
+        step_remaining[K] = (num_panels - K - 1) + num_panels;
+        total_tasks += step_remaining[K];
+    }
+
+    int next_panel = 0;
+    int completed = 0;
+    int singular = 0;
+    double max_error = 0.0;
+    // Estado do escalonador protegido por lock; sem tarefa pronta, a thread
+    // dorme em ready até que outra conclua uma tarefa (em vez de girar no lock)
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t ready = PTHREAD_COND_INITIALIZER;
+
+    double start = omp_get_wtime();
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+
+        // Copia A e inicializa Ainv como identidade
+        #pragma omp for schedule(static)
+        for (int i = 0; i < n; i++) {
+            memcpy(temp_A + (size_t)i*n, A + (size_t)i*n, n*sizeof(double));
+            for (int j = 0; j < n; j++) {
+                Ainv[(size_t)i*n + j] = (i == j) ? 1.0 : 0.0;
+            }
+        }
+
+        pthread_mutex_lock(&lock);
+        for (;;) {
+            int task_panel = -1, task_strip = -1, task_step = -1;
+
+            if (completed == total_tasks || singular) {
+                break;
+            }
+
+            // Prioridade 1: o próximo painel (caminho crítico)
+            int K = next_panel;
+            if (K < num_panels && version[K] == K &&
+                (K - lookahead - 1 < 0 || step_remaining[K - lookahead - 1] == 0)) {
+                task_panel = K;
+                next_panel++;
+            } else {
+                // Prioridade 2: a atualização do passo mais antigo, começando
+                // pelas faixas de temp_A mais próximas do próximo painel
+                for (int st = 0; st < num_strips; st++) {
+                    int step = version[st];
+                    int needs = (st >= num_panels) || (st > step);
+                    if (!busy[st] && step < num_panels && needs && panel_done[step] &&
+                        (task_strip < 0 || step < task_step)) {
+                        task_strip = st;
+                        task_step = step;
+                    }
+                }
+                if (task_strip >= 0) {
+                    busy[task_strip] = 1;
+                }
+            }
+
+            if (task_panel < 0 && task_strip < 0) {
+                // Nada pronto: aguarda a conclusão de uma dependência
+                pthread_cond_wait(&ready, &lock);
+                continue;
+            }
+            pthread_mutex_unlock(&lock);
+
+            double t0 = omp_get_wtime();
+            if (task_panel >= 0) {
+                int k0 = task_panel * tile;
+                int bs = (k0 + tile < n) ? tile : n - k0;
+                int ok = panel_lu(temp_A, NULL, n, k0, bs, ipiv + task_panel*tile, 0);
+                busy_time[tid] += omp_get_wtime() - t0;
+
+                pthread_mutex_lock(&lock);
+                if (!ok) {
+                    singular = 1;
+                }
+                panel_done[task_panel] = 1;
+                completed++;
+            } else {
+                int k0 = task_step * tile;
+                int bs = (k0 + tile < n) ? tile : n - k0;
+                int local = (task_strip < num_panels) ? task_strip : task_strip - num_panels;
+                int col0 = local * tile;
+                int w = (col0 + tile < n) ? tile : n - col0;
+                double *M = (task_strip < num_panels) ? temp_A : Ainv;
+                tiled_update(M, n, col0, w, temp_A, k0, bs, ipiv + task_step*tile);
+                busy_time[tid] += omp_get_wtime() - t0;
+
+                double error = 0.0;
+                if (snapshots != NULL) {
+                    const double *ref = snapshots + 2*(size_t)task_step*n*n + ((M == Ainv) ? (size_t)n*n : 0);
+                    error = strip_error(M, ref, n, col0, w);
+                }
+
+                pthread_mutex_lock(&lock);
+                if (error > max_error) {
+                    max_error = error;
+                }
+                version[task_strip]++;
+                busy[task_strip] = 0;
+                step_remaining[task_step]--;
+                completed++;
+            }
+            // A tarefa concluída pode liberar outras (ou encerrar o laço)
+            pthread_cond_broadcast(&ready);
+        }
+        pthread_mutex_unlock(&lock);
+    }
+
+    if (stats != NULL) {
+        stats->wall_time = omp_get_wtime() - start;
+        stats->busy_time = 0.0;
+        for (int t = 0; t < num_threads; t++) {
+            stats->busy_time += busy_time[t];
+        }
+    }
+    pthread_mutex_destroy(&lock);
+    pthread_cond_destroy(&ready);
+    if (singular) {
+        status = fail_singular();
+    }
+    if (task_error != NULL) {
+        *task_error = max_error;
+    }
+
+done:
+    free(ipiv);
+    free(version);
+    free(busy);
+    free(panel_done);
+    free(step_remaining);
+    free(busy_time);
+    return status;
+}
+
+// Ajusta tile e lookahead aos valores padrão e a n
+static void tiled_params(int n, int *tile, int *lookahead) {
+    if (*tile <= 0) {
+        *tile = DEFAULT_TILE_SIZE;
+    }
+    if (*tile > n) {
+        *tile = n;
+    }
+    if (*lookahead < 0) {
+        *lookahead = 0;
+    }
+}
+
+invmat_status_t invmat_invert_tiled(invmat_context_t *ctx, const double *A, double *Ainv, int n,
+                                    int tile, int lookahead, invmat_tiled_stats_t *stats) {
+    invmat_status_t status = variant_setup(ctx, A, Ainv, n, "com DAG de tiles", 1);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    tiled_params(n, &tile, &lookahead);
+    return tiled_run(ctx, A, Ainv, n, tile, lookahead, stats, NULL, NULL);
+}
+
+invmat_status_t invmat_check_tiled(invmat_context_t *ctx, const double *A, int n, int tile, int lookahead,
+                                   double *max_error) {
+    if (max_error == NULL) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Ponteiro do erro nulo");
+    }
+    invmat_status_t status = variant_setup(ctx, A, A, n, "com DAG de tiles", 1);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    tiled_params(n, &tile, &lookahead);
+
+    int num_panels = (n + tile - 1) / tile;
+    double *snapshots = (double*)malloc(2*(size_t)num_panels*n*n*sizeof(double));
+    double *Ainv = (double*)malloc((size_t)n*n*sizeof(double));
+    if (snapshots == NULL || Ainv == NULL) {
+        status = invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação dos estados do método por linhas");
+    } else if (!row_method_snapshots(A, n, tile, snapshots)) {
+        status = fail_singular();
+    } else {
+        status = tiled_run(ctx, A, Ainv, n, tile, lookahead, NULL, snapshots, max_error);
+    }
+    free(snapshots);
+    free(Ainv);
+    return status;
+}
+
+// Kernels em precisão simples da fatoração; compilados para AVX-512, AVX2 e
+// genérico, com a versão escolhida na carga da biblioteca (8 ou 16 floats
+// por registrador, o dobro dos kernels em double)
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static void axpy_float(float *y, const float *x, float a, int len) {
+    for (int j = 0; j < len; j++) {
+        y[j] -= a * x[j];
+    }
+}
+
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static void scale_float(float *x, float d, int len) {
+    for (int j = 0; j < len; j++) {
+        x[j] /= d;
+    }
+}
+
+// Maior estimativa de condicionamento aceita para a fatoração em float. O
+// resíduo inicial ||I - A*X0||_inf fica perto de cond(A) * FLT_EPSILON (de
+// 0.25x a 6x nas matrizes de invmat_generate), e Newton-Schulz precisa dele
+// abaixo de ~0.4 para chegar a NS_TOL em MIXED_MAX_ITER iterações
+#define MIXED_COND_MAX (0.1 / FLT_EPSILON)
+
+// Gauss-Jordan in-place em precisão simples (mesmo esquema de
+// invmat_invert_in_place). *estimate recebe max|A| / min|pivô|, uma cota
+// inferior do condicionamento de A; a fatoração é abandonada assim que ela
+// passa de MIXED_COND_MAX, pois o refinamento não convergiria. Retorna 0
+// (com *reason) se o pivô for muito pequeno ou a estimativa alta demais e
+// -1 se faltar memória
+static int invert_in_place_float(float *A, int n, float amax, int num_threads, double *estimate,
+                                 invmat_fallback_t *reason) {
+    int *ipiv = (int*)malloc(n*sizeof(int));
+    if (ipiv == NULL) {
+        return -1;
+    }
+    float pivot_min = INFINITY;
+
+    for (int k = 0; k < n; k++) {
+        // Encontra o pivô (valor máximo na coluna k)
+        int pivot_row = k;
+        float pivot_value = fabsf(A[(size_t)k*n + k]);
+        for (int i = k + 1; i < n; i++) {
+            float abs_value = fabsf(A[(size_t)i*n + k]);
+            if (abs_value > pivot_value) {
+                pivot_value = abs_value;
+                pivot_row = i;
+            }
+        }
+
+        // Se o pivô for muito pequeno, a matriz pode ser singular (em float)
+        if (pivot_value < (float)PIVOT_MIN) {
+            *reason = INVMAT_FALLBACK_PIVOT;
+            free(ipiv);
+            return 0;
+        }
+        if (pivot_value < pivot_min) {
+            pivot_min = pivot_value;
+            *estimate = (double)amax / pivot_min;
+            if (*estimate > MIXED_COND_MAX) {
+                *reason = INVMAT_FALLBACK_CONDITION;
+                free(ipiv);
+                return 0;
+            }
+        }
+
+        // Troca as linhas se necessário
+        ipiv[k] = pivot_row;
+        if (pivot_row != k) {
+            for (int j = 0; j < n; j++) {
+                float temp = A[(size_t)k*n + j];
+                A[(size_t)k*n + j] = A[(size_t)pivot_row*n + j];
+                A[(size_t)pivot_row*n + j] = temp;
+            }
+        }
+
+        // Normaliza a linha do pivô; A[k][k] passa a ser 1/pivô
+        float pivot = A[(size_t)k*n + k];
+        A[(size_t)k*n + k] = 1.0f;
+        scale_float(A + (size_t)k*n, pivot, n);
+
+        // Eliminação de Gauss
+        #pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+        for (int i = 0; i < n; i++) {
+            if (i != k) {
+                float factor = A[(size_t)i*n + k];
+                A[(size_t)i*n + k] = 0.0f;
+                axpy_float(A + (size_t)i*n, A + (size_t)k*n, factor, n);
+            }
+        }
+    }
+
+    // Desfaz as trocas de linhas trocando as colunas na ordem inversa
+    #pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+    for (int i = 0; i < n; i++) {
+        float *row = A + (size_t)i*n;
+        for (int k = n - 1; k >= 0; k--) {
+            if (ipiv[k] != k) {
+                float temp = row[k];
+                row[k] = row[ipiv[k]];
+                row[ipiv[k]] = temp;
+            }
+        }
+    }
+
+    free(ipiv);
+    return 1;
+}
+
+// Parâmetros de Newton-Schulz
+#define NS_TOL 1e-12          // resíduo no nível de arredondamento de double
+#define MIXED_MAX_ITER 5      // iterações após a fatoração em float
+#define WARM_MAX_ITER 3       // iterações a partir de uma inversa anterior
+
+// R = I - A*X (R na área de trabalho do contexto); retorna ||R||_inf (maior
+// soma de |R[i][j]| numa linha), que limita cada elemento de A*X - I e, se
+// < 1, garante a convergência de Newton-Schulz. O GEMM usa as threads OpenMP
+// disponíveis, que o chamador acerta para as do contexto
+static double residual_norm(invmat_context_t *ctx, const double *A, const double *X, double *R, int n) {
+    // R = -A*X pelo GEMM empacotado; a identidade é somada abaixo
+    gemm_workspace(n, n, n, -1.0, A, n, X, n, 0.0, R, n, ctx->gemm_workspace);
+
+    double norm = 0.0;
+    #pragma omp parallel for schedule(static) reduction(max:norm) num_threads(ctx->num_threads) if(ctx->num_threads > 1)
+    for (int i = 0; i < n; i++) {
+        R[(size_t)i*n + i] += 1.0;
+        double row_sum = 0.0;
+        for (int j = 0; j < n; j++) {
+            row_sum += fabs(R[(size_t)i*n + j]);
+        }
+        if (row_sum > norm) {
+            norm = row_sum;
+        }
+    }
+
+    return norm;
+}
+
+// Refina X, uma aproximação de inv(A), por Newton-Schulz,
+// X <- X*(2I - A*X) = X + X*(I - A*X), o que eleva o resíduo R = I - A*X ao
+// quadrado a cada iteração (custo: dois produtos n x n). Para quando o resíduo
+// chega ao arredondamento de double ou estagna. Desiste cedo quando
+// ||R||_inf >= 1 (fora do raio de convergência) ou quando a convergência
+// quadrática prevista a partir do resíduo atual não alcança NS_TOL em
+// max_iter iterações. R e T ficam em temp_A e no produto do contexto.
+// Retorna 1 se o resíduo final ficou abaixo da tolerância da validação;
+// senão, o motivo fica em info->reason
+static int newton_schulz(invmat_context_t *ctx, const double *A, double *X, int n, int max_iter,
+                         invmat_refine_info_t *info) {
+    double *R = ctx->temp_A;
+    double *T = ctx->product;
+    int converged = 0;
+    double previous = INFINITY;
+    info->iterations = 0;
+    info->history_len = 0;
+
+    for (;;) {
+        double residual = residual_norm(ctx, A, X, R, n);
+        info->residual = residual;
+        if (info->history_len < INVMAT_REFINE_HISTORY) {
+            info->history[info->history_len++] = residual;
+        }
+
+        // Resíduo NaN/inf (estouro): nenhuma das comparações abaixo o pega e
+        // a estimativa de iterações converteria NaN para int
+        if (!isfinite(residual)) {
+            info->reason = INVMAT_FALLBACK_DIVERGED;
+            break;
+        }
+        // Convergiu, estagnou no arredondamento ou esgotou as iterações
+        if (residual < NS_TOL || residual > 0.5 * previous || info->iterations == max_iter) {
+            converged = (residual < VALIDATION_EPSILON);
+            if (!converged) {
+                info->reason = (residual > 0.5 * previous) ? INVMAT_FALLBACK_STAGNATED : INVMAT_FALLBACK_SLOW;
+            }
+            break;
+        }
+        // Fora do raio de convergência
+        if (residual >= 1.0) {
+            info->reason = INVMAT_FALLBACK_DIVERGED;
+            break;
+        }
+        // Iterações necessárias se o resíduo for elevado ao quadrado a cada
+        // passo: residual^(2^k) < NS_TOL
+        int needed = (int)ceil(log2(log(NS_TOL) / log(residual)));
+        if (info->iterations + needed > max_iter && residual >= VALIDATION_EPSILON) {
+            info->reason = INVMAT_FALLBACK_SLOW;
+            break;
+        }
+
+        // X <- X + X*R
+        gemm_workspace(n, n, n, 1.0, X, n, R, n, 0.0, T, n, ctx->gemm_workspace);
+        #pragma omp parallel for schedule(static) num_threads(ctx->num_threads) if(ctx->num_threads > 1)
+        for (size_t i = 0; i < (size_t)n*n; i++) {
+            X[i] += T[i];
+        }
+        info->iterations++;
+        previous = residual;
+    }
+
+    return converged;
+}
+
+// Refinamento de X (já em Ainv) e, se não convergir, Gauss-Jordan em double
+// pelo backend do contexto, com o resíduo final para o relatório. Sem
+// refine, o motivo do recálculo já está em info->reason
+static invmat_status_t refine_or_invert(invmat_context_t *ctx, const double *A, double *Ainv, int n,
+                                        int refine, int max_iter, invmat_refine_info_t *info) {
+    int saved_threads = omp_get_max_threads();
+    omp_set_num_threads(ctx->num_threads);
+
+    info->fallback = !(refine && newton_schulz(ctx, A, Ainv, n, max_iter, info));
+    invmat_status_t status = INVMAT_OK;
+    if (info->fallback) {
+        status = invmat_invert_buffer(ctx, A, Ainv, n);
+        if (status == INVMAT_OK) {
+            info->residual = residual_norm(ctx, A, Ainv, ctx->temp_A, n);
+        }
+    }
+
+    omp_set_num_threads(saved_threads);
+    return status;
+}
+
+// Precisão mista (im_serial, orientação 6; im_parallel, método 6):
+// Gauss-Jordan in-place em float (metade do tráfego de memória e o dobro de
+// elementos por registrador SIMD) e refinamento em double por Newton-Schulz,
+// que dobra o número de dígitos corretos a cada iteração. A cópia em float
+// ocupa a metade do buffer do produto, livre até o refinamento. Só compensa
+// para cond(A) abaixo de ~MIXED_COND_MAX; acima disso a fatoração em float é
+// interrompida pela estimativa dos pivôs e a inversa é calculada em double
+invmat_status_t invmat_invert_mixed(invmat_context_t *ctx, const double *A, double *Ainv, int n,
+                                    invmat_refine_info_t *info) {
+    invmat_status_t status = variant_setup(ctx, A, Ainv, n, "de precisão mista", 1);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    invmat_refine_info_t local;
+    if (info == NULL) {
+        info = &local;
+    }
+    memset(info, 0, sizeof(*info));
+    info->residual = INFINITY;
+    int num_threads = ctx->num_threads;
+
+    float *A32 = (float*)ctx->product;
+    float amax = 0.0f;
+    #pragma omp parallel for schedule(static) reduction(max:amax) num_threads(num_threads) if(num_threads > 1)
+    for (size_t i = 0; i < (size_t)n*n; i++) {
+        A32[i] = (float)A[i];
+        amax = fmaxf(amax, fabsf(A32[i]));
+    }
+
+    int factored = invert_in_place_float(A32, n, amax, num_threads, &info->condition_estimate, &info->reason);
+    if (factored < 0) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação do vetor de pivôs");
+    }
+    if (factored) {
+        #pragma omp parallel for schedule(static) num_threads(num_threads) if(num_threads > 1)
+        for (size_t i = 0; i < (size_t)n*n; i++) {
+            Ainv[i] = (double)A32[i];
+        }
+    }
+
+    return refine_or_invert(ctx, A, Ainv, n, factored, MIXED_MAX_ITER, info);
+}
+
+// Reinversão a partir de uma inversa anterior (im_parallel, método 7): em
+// vez da identidade, parte de guess e a atualiza por Newton-Schulz em poucos
+// produtos de matrizes. Se a aproximação estiver longe demais (resíduo >= 1
+// ou convergência prevista em mais de WARM_MAX_ITER iterações), volta para
+// invmat_invert_buffer
+invmat_status_t invmat_invert_from_guess(invmat_context_t *ctx, const double *A, const double *guess,
+                                         double *Ainv, int n, invmat_refine_info_t *info) {
+    invmat_status_t status = variant_setup(ctx, A, Ainv, n, "Newton-Schulz", 1);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    if (guess == NULL) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Inversa de partida nula");
+    }
+    invmat_refine_info_t local;
+    if (info == NULL) {
+        info = &local;
+    }
+    memset(info, 0, sizeof(*info));
+
+    if (guess != Ainv) {
+        memcpy(Ainv, guess, (size_t)n*n*sizeof(double));
+    }
+    return refine_or_invert(ctx, A, Ainv, n, 1, WARM_MAX_ITER, info);
+}
+
+// ---------------------------------------------------------------------------
+// Validação e geração
+// ---------------------------------------------------------------------------
+
+invmat_status_t invmat_validate_exact(invmat_context_t *ctx, const double *A, const double *Ainv,
+                                      int n, int *valid) {
+    if (ctx == NULL || A == NULL || Ainv == NULL || valid == NULL || n <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Argumento nulo ou tamanho inválido (%d)", n);
+    }
+    invmat_status_t status = invmat_context_reserve(ctx, n);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+
+    // O GEMM usa as threads OpenMP disponíveis: as do contexto, só durante o produto
+    int saved_threads = omp_get_max_threads();
+    omp_set_num_threads(ctx->num_threads);
+    gemm_workspace(n, n, n, 1.0, A, n, Ainv, n, 0.0, ctx->product, n, ctx->gemm_workspace);
+    omp_set_num_threads(saved_threads);
+
+    // Verifica se o resultado é aproximadamente a matriz identidade
+    const double *product = ctx->product;
+    *valid = 1;
+    for (int i = 0; i < n && *valid; i++) {
+        for (int j = 0; j < n; j++) {
+            double expected = (i == j) ? 1.0 : 0.0;
+            if (fabs(product[(size_t)i*n + j] - expected) > VALIDATION_EPSILON) {
+                *valid = 0;
+                break;
+            }
+        }
+    }
+    return INVMAT_OK;
+}
+
+invmat_status_t invmat_validate_by_rows(invmat_context_t *ctx, const double *A, const double *Ainv,
+                                        int n, int *valid) {
+    if (ctx == NULL || A == NULL || Ainv == NULL || valid == NULL || n <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Argumento nulo ou tamanho inválido (%d)", n);
+    }
+    int num_threads = ctx->num_threads;
+    int ok = 1, no_memory = 0;
+
+    // Cada thread calcula linhas de A * A^-1 num vetor próprio
+    #pragma omp parallel num_threads(num_threads) if(num_threads > 1)
+    {
+        double *r_row = (double*)malloc(n*sizeof(double));
+        if (r_row == NULL) {
+            #pragma omp atomic write
+            no_memory = 1;
+        }
+
+        #pragma omp for schedule(dynamic)
+        for (int i = 0; i < n; i++) {
+            int still_valid;
+            #pragma omp atomic read
+            still_valid = ok;
+            if (!still_valid || r_row == NULL) {
+                continue;
+            }
+
+            for (int j = 0; j < n; j++) {
+                r_row[j] = 0.0;
+            }
+            for (int k = 0; k < n; k++) {
+                simd_axpy(r_row, Ainv + (size_t)k*n, -A[(size_t)i*n + k], n);
+            }
+
+            for (int j = 0; j < n; j++) {
+                double expected = (i == j) ? 1.0 : 0.0;
+                if (fabs(r_row[j] - expected) > VALIDATION_EPSILON) {
+                    #pragma omp atomic write
+                    ok = 0;
+                    break;
+                }
+            }
+        }
+
+        free(r_row);
+    }
+
+    if (no_memory) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação das linhas de A * A^-1");
+    }
+    *valid = ok;
+    return INVMAT_OK;
+}
+
+invmat_status_t invmat_validate_freivalds(invmat_context_t *ctx, const double *A, const double *Ainv,
+                                          int n, int probes, unsigned int seed, double *residual) {
+    if (ctx == NULL || A == NULL || Ainv == NULL || residual == NULL || n <= 0 || probes <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Argumento nulo, tamanho ou número de sondas inválido");
+    }
+
+    double *x = (double*)malloc(n*sizeof(double));
+    double *z = (double*)malloc(n*sizeof(double));
+    if (x == NULL || z == NULL) {
+        free(x);
+        free(z);
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação dos vetores de Freivalds");
+    }
+
+    *residual = 0.0;
+    for (int p = 0; p < probes; p++) {
+        for (int i = 0; i < n; i++) {
+            x[i] = (rand_r(&seed) & 1) ? 1.0 : -1.0;
+        }
+
+        // z = A^-1 * x (linhas contíguas)
+        #pragma omp parallel for schedule(static) num_threads(ctx->num_threads)
+        for (int i = 0; i < n; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < n; j++) {
+                sum += Ainv[(size_t)i*n + j] * x[j];
+            }
+            z[i] = sum;
+        }
+
+        // r = A * z - x
+        double r_norm = 0.0;
+        #pragma omp parallel for schedule(static) reduction(max:r_norm) num_threads(ctx->num_threads)
+        for (int i = 0; i < n; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < n; j++) {
+                sum += A[(size_t)i*n + j] * z[j];
+            }
+            double r = fabs(sum - x[i]);
+            if (r > r_norm) {
+                r_norm = r;
+            }
+        }
+
+        if (r_norm > *residual) {
+            *residual = r_norm;
+        }
+    }
+
+    free(x);
+    free(z);
+    return INVMAT_OK;
+}
+
+void invmat_generate(double *A, int n, unsigned int seed) {
+    // Primeiro cria uma matriz diagonal com valores não nulos na diagonal
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (i == j) {
+                A[i*n + j] = (double)(rand_r(&seed) % 100) + 1.0; // Valores de 1 a 100 na diagonal
+            } else {
+                A[i*n + j] = 0.0;
+            }
+        }
+    }
+
+    // Soma múltiplos aleatórios de uma linha a outra: continua inversível,
+    // mas não trivial
+    for (int k = 0; k < n*2; k++) {
+        int row1 = rand_r(&seed) % n;
+        int row2 = rand_r(&seed) % n;
+
+        if (row1 != row2) {
+            double factor = (double)(rand_r(&seed) % 10) + 0.1;
+            for (int j = 0; j < n; j++) {
+                A[row1*n + j] += factor * A[row2*n + j];
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Matrizes
+// ---------------------------------------------------------------------------
+
+static invmat_status_t matrix_alloc(int n, int layout, invmat_matrix_t **matrix) {
+    if (matrix == NULL || n <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Matriz nula ou tamanho inválido (%d)", n);
+    }
+    *matrix = NULL;
+
+    invmat_matrix_t *m = (invmat_matrix_t*)calloc(1, sizeof(*m));
+    size_t bytes = ((size_t)n*n*sizeof(double) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    double *data = (m != NULL) ? (double*)aligned_alloc(ARENA_ALIGN, bytes) : NULL;
+    if (data == NULL) {
+        free(m);
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação de uma matriz %dx%d", n, n);
+    }
+    m->n = n;
+    m->layout = layout;
+    m->data = data;
+    *matrix = m;
+    return INVMAT_OK;
+}
+
+invmat_status_t invmat_matrix_create(int n, invmat_matrix_t **matrix) {
+    return matrix_alloc(n, MATRIX_ROW_MAJOR, matrix);
+}
+
+invmat_status_t invmat_matrix_copy(const invmat_matrix_t *src, invmat_matrix_t **matrix) {
+    if (src == NULL) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Matriz de origem nula");
+    }
+    invmat_status_t status = matrix_alloc(src->n, src->layout, matrix);
+    if (status == INVMAT_OK) {
+        memcpy((*matrix)->data, src->data, (size_t)src->n*src->n*sizeof(double));
+    }
+    return status;
+}
+
+invmat_status_t invmat_matrix_load(const char *path, invmat_matrix_t **matrix) {
+    if (path == NULL || matrix == NULL) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Caminho ou matriz nulos");
+    }
+    *matrix = NULL;
+
+    invmat_matrix_t *m = (invmat_matrix_t*)calloc(1, sizeof(*m));
+    if (m == NULL) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação de uma matriz");
+    }
+    // Só o formato com cabeçalho: sem ele não há como saber n
+    if (matrix_file_try_open(path, 0, &m->map, error_message, sizeof(error_message)) != 0) {
+        free(m);
+        return INVMAT_ERR_IO;
+    }
+    m->n = m->map.n;
+    m->layout = m->map.layout;
+    m->data = m->map.data;
+    *matrix = m;
+    return INVMAT_OK;
+}
+
+invmat_status_t invmat_matrix_save(const invmat_matrix_t *matrix, const char *path) {
+    if (matrix == NULL || path == NULL) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Matriz ou caminho nulos");
+    }
+
+    matrix_map_t out;
+    if (matrix_file_try_create(path, matrix->n, matrix->layout, &out, error_message, sizeof(error_message)) != 0) {
+        return INVMAT_ERR_IO;
+    }
+    memcpy(out.data, matrix->data, (size_t)matrix->n*matrix->n*sizeof(double));
+    if (matrix_file_try_close(&out, error_message, sizeof(error_message)) != 0) {
+        return INVMAT_ERR_IO;
+    }
+    return INVMAT_OK;
+}
+
+void invmat_matrix_destroy(invmat_matrix_t *matrix) {
+    if (matrix == NULL) {
+        return;
+    }
+    if (matrix->map.base != NULL) {
+        matrix_file_try_close(&matrix->map, NULL, 0);
+    } else {
+        free(matrix->data);
+    }
+    free(matrix);
+}
+
+int invmat_matrix_size(const invmat_matrix_t *matrix) {
+    return matrix->n;
+}
+
+int invmat_matrix_layout(const invmat_matrix_t *matrix) {
+    return matrix->layout;
+}
+
+double *invmat_matrix_data(invmat_matrix_t *matrix) {
+    return matrix->data;
+}
+
+const double *invmat_matrix_const_data(const invmat_matrix_t *matrix) {
+    return matrix->data;
+}
+
+invmat_status_t invmat_invert(invmat_context_t *ctx, const invmat_matrix_t *A, invmat_matrix_t *Ainv) {
+    if (A == NULL || Ainv == NULL) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Matriz nula");
+    }
+    if (A == Ainv || A->n != Ainv->n) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "A inversa deve ser outra matriz do mesmo tamanho (%dx%d e %dx%d)",
+                           A->n, A->n, Ainv->n, Ainv->n);
+    }
+    invmat_status_t status = invmat_invert_buffer(ctx, A->data, Ainv->data, A->n);
+    if (status == INVMAT_OK) {
+        Ainv->layout = A->layout;
+    }
+    return status;
+}
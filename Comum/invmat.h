@@ -0,0 +1,279 @@
+/*
+ * invmat.h - Biblioteca de inversão de matrizes (libinvmat.so): API C sobre as
+ * rotinas de Comum usadas por im_serial e im_parallel, para uso em outros
+ * programas. Nenhuma função imprime mensagens nem termina o processo: os
+ * erros voltam como invmat_status_t, com o detalhe em invmat_error_message()
+ *
+ * Uso típico:
+ *   invmat_context_t *ctx;
+ *   invmat_context_create(INVMAT_BACKEND_AUTO, 0, &ctx);
+ *   invmat_invert_buffer(ctx, A, Ainv, n);   // quantas vezes for preciso
+ *   invmat_context_destroy(ctx);
+ *
+ * As matrizes são n x n em double, orientadas a linhas. Uma matriz por
+ * colunas é A^T, e inv(A^T) = inv(A)^T, então a inversa sai na mesma ordem
+ * da entrada. Um contexto não deve ser usado por duas threads ao mesmo tempo;
+ * contextos diferentes são independentes. Para C++, ver invmat.hpp
+ */
+
+#ifndef INVMAT_H
+#define INVMAT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    INVMAT_OK = 0,
+    INVMAT_ERR_SINGULAR,        // pivô abaixo de 1e-10
+    INVMAT_ERR_INVALID_ARG,     // ponteiro nulo, n inválido, tamanhos diferentes
+    INVMAT_ERR_NO_MEMORY,
+    INVMAT_ERR_IO,              // leitura ou escrita de arquivo (Comum/matrix_file.h)
+    INVMAT_ERR_BACKEND          // backend indisponível ou erro do runtime OpenCL
+} invmat_status_t;
+
+// Algoritmo usado por um contexto
+typedef enum {
+    INVMAT_BACKEND_AUTO = 0,    // INVMAT_BACKEND do ambiente ou, sem ela, OpenMP
+    INVMAT_BACKEND_SERIAL_ROW,  // Gauss-Jordan serial orientado a linhas ("linhas")
+    INVMAT_BACKEND_SERIAL_COL,  // Gauss-Jordan serial orientado a colunas ("colunas")
+    INVMAT_BACKEND_OPENMP,      // Gauss-Jordan por linhas com OpenMP ("openmp")
+    INVMAT_BACKEND_OPENCL       // pipeline assíncrono no dispositivo ("opencl")
+} invmat_backend_t;
+
+typedef struct invmat_context invmat_context_t;
+typedef struct invmat_matrix invmat_matrix_t;
+
+// Texto fixo de cada status e mensagem detalhada da última falha da thread
+// que chamou (ex.: o arquivo que não pôde ser aberto)
+const char *invmat_status_string(invmat_status_t status);
+const char *invmat_error_message(void);
+
+// Nome de um backend ("linhas", "colunas", "openmp", "opencl") e o inverso
+const char *invmat_backend_name(invmat_backend_t backend);
+invmat_status_t invmat_backend_from_name(const char *name, invmat_backend_t *backend);
+
+// 1 se a biblioteca foi compilada com o backend (OpenCL só com make OPENCL=1)
+int invmat_backend_available(invmat_backend_t backend);
+
+// Contexto: backend, número de threads (0 = omp_get_max_threads(); os
+// backends seriais usam 1) e área de trabalho reaproveitada entre as
+// chamadas. Seleciona os kernels SIMD (simd_init, IM_ISA) e, no OpenCL,
+// escolhe o dispositivo (GPU, senão CPU) e compila os kernels uma vez. Um
+// IM_ISA ignorado não impede a criação: o aviso fica em invmat_error_message()
+invmat_status_t invmat_context_create(invmat_backend_t backend, int num_threads, invmat_context_t **ctx);
+void invmat_context_destroy(invmat_context_t *ctx);
+
+// Opções do backend OpenCL para invmat_context_create_opencl. Com
+// invmat_context_create, todas ficam zeradas e o cache de binários usa o
+// diretório da variável de ambiente INVMAT_OPENCL_CACHE (sem ela, sem cache)
+typedef struct {
+    const char *cache_dir;   // cache em disco dos binários dos kernels (NULL = sem cache)
+    int rebuild;             // compila do fonte mesmo com o cache válido e o regrava
+    int force_copies;        // cópias explícitas mesmo em dispositivos com memória unificada
+    int synchronous;         // pipeline original, com o pivô no host e clFinish após cada
+                             // kernel (até 6 sincronizações por coluna), para comparação
+    size_t tile[2];          // work-group da eliminação: colunas de double4 x linhas (0 = automático)
+} invmat_opencl_options_t;
+
+// Medidas do backend OpenCL. As de inversão são da última chamada de
+// invmat_invert_buffer; os bytes copiados são acumulados no contexto
+typedef struct {
+    double build_time;               // programa dos kernels: carga do cache ou compilação
+    int cache_hit;                   // 1 se o binário veio do cache
+    char cache_note[192];            // por que o cache não foi usado ou gravado (vazio se foi)
+    int host_unified;                // CL_DEVICE_HOST_UNIFIED_MEMORY
+    size_t host_align;               // alinhamento de A e Ainv para o zero-copy
+    unsigned long long global_mem;   // memória global do dispositivo, em bytes
+    int zero_copy;                   // buffers sobre A e Ainv, sem cópias
+    size_t tile[2];                  // work-group da eliminação
+    double pipeline_time;            // das n colunas até a leitura do indicador de pivô
+    double enqueue_time;             // tempo do host para enfileirar as n colunas
+    int host_syncs;                  // sincronizações com o host na eliminação
+    size_t bytes_to_device, bytes_to_host;
+} invmat_opencl_stats_t;
+
+// Contexto do backend OpenCL com opções (options pode ser NULL). O contexto
+// usa o mesmo invmat_invert_buffer dos demais backends
+invmat_status_t invmat_context_create_opencl(const invmat_opencl_options_t *options, invmat_context_t **ctx);
+
+// Medidas de um contexto OpenCL (INVMAT_ERR_BACKEND nos demais)
+invmat_status_t invmat_context_opencl_stats(const invmat_context_t *ctx, invmat_opencl_stats_t *stats);
+
+invmat_backend_t invmat_context_backend(const invmat_context_t *ctx);
+int invmat_context_threads(const invmat_context_t *ctx);
+
+// Kernels SIMD em uso ou, no OpenCL, o nome do dispositivo
+const char *invmat_context_device(const invmat_context_t *ctx);
+
+// Reserva a área de trabalho para matrizes de até n x n, numa arena em
+// páginas grandes (Comum/arena.h) tocada aqui, com a mesma divisão de linhas
+// por thread da eliminação. Opcional: as inversões crescem a área sob
+// demanda, mas chamar antes tira a alocação e as faltas de página delas
+invmat_status_t invmat_context_reserve(invmat_context_t *ctx, int n);
+
+// Área de trabalho atual: bytes reservados, bytes em páginas grandes (-1 se
+// não souber) e como as páginas foram obtidas. Qualquer ponteiro pode ser NULL
+void invmat_context_scratch(const invmat_context_t *ctx, size_t *bytes, long *huge_bytes,
+                            const char **backing);
+
+// Inverte A em Ainv (buffers do chamador, ex.: um arquivo mapeado, sem
+// sobreposição). A não é alterada
+invmat_status_t invmat_invert_buffer(invmat_context_t *ctx, const double *A, double *Ainv, int n);
+
+// Variantes do Gauss-Jordan de im_serial e im_parallel. Rodam com as threads
+// do contexto (uma nos backends seriais, em que a orientação só vale para
+// invmat_invert_buffer) e retornam INVMAT_ERR_BACKEND no OpenCL
+
+// Blocada: painéis de block colunas (0 = 64) e o restante de [temp_A | Ainv]
+// atualizado por tiles, como um produto matriz-matriz
+invmat_status_t invmat_invert_blocked(invmat_context_t *ctx, const double *A, double *Ainv, int n, int block);
+
+// Fatoração LU com pivotamento parcial (~2n^3 flops, metade do Gauss-Jordan)
+invmat_status_t invmat_invert_lu(invmat_context_t *ctx, const double *A, double *Ainv, int n);
+
+// Uma só região paralela para todo o laço k, com pivô por candidatos por
+// thread (sem lock) e a busca do próximo pivô na passada da eliminação
+invmat_status_t invmat_invert_persistent(invmat_context_t *ctx, const double *A, double *Ainv, int n);
+
+// Tempo somado das threads em tarefas e tempo total de invmat_invert_tiled;
+// busy_time / (threads x wall_time) é a utilização das threads
+typedef struct {
+    double busy_time;
+    double wall_time;
+} invmat_tiled_stats_t;
+
+// Blocada com escalonador de DAG: faixas de tile colunas (0 = 64) e até
+// lookahead passos com atualizações pendentes quando um painel começa
+// (0 = síncrono). stats pode ser NULL
+invmat_status_t invmat_invert_tiled(invmat_context_t *ctx, const double *A, double *Ainv, int n,
+                                    int tile, int lookahead, invmat_tiled_stats_t *stats);
+
+// Confere a versão com DAG de tiles tarefa a tarefa: cada faixa atualizada é
+// comparada com o estado do Gauss-Jordan por linhas no mesmo passo, e
+// *max_error recebe a maior diferença relativa ao maior elemento da faixa.
+// Guarda um estado de 2n^2 doubles por painel (para depuração e testes)
+invmat_status_t invmat_check_tiled(invmat_context_t *ctx, const double *A, int n, int tile, int lookahead,
+                                   double *max_error);
+
+// In-place (substituição de colunas): A é substituída pela inversa, sem
+// buffer n^2 além dela. Em caso de erro, A fica com lixo
+invmat_status_t invmat_invert_in_place(invmat_context_t *ctx, double *A, int n);
+
+// Resíduos guardados de um refinamento por Newton-Schulz
+#define INVMAT_REFINE_HISTORY 16
+
+// Motivo do recálculo em double de invmat_invert_mixed e
+// invmat_invert_from_guess
+typedef enum {
+    INVMAT_FALLBACK_NONE = 0,
+    INVMAT_FALLBACK_CONDITION,  // max|A| / min|pivô| em float acima de ~8e5 (só precisão mista)
+    INVMAT_FALLBACK_PIVOT,      // pivô em float abaixo de 1e-10 (só precisão mista)
+    INVMAT_FALLBACK_DIVERGED,   // ||I - A*X||_inf >= 1 ou não finito
+    INVMAT_FALLBACK_SLOW,       // convergência prevista além do limite de iterações
+    INVMAT_FALLBACK_STAGNATED   // resíduo parou de cair acima da tolerância
+} invmat_fallback_t;
+
+// Texto de um motivo de recálculo, para os relatórios
+const char *invmat_fallback_reason(invmat_fallback_t reason);
+
+// Resultado de invmat_invert_mixed e invmat_invert_from_guess: iterações de
+// Newton-Schulz (dois produtos n x n cada), ||I - A*X||_inf antes de cada uma
+// e no fim, fallback = 1 se a inversa foi recalculada do zero em double (e
+// por quê) e, na precisão mista, a estimativa de condicionamento max|A| /
+// min|pivô| da fatoração em float (até onde ela foi)
+typedef struct {
+    int iterations;
+    int fallback;
+    double residual;
+    double history[INVMAT_REFINE_HISTORY];
+    int history_len;
+    invmat_fallback_t reason;
+    double condition_estimate;
+} invmat_refine_info_t;
+
+// Precisão mista: Gauss-Jordan in-place em float e refinamento em double por
+// Newton-Schulz até o resíduo de arredondamento; se não chegar a 1e-6,
+// invmat_invert_buffer. Compensa para matrizes bem condicionadas (cond(A)
+// até ~1e6); acima disso a fatoração em float é abandonada cedo pela
+// estimativa dos pivôs. info pode ser NULL
+invmat_status_t invmat_invert_mixed(invmat_context_t *ctx, const double *A, double *Ainv, int n,
+                                    invmat_refine_info_t *info);
+
+// Reinversão de uma matriz que mudou pouco: Newton-Schulz a partir de guess
+// (uma inversa anterior), com invmat_invert_buffer se ela estiver longe
+// demais. Ainv pode ser o próprio guess. info pode ser NULL
+invmat_status_t invmat_invert_from_guess(invmat_context_t *ctx, const double *A, const double *guess,
+                                         double *Ainv, int n, invmat_refine_info_t *info);
+
+// Kernels sem contexto, com temp_A (n x n) do chamador, para quem já gerencia
+// a própria área de trabalho (ex.: o pool de im_server): Gauss-Jordan por
+// linhas serial e com num_threads threads OpenMP. Não tentam os kernels de
+// tamanho fixo (invert_fixed_size, Comum/fixed_size_kernels.h)
+invmat_status_t invmat_gauss_jordan_serial(const double *A, double *Ainv, double *temp_A, int n);
+invmat_status_t invmat_gauss_jordan_openmp(const double *A, double *Ainv, double *temp_A, int n, int num_threads);
+
+// Matrizes de um grupo intercalado (8 doubles = um registrador AVX-512 ou
+// dois AVX2)
+#define INVMAT_BATCH_LANES 8
+
+// Lote intercalado de matrizes n x n: o elemento (i,j) da matriz b fica em
+// [(i*n + j)*batch + b], na entrada e na saída. As threads do contexto
+// invertem grupos de INVMAT_BATCH_LANES matrizes, uma por pista SIMD.
+// status[b] recebe 1 ou 0 (singular); *failures (pode ser NULL), o número
+// de singulares
+invmat_status_t invmat_invert_batch(invmat_context_t *ctx, const double *A, double *Ainv, int *status,
+                                    int n, int batch, int *failures);
+
+// Um grupo de count <= INVMAT_BATCH_LANES matrizes separadas de mesmo n, com
+// W e V do chamador (n*n*INVMAT_BATCH_LANES doubles cada, alinhados a 64
+// bytes). ok[l] recebe 1 ou 0 (singular). Serial: para lotes montados por
+// quem chama, uma thread por grupo
+void invmat_invert_lanes(const double *const *A, double *const *Ainv, int *ok, int count, int n,
+                         double *W, double *V);
+
+// Confere A * A^-1 = I entrada a entrada (tolerância 1e-6), com o produto e
+// os buffers do GEMM na área de trabalho do contexto. *valid recebe 1 ou 0
+invmat_status_t invmat_validate_exact(invmat_context_t *ctx, const double *A, const double *Ainv,
+                                      int n, int *valid);
+
+// A mesma conferência uma linha de A * A^-1 por vez, sem buffer n^2 (para o
+// modo in-place, em que a memória é o motivo da escolha)
+invmat_status_t invmat_validate_by_rows(invmat_context_t *ctx, const double *A, const double *Ainv,
+                                        int n, int *valid);
+
+// Teste de Freivalds: maior ||A*(A^-1*x) - x||_inf para probes vetores
+// aleatórios x de +-1 (gerados a partir de seed), em O(n^2) e sem buffer n^2.
+// Uma inversa errada passa com probabilidade <= 2^-probes
+invmat_status_t invmat_validate_freivalds(invmat_context_t *ctx, const double *A, const double *Ainv,
+                                          int n, int probes, unsigned int seed, double *residual);
+
+// Matriz inversível aleatória (diagonal de 1 a 100 e 2n combinações de
+// linhas), a mesma construção dos programas de teste
+void invmat_generate(double *A, int n, unsigned int seed);
+
+// Matrizes da biblioteca. invmat_matrix_create não inicializa os elementos.
+// invmat_matrix_load usa o mapeamento privado do arquivo como a própria
+// matriz (sem cópia, exceto de arquivos float32) e confere o checksum;
+// invmat_matrix_save grava no formato de Comum/matrix_file.h, na ordem da matriz
+invmat_status_t invmat_matrix_create(int n, invmat_matrix_t **matrix);
+invmat_status_t invmat_matrix_copy(const invmat_matrix_t *src, invmat_matrix_t **matrix);
+invmat_status_t invmat_matrix_load(const char *path, invmat_matrix_t **matrix);
+invmat_status_t invmat_matrix_save(const invmat_matrix_t *matrix, const char *path);
+void invmat_matrix_destroy(invmat_matrix_t *matrix);
+
+int invmat_matrix_size(const invmat_matrix_t *matrix);
+int invmat_matrix_layout(const invmat_matrix_t *matrix);   // MATRIX_ROW_MAJOR ou MATRIX_COL_MAJOR
+double *invmat_matrix_data(invmat_matrix_t *matrix);
+const double *invmat_matrix_const_data(const invmat_matrix_t *matrix);
+
+// Inverte A em Ainv (mesmo tamanho); Ainv fica na ordem de A
+invmat_status_t invmat_invert(invmat_context_t *ctx, const invmat_matrix_t *A, invmat_matrix_t *Ainv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ * invmat.hpp - Interface C++ da libinvmat (invmat.h): Matrix e Context donos
+ * dos objetos C (RAII), apenas movíveis, para que nenhuma matriz seja copiada
+ * sem um clone() explícito. Falhas viram invmat::Error com o status da API C;
+ * Context::try_invert devolve o status para quem não usa exceções
+ */
+
+#ifndef INVMAT_HPP
+#define INVMAT_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "invmat.h"
+
+namespace invmat {
+
+enum class Backend {
+    Auto = INVMAT_BACKEND_AUTO,
+    SerialRow = INVMAT_BACKEND_SERIAL_ROW,
+    SerialCol = INVMAT_BACKEND_SERIAL_COL,
+    OpenMP = INVMAT_BACKEND_OPENMP,
+    OpenCL = INVMAT_BACKEND_OPENCL
+};
+
+class Error : public std::runtime_error {
+public:
+    Error(invmat_status_t status, const char *message)
+        : std::runtime_error(message), status_(status) {}
+
+    invmat_status_t status() const noexcept { return status_; }
+
+private:
+    invmat_status_t status_;
+};
+
+// Lança Error com a mensagem detalhada da última falha desta thread
+inline void check(invmat_status_t status) {
+    if (status != INVMAT_OK) {
+        throw Error(status, invmat_error_message());
+    }
+}
+
+class Matrix {
+public:
+    // Elementos não inicializados
+    explicit Matrix(int n) { check(invmat_matrix_create(n, &m_)); }
+
+    // Arquivo no formato de Comum/matrix_file.h, mapeado sem cópia
+    static Matrix load(const std::string &path) {
+        invmat_matrix_t *m = nullptr;
+        check(invmat_matrix_load(path.c_str(), &m));
+        return Matrix(m);
+    }
+
+    Matrix(Matrix &&other) noexcept : m_(other.m_) { other.m_ = nullptr; }
+    Matrix &operator=(Matrix &&other) noexcept {
+        if (this != &other) {
+            invmat_matrix_destroy(m_);
+            m_ = other.m_;
+            other.m_ = nullptr;
+        }
+        return *this;
+    }
+    Matrix(const Matrix &) = delete;
+    Matrix &operator=(const Matrix &) = delete;
+    ~Matrix() { invmat_matrix_destroy(m_); }
+
+    // Única forma de copiar os elementos
+    Matrix clone() const {
+        invmat_matrix_t *m = nullptr;
+        check(invmat_matrix_copy(m_, &m));
+        return Matrix(m);
+    }
+
+    void save(const std::string &path) const { check(invmat_matrix_save(m_, path.c_str())); }
+
+    int size() const noexcept { return invmat_matrix_size(m_); }
+    int layout() const noexcept { return invmat_matrix_layout(m_); }
+    double *data() noexcept { return invmat_matrix_data(m_); }
+    const double *data() const noexcept { return invmat_matrix_const_data(m_); }
+
+    double &operator()(int i, int j) noexcept { return data()[(std::size_t)i*size() + j]; }
+    double operator()(int i, int j) const noexcept { return data()[(std::size_t)i*size() + j]; }
+
+    // Objeto C, para chamar a API diretamente (continua pertencendo a Matrix)
+    invmat_matrix_t *get() noexcept { return m_; }
+    const invmat_matrix_t *get() const noexcept { return m_; }
+
+private:
+    explicit Matrix(invmat_matrix_t *m) noexcept : m_(m) {}
+
+    invmat_matrix_t *m_ = nullptr;
+};
+
+class Context {
+public:
+    explicit Context(Backend backend = Backend::Auto, int num_threads = 0) {
+        check(invmat_context_create(static_cast<invmat_backend_t>(backend), num_threads, &ctx_));
+    }
+
+    Context(Context &&other) noexcept : ctx_(other.ctx_) { other.ctx_ = nullptr; }
+    Context &operator=(Context &&other) noexcept {
+        if (this != &other) {
+            invmat_context_destroy(ctx_);
+            ctx_ = other.ctx_;
+            other.ctx_ = nullptr;
+        }
+        return *this;
+    }
+    Context(const Context &) = delete;
+    Context &operator=(const Context &) = delete;
+    ~Context() { invmat_context_destroy(ctx_); }
+
+    Backend backend() const noexcept { return static_cast<Backend>(invmat_context_backend(ctx_)); }
+    int threads() const noexcept { return invmat_context_threads(ctx_); }
+    std::string device() const { return invmat_context_device(ctx_); }
+
+    void reserve(int n) { check(invmat_context_reserve(ctx_, n)); }
+
+    // Inversa numa matriz nova (retornada por movimento)
+    Matrix inverse(const Matrix &A) {
+        Matrix Ainv(A.size());
+        invert(A, Ainv);
+        return Ainv;
+    }
+
+    // Inversa numa matriz existente do mesmo tamanho, sem alocar
+    void invert(const Matrix &A, Matrix &Ainv) { check(try_invert(A, Ainv)); }
+
+    invmat_status_t try_invert(const Matrix &A, Matrix &Ainv) noexcept {
+        return invmat_invert(ctx_, A.get(), Ainv.get());
+    }
+
+    // Maior resíduo do teste de Freivalds (< 1e-6 para uma inversa válida)
+    double residual(const Matrix &A, const Matrix &Ainv, int probes = 3, unsigned int seed = 1) {
+        if (A.size() != Ainv.size()) {
+            throw Error(INVMAT_ERR_INVALID_ARG, "Matrizes de tamanhos diferentes");
+        }
+        double r;
+        check(invmat_validate_freivalds(ctx_, A.data(), Ainv.data(), A.size(), probes, seed, &r));
+        return r;
+    }
+
+    // A * A^-1 = I entrada a entrada
+    bool validate_exact(const Matrix &A, const Matrix &Ainv) {
+        if (A.size() != Ainv.size()) {
+            throw Error(INVMAT_ERR_INVALID_ARG, "Matrizes de tamanhos diferentes");
+        }
+        int valid;
+        check(invmat_validate_exact(ctx_, A.data(), Ainv.data(), A.size(), &valid));
+        return valid != 0;
+    }
+
+    invmat_context_t *get() noexcept { return ctx_; }
+
+private:
+    invmat_context_t *ctx_ = nullptr;
+};
+
+}  // namespace invmat
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ * invmat_batch.c - Lotes de matrizes pequenas da libinvmat (im_batch e
+ * im_server): grupos de INVMAT_BATCH_LANES matrizes intercaladas, invertidos
+ * com o laço sobre as matrizes do grupo no nível mais interno, de modo que
+ * cada pista SIMD avança uma matriz
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#include "invmat.h"
+#include "invmat_internal.h"
+
+#define BATCH_LANES INVMAT_BATCH_LANES
+
+// Pivô mínimo do caminho genérico
+#define PIVOT_MIN 1e-10
+
+// Gauss-Jordan de um grupo de BATCH_LANES matrizes intercaladas (W é a cópia
+// de A e V começa como identidade). Compilada em versões AVX-512, AVX2 e
+// genérica, escolhidas na carga da biblioteca conforme a CPU, pois os laços
+// sobre as pistas dependem da largura do registrador. ok[l] = 0 marca as
+// matrizes que parecem singulares
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static void invert_group(double *W, double *V, int n, int *ok) {
+    int pivot_row[BATCH_LANES];
+    double pivot_value[BATCH_LANES];
+    double pivot[BATCH_LANES];
+    double factor[BATCH_LANES];
+
+    for (int l = 0; l < BATCH_LANES; l++) {
+        ok[l] = 1;
+    }
+
+    for (int k = 0; k < n; k++) {
+        // Encontra o pivô de cada matriz (valor máximo na coluna k)
+        for (int l = 0; l < BATCH_LANES; l++) {
+            pivot_row[l] = k;
+            pivot_value[l] = fabs(W[(k*n + k)*BATCH_LANES + l]);
+        }
+        for (int i = k + 1; i < n; i++) {
+            #pragma omp simd
+            for (int l = 0; l < BATCH_LANES; l++) {
+                double abs_value = fabs(W[(i*n + k)*BATCH_LANES + l]);
+                if (abs_value > pivot_value[l]) {
+                    pivot_value[l] = abs_value;
+                    pivot_row[l] = i;
+                }
+            }
+        }
+
+        // Matrizes singulares são marcadas e seguem com pivô 1 para
+        // não contaminar o grupo com divisões por zero
+        for (int l = 0; l < BATCH_LANES; l++) {
+            if (pivot_value[l] < PIVOT_MIN) {
+                ok[l] = 0;
+                pivot_row[l] = k;
+                W[(k*n + k)*BATCH_LANES + l] = 1.0;
+            }
+        }
+
+        // Troca as linhas de cada matriz, se necessário
+        for (int l = 0; l < BATCH_LANES; l++) {
+            int p = pivot_row[l];
+            if (p != k) {
+                for (int j = 0; j < n; j++) {
+                    double temp = W[(k*n + j)*BATCH_LANES + l];
+                    W[(k*n + j)*BATCH_LANES + l] = W[(p*n + j)*BATCH_LANES + l];
+                    W[(p*n + j)*BATCH_LANES + l] = temp;
+
+                    temp = V[(k*n + j)*BATCH_LANES + l];
+                    V[(k*n + j)*BATCH_LANES + l] = V[(p*n + j)*BATCH_LANES + l];
+                    V[(p*n + j)*BATCH_LANES + l] = temp;
+                }
+            }
+        }
+
+        // Normaliza a linha do pivô. As colunas de W até k não são
+        // mais lidas depois deste passo, então só as seguintes são
+        // atualizadas (a inversa V é atualizada por inteiro)
+        for (int l = 0; l < BATCH_LANES; l++) {
+            pivot[l] = W[(k*n + k)*BATCH_LANES + l];
+        }
+        for (int j = k + 1; j < n; j++) {
+            double *w_row = W + (k*n + j)*BATCH_LANES;
+            #pragma omp simd aligned(w_row : 64)
+            for (int l = 0; l < BATCH_LANES; l++) {
+                w_row[l] /= pivot[l];
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            double *v_row = V + (k*n + j)*BATCH_LANES;
+            #pragma omp simd aligned(v_row : 64)
+            for (int l = 0; l < BATCH_LANES; l++) {
+                v_row[l] /= pivot[l];
+            }
+        }
+
+        // Eliminação de Gauss
+        for (int i = 0; i < n; i++) {
+            if (i == k) {
+                continue;
+            }
+            for (int l = 0; l < BATCH_LANES; l++) {
+                factor[l] = W[(i*n + k)*BATCH_LANES + l];
+            }
+            for (int j = k + 1; j < n; j++) {
+                double *w_dst = W + (i*n + j)*BATCH_LANES;
+                const double *w_src = W + (k*n + j)*BATCH_LANES;
+                #pragma omp simd aligned(w_dst, w_src : 64)
+                for (int l = 0; l < BATCH_LANES; l++) {
+                    w_dst[l] -= factor[l] * w_src[l];
+                }
+            }
+            for (int j = 0; j < n; j++) {
+                double *v_dst = V + (i*n + j)*BATCH_LANES;
+                const double *v_src = V + (k*n + j)*BATCH_LANES;
+                #pragma omp simd aligned(v_dst, v_src : 64)
+                for (int l = 0; l < BATCH_LANES; l++) {
+                    v_dst[l] -= factor[l] * v_src[l];
+                }
+            }
+        }
+    }
+}
+
+void invmat_invert_lanes(const double *const *A, double *const *Ainv, int *ok, int count, int n,
+                         double *W, double *V) {
+    // As pistas sem matriz recebem a identidade, mantendo os laços internos
+    // sempre com BATCH_LANES iterações
+    for (int e = 0; e < n*n; e++) {
+        int diagonal = (e / n) == (e % n);
+        for (int l = 0; l < BATCH_LANES; l++) {
+            W[e*BATCH_LANES + l] = (l < count) ? A[l][e] : (diagonal ? 1.0 : 0.0);
+            V[e*BATCH_LANES + l] = diagonal ? 1.0 : 0.0;
+        }
+    }
+
+    int lane_ok[BATCH_LANES];
+    invert_group(W, V, n, lane_ok);
+
+    for (int l = 0; l < count; l++) {
+        for (int e = 0; e < n*n; e++) {
+            Ainv[l][e] = V[e*BATCH_LANES + l];
+        }
+        ok[l] = lane_ok[l];
+    }
+}
+
+invmat_status_t invmat_invert_batch(invmat_context_t *ctx, const double *A, double *Ainv, int *status,
+                                    int n, int batch, int *failures) {
+    if (ctx == NULL || A == NULL || Ainv == NULL || status == NULL || n <= 0 || batch <= 0) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Argumento nulo, tamanho ou lote inválido");
+    }
+    if (invmat_context_backend(ctx) == INVMAT_BACKEND_OPENCL) {
+        return invmat_fail(INVMAT_ERR_BACKEND, "Os lotes intercalados não existem no backend opencl");
+    }
+
+    int num_groups = (batch + BATCH_LANES - 1) / BATCH_LANES;
+    size_t group_bytes = (size_t)n*n*BATCH_LANES*sizeof(double);
+    int singular = 0, no_memory = 0;
+
+    #pragma omp parallel reduction(+:singular) num_threads(invmat_context_threads(ctx))
+    {
+        // Cópias de trabalho de um grupo (A e inversa), alocadas uma vez por thread
+        double *W = (double*)aligned_alloc(64, group_bytes);
+        double *V = (double*)aligned_alloc(64, group_bytes);
+        if (W == NULL || V == NULL) {
+            #pragma omp atomic write
+            no_memory = 1;
+        }
+
+        #pragma omp for schedule(static)
+        for (int g = 0; g < num_groups; g++) {
+            if (W == NULL || V == NULL) {
+                continue;
+            }
+            int b0 = g * BATCH_LANES;
+            int lanes = (b0 + BATCH_LANES <= batch) ? BATCH_LANES : batch - b0;
+
+            int ok[BATCH_LANES];
+
+            // Copia o grupo do lote intercalado e inicializa a identidade.
+            // No último grupo, as pistas sem matriz recebem a identidade
+            for (int e = 0; e < n*n; e++) {
+                int diagonal = (e / n) == (e % n);
+                for (int l = 0; l < BATCH_LANES; l++) {
+                    if (l < lanes) {
+                        W[e*BATCH_LANES + l] = A[(size_t)e*batch + b0 + l];
+                    } else {
+                        W[e*BATCH_LANES + l] = diagonal ? 1.0 : 0.0;
+                    }
+                    V[e*BATCH_LANES + l] = diagonal ? 1.0 : 0.0;
+                }
+            }
+            invert_group(W, V, n, ok);
+
+            // Devolve as inversas do grupo ao lote intercalado
+            for (int e = 0; e < n*n; e++) {
+                for (int l = 0; l < lanes; l++) {
+                    Ainv[(size_t)e*batch + b0 + l] = V[e*BATCH_LANES + l];
+                }
+            }
+            for (int l = 0; l < lanes; l++) {
+                status[b0 + l] = ok[l];
+                if (!ok[l]) {
+                    singular++;
+                }
+            }
+        }
+
+        free(W);
+        free(V);
+    }
+
+    if (no_memory) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação dos grupos de %d matrizes %dx%d",
+                           BATCH_LANES, n, n);
+    }
+    if (failures != NULL) {
+        *failures = singular;
+    }
+    return INVMAT_OK;
+}
@@ -0,0 +1,34 @@
+/*
+ * invmat_internal.h - Ligação entre invmat.c, os lotes (invmat_batch.c) e
+ * o backend OpenCL (invmat_opencl.c, compilado só com make OPENCL=1). Não faz
+ * parte da API
+ */
+
+#ifndef INVMAT_INTERNAL_H
+#define INVMAT_INTERNAL_H
+
+#include "invmat.h"
+
+// Guarda a mensagem de invmat_error_message() e retorna status
+invmat_status_t invmat_fail(invmat_status_t status, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+#ifdef INVMAT_OPENCL
+
+typedef struct invmat_opencl invmat_opencl_t;
+
+// Dispositivo (GPU, senão CPU da primeira plataforma) e kernels compilados
+// ou lidos do cache (options não é NULL)
+invmat_status_t invmat_opencl_create(const invmat_opencl_options_t *options, invmat_opencl_t **cl);
+void invmat_opencl_destroy(invmat_opencl_t *cl);
+const char *invmat_opencl_device(const invmat_opencl_t *cl);
+
+// Copia A para o dispositivo (ou a usa diretamente, no zero-copy), enfileira
+// as n colunas sem sincronizar e lê a inversa (buffers do dispositivo
+// refeitos só quando n muda)
+invmat_status_t invmat_opencl_invert(invmat_opencl_t *cl, const double *A, double *Ainv, int n);
+void invmat_opencl_stats(const invmat_opencl_t *cl, invmat_opencl_stats_t *stats);
+
+#endif
+
+#endif
@@ -0,0 +1,885 @@
+/*
+ * invmat_opencl.c - Backend OpenCL da libinvmat (usado por im_opencl): o
+ * pipeline assíncrono (redução do pivô, troca + normalização e eliminação em
+ * tiles no dispositivo, uma única leitura do indicador de singularidade no
+ * fim), o pipeline síncrono original para comparação, o cache em disco dos
+ * binários dos kernels e os buffers zero-copy em dispositivos com memória
+ * unificada. Os erros do runtime voltam como INVMAT_ERR_BACKEND em vez de exit
+ */
+
+#define CL_TARGET_OPENCL_VERSION 120
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include "invmat_internal.h"
+
+static const char *kernel_source = "\n" \
+"#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n\n" \
+"__kernel void init_identity(__global double* I, const int n) {\n" \
+"    int i = get_global_id(0);\n" \
+"    int j = get_global_id(1);\n" \
+"    if (i < n && j < n) I[i * n + j] = (i == j) ? 1.0 : 0.0;\n" \
+"}\n\n" \
+"__kernel void find_pivot(__global double* A,\n" \
+"                         const int n,\n" \
+"                         const int k,\n" \
+"                         __global double* pivot_vals) {\n" \
+"    int i = get_global_id(0) + k;\n" \
+"    if (i < n) {\n" \
+"        pivot_vals[i-k] = fabs(A[i * n + k]);\n" \
+"    }\n" \
+"}\n\n" \
+"__kernel void swap_rows(__global double* matrix, const int n, const int row1, const int row2) {\n" \
+"    int j = get_global_id(0);\n" \
+"    if (j < n) {\n" \
+"        double temp = matrix[row1 * n + j];\n" \
+"        matrix[row1 * n + j] = matrix[row2 * n + j];\n" \
+"        matrix[row2 * n + j] = temp;\n" \
+"    }\n" \
+"}\n\n" \
+"__kernel void normalize_row(__global double* A, __global double* I, const int n, const int k) {\n" \
+"    int j = get_global_id(0);\n" \
+"    if (j < n) {\n" \
+"        double pivot = A[k * n + k];\n" \
+"        if (pivot != 0.0) {\n" \
+"            A[k * n + j] /= pivot;\n" \
+"            I[k * n + j] /= pivot;\n" \
+"        }\n" \
+"    }\n" \
+"}\n\n" \
+"__kernel void eliminate_row(__global double* A,\n" \
+"                           __global double* I,\n" \
+"                           const int n,\n" \
+"                           const int k) {\n" \
+"    int i = get_global_id(0);\n" \
+"    int j = get_global_id(1);\n" \
+"    if (i < n && j < n && i != k) {\n" \
+"        // A coluna k de A não é escrita: ela é o fator das demais colunas\n" \
+"        // e não é mais lida depois deste passo\n" \
+"        double factor = A[i * n + k];\n" \
+"        if (j != k) A[i * n + j] -= factor * A[k * n + j];\n" \
+"        I[i * n + j] -= factor * I[k * n + j];\n" \
+"    }\n" \
+"}\n\n" \
+"__kernel void pivot_reduce(__global const double* A,\n" \
+"                           const int n,\n" \
+"                           const int k,\n" \
+"                           __global int* pivot_info,\n" \
+"                           __global double* pivot_value,\n" \
+"                           __local double* best_val,\n" \
+"                           __local int* best_row) {\n" \
+"    int lid = get_local_id(0);\n" \
+"    int lsize = get_local_size(0);\n" \
+"    double my_val = -1.0;\n" \
+"    int my_row = k;\n" \
+"    for (int i = k + lid; i < n; i += lsize) {\n" \
+"        double v = fabs(A[i * n + k]);\n" \
+"        if (v > my_val) { my_val = v; my_row = i; }\n" \
+"    }\n" \
+"    best_val[lid] = my_val;\n" \
+"    best_row[lid] = my_row;\n" \
+"    barrier(CLK_LOCAL_MEM_FENCE);\n" \
+"    for (int s = lsize / 2; s > 0; s >>= 1) {\n" \
+"        if (lid < s) {\n" \
+"            double v = best_val[lid + s];\n" \
+"            int r = best_row[lid + s];\n" \
+"            if (v > best_val[lid] || (v == best_val[lid] && r < best_row[lid])) {\n" \
+"                best_val[lid] = v;\n" \
+"                best_row[lid] = r;\n" \
+"            }\n" \
+"        }\n" \
+"        barrier(CLK_LOCAL_MEM_FENCE);\n" \
+"    }\n" \
+"    if (lid == 0) {\n" \
+"        int p = best_row[0];\n" \
+"        pivot_info[0] = p;\n" \
+"        pivot_value[0] = A[p * n + k];\n" \
+"        pivot_value[1] = A[k * n + k];\n" \
+"        if (best_val[0] < 1e-10) pivot_info[1] = 1;\n" \
+"    }\n" \
+"}\n\n" \
+"__kernel void swap_normalize(__global double* A,\n" \
+"                             __global double* I,\n" \
+"                             const int n,\n" \
+"                             const int k,\n" \
+"                             __global const int* pivot_info,\n" \
+"                             __global const double* pivot_value,\n" \
+"                             __global double* factors) {\n" \
+"    int j = get_global_id(0);\n" \
+"    if (j < n) {\n" \
+"        int p = pivot_info[0];\n" \
+"        factors[j] = (j == k) ? 0.0 : (j == p) ? pivot_value[1] : A[j * n + k];\n" \
+"        double pivot = pivot_value[0];\n" \
+"        if (pivot == 0.0) pivot = 1.0;\n" \
+"        double a_k = A[k * n + j], a_p = A[p * n + j];\n" \
+"        double i_k = I[k * n + j], i_p = I[p * n + j];\n" \
+"        A[p * n + j] = a_k;\n" \
+"        I[p * n + j] = i_k;\n" \
+"        A[k * n + j] = a_p / pivot;\n" \
+"        I[k * n + j] = i_p / pivot;\n" \
+"    }\n" \
+"}\n\n" \
+"__kernel void eliminate_tiled(__global double* A,\n" \
+"                              __global double* I,\n" \
+"                              const int n,\n" \
+"                              const int k,\n" \
+"                              __global const double* factors,\n" \
+"                              __local double4* pivot_a,\n" \
+"                              __local double4* pivot_i,\n" \
+"                              __local double* factor_tile) {\n" \
+"    int lx = get_local_id(0);\n" \
+"    int ly = get_local_id(1);\n" \
+"    int j = get_global_id(0) * 4;\n" \
+"    int i = get_global_id(1);\n" \
+"    if (ly == 0) {\n" \
+"        if (j + 4 <= n) {\n" \
+"            pivot_a[lx] = vload4(0, A + k * n + j);\n" \
+"            pivot_i[lx] = vload4(0, I + k * n + j);\n" \
+"        } else {\n" \
+"            double4 ta = (double4)(0.0), ti = (double4)(0.0);\n" \
+"            if (j < n) { ta.s0 = A[k * n + j]; ti.s0 = I[k * n + j]; }\n" \
+"            if (j + 1 < n) { ta.s1 = A[k * n + j + 1]; ti.s1 = I[k * n + j + 1]; }\n" \
+"            if (j + 2 < n) { ta.s2 = A[k * n + j + 2]; ti.s2 = I[k * n + j + 2]; }\n" \
+"            pivot_a[lx] = ta;\n" \
+"            pivot_i[lx] = ti;\n" \
+"        }\n" \
+"    }\n" \
+"    if (lx == 0) factor_tile[ly] = (i < n) ? factors[i] : 0.0;\n" \
+"    barrier(CLK_LOCAL_MEM_FENCE);\n" \
+"    double f = factor_tile[ly];\n" \
+"    if (i >= n || j >= n || f == 0.0) return;\n" \
+"    __global double* a_row = A + i * n + j;\n" \
+"    __global double* i_row = I + i * n + j;\n" \
+"    if (j + 4 <= n) {\n" \
+"        vstore4(vload4(0, a_row) - f * pivot_a[lx], 0, a_row);\n" \
+"        vstore4(vload4(0, i_row) - f * pivot_i[lx], 0, i_row);\n" \
+"    } else {\n" \
+"        double4 pa = pivot_a[lx], pi = pivot_i[lx];\n" \
+"        a_row[0] -= f * pa.s0; i_row[0] -= f * pi.s0;\n" \
+"        if (j + 1 < n) { a_row[1] -= f * pa.s1; i_row[1] -= f * pi.s1; }\n" \
+"        if (j + 2 < n) { a_row[2] -= f * pa.s2; i_row[2] -= f * pi.s2; }\n" \
+"    }\n" \
+"}\n";
+
+enum {
+    K_INIT_IDENTITY, K_FIND_PIVOT, K_SWAP_ROWS, K_NORMALIZE_ROW, K_ELIMINATE_ROW,
+    K_PIVOT_REDUCE, K_SWAP_NORMALIZE, K_ELIMINATE_TILED, NUM_KERNELS
+};
+
+static const char *kernel_names[NUM_KERNELS] = {
+    "init_identity", "find_pivot", "swap_rows", "normalize_row", "eliminate_row",
+    "pivot_reduce", "swap_normalize", "eliminate_tiled"
+};
+
+// Cabeçalho dos arquivos do cache de binários
+#define KERNEL_CACHE_MAGIC "IMOPENCL-BIN-1"
+#define KERNEL_BUILD_OPTIONS ""
+
+struct invmat_opencl {
+    cl_device_id device;
+    cl_context context;
+    cl_command_queue queue;
+    cl_program program;
+    cl_kernel kernels[NUM_KERNELS];
+    char device_name[256];
+    size_t max_work_group_size;
+    size_t reduce_local;      // work-group único da redução do pivô
+    int force_copies;
+    int synchronous;
+    size_t requested_tile[2];
+    // Buffers do tamanho atual (n = 0: ainda não criados)
+    int n;
+    cl_mem a_mem, i_mem;
+    cl_mem pivot_vals_mem;    // |A[i][k]| por linha (pipeline síncrono)
+    cl_mem pivot_info_mem;    // [0] linha do pivô, [1] indicador de pivô < 1e-10
+    cl_mem pivot_value_mem;   // [0] valor do pivô, [1] A[k][k] antes da troca
+    cl_mem factors_mem;       // coluna k copiada antes da eliminação
+    double *pivot_vals;       // cópia no host de pivot_vals_mem
+    size_t tile_local[2];
+    invmat_opencl_stats_t stats;
+};
+
+static invmat_status_t cl_fail(cl_int err, const char *operation) {
+    return invmat_fail(INVMAT_ERR_BACKEND, "%s: erro OpenCL %d", operation, (int)err);
+}
+
+static size_t round_up(size_t value, size_t multiple) {
+    return ((value + multiple - 1) / multiple) * multiple;
+}
+
+// Maior potência de 2 que não excede value
+static size_t floor_pow2(size_t value) {
+    size_t p = 1;
+    while (p * 2 <= value) p *= 2;
+    return p;
+}
+
+// Hash FNV-1a de 64 bits, encadeável (h = 14695981039346656037 no início)
+static unsigned long long fnv1a_64(const void *data, size_t len, unsigned long long h) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Lê o binário de cache_path se a chave gravada for igual a key. Devolve NULL
+// (e o chamador compila a partir do fonte) se o arquivo não existir, for de
+// outro dispositivo/driver/fonte ou se o runtime rejeitar o binário
+static cl_program load_cached_program(invmat_opencl_t *cl, const char *cache_path, const char *key) {
+    FILE *file = fopen(cache_path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    char magic[sizeof(KERNEL_CACHE_MAGIC)];
+    size_t key_len, binary_size;
+    cl_program program = NULL;
+    char *stored_key = NULL;
+    unsigned char *binary = NULL;
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, KERNEL_CACHE_MAGIC, sizeof(magic)) != 0 ||
+        fread(&key_len, sizeof(key_len), 1, file) != 1 || key_len != strlen(key) ||
+        (stored_key = (char *)malloc(key_len)) == NULL ||
+        fread(stored_key, 1, key_len, file) != key_len || memcmp(stored_key, key, key_len) != 0 ||
+        fread(&binary_size, sizeof(binary_size), 1, file) != 1 || binary_size == 0 ||
+        (binary = (unsigned char *)malloc(binary_size)) == NULL ||
+        fread(binary, 1, binary_size, file) != binary_size) {
+        snprintf(cl->stats.cache_note, sizeof(cl->stats.cache_note),
+                 "arquivo do cache inválido ou de outra versão, recompilado");
+    } else {
+        cl_int binary_status, err;
+        program = clCreateProgramWithBinary(cl->context, 1, &cl->device, &binary_size,
+                                            (const unsigned char **)&binary, &binary_status, &err);
+        if (err == CL_SUCCESS && binary_status == CL_SUCCESS) {
+            err = clBuildProgram(program, 1, &cl->device, KERNEL_BUILD_OPTIONS, NULL, NULL);
+        }
+        if (err != CL_SUCCESS || binary_status != CL_SUCCESS) {
+            snprintf(cl->stats.cache_note, sizeof(cl->stats.cache_note),
+                     "binário em cache rejeitado pelo runtime (erro OpenCL %d), recompilado",
+                     (int)(err != CL_SUCCESS ? err : binary_status));
+            if (program != NULL) {
+                clReleaseProgram(program);
+            }
+            program = NULL;
+        }
+    }
+
+    free(stored_key);
+    free(binary);
+    fclose(file);
+    return program;
+}
+
+// Grava o binário do programa compilado em cache_path (via .tmp + rename, para
+// que outra execução nunca leia um arquivo pela metade). Uma falha só fica
+// registrada em cache_note
+static void save_program_binary(invmat_opencl_t *cl, const char *cache_dir, const char *cache_path,
+                                const char *key) {
+    size_t binary_size;
+    cl_int err = clGetProgramInfo(cl->program, CL_PROGRAM_BINARY_SIZES, sizeof(binary_size), &binary_size, NULL);
+    if (err != CL_SUCCESS || binary_size == 0) {
+        snprintf(cl->stats.cache_note, sizeof(cl->stats.cache_note),
+                 "o runtime não fornece o binário dos kernels, cache desativado");
+        return;
+    }
+
+    unsigned char *binary = (unsigned char *)malloc(binary_size);
+    if (binary == NULL) {
+        return;
+    }
+    err = clGetProgramInfo(cl->program, CL_PROGRAM_BINARIES, sizeof(binary), &binary, NULL);
+
+    char temp_path[1040];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache_path);
+    if (mkdir(cache_dir, 0755) != 0 && errno != EEXIST) {
+        err = CL_INVALID_VALUE;
+    }
+
+    FILE *file = (err == CL_SUCCESS) ? fopen(temp_path, "wb") : NULL;
+    size_t key_len = strlen(key);
+    if (file == NULL ||
+        fwrite(KERNEL_CACHE_MAGIC, 1, sizeof(KERNEL_CACHE_MAGIC), file) != sizeof(KERNEL_CACHE_MAGIC) ||
+        fwrite(&key_len, sizeof(key_len), 1, file) != 1 ||
+        fwrite(key, 1, key_len, file) != key_len ||
+        fwrite(&binary_size, sizeof(binary_size), 1, file) != 1 ||
+        fwrite(binary, 1, binary_size, file) != binary_size ||
+        fclose(file) != 0 || rename(temp_path, cache_path) != 0) {
+        snprintf(cl->stats.cache_note, sizeof(cl->stats.cache_note),
+                 "não foi possível gravar o cache de kernels em %s", cache_dir);
+        remove(temp_path);
+    }
+    free(binary);
+}
+
+// Cria e compila o programa dos kernels. Com cache_dir, usa o binário em cache
+// quando a chave (nome do dispositivo, versão do driver e hash do fonte e das
+// opções) coincide; com rebuild, ignora o cache e o regrava
+static invmat_status_t build_program(invmat_opencl_t *cl, const char *cache_dir, int rebuild) {
+    char key[1536], cache_path[1024];
+    cl_int err;
+    if (cache_dir != NULL && cache_dir[0] != '\0') {
+        if (strlen(cache_dir) > sizeof(cache_path) - 32) {
+            return invmat_fail(INVMAT_ERR_INVALID_ARG, "Diretório do cache de kernels longo demais");
+        }
+        char driver_version[256];
+        err = clGetDeviceInfo(cl->device, CL_DRIVER_VERSION, sizeof(driver_version), driver_version, NULL);
+        if (err != CL_SUCCESS) {
+            return cl_fail(err, "clGetDeviceInfo (cache de kernels)");
+        }
+
+        unsigned long long source_hash = 14695981039346656037ULL;
+        source_hash = fnv1a_64(kernel_source, strlen(kernel_source) + 1, source_hash);
+        source_hash = fnv1a_64(KERNEL_BUILD_OPTIONS, strlen(KERNEL_BUILD_OPTIONS), source_hash);
+        snprintf(key, sizeof(key), "%s|%s|%016llx", cl->device_name, driver_version, source_hash);
+        snprintf(cache_path, sizeof(cache_path), "%s/kernels_%016llx.bin", cache_dir,
+                 fnv1a_64(key, strlen(key), 14695981039346656037ULL));
+
+        if (!rebuild) {
+            cl->program = load_cached_program(cl, cache_path, key);
+        }
+        cl->stats.cache_hit = (cl->program != NULL);
+        if (cl->program != NULL) {
+            return INVMAT_OK;
+        }
+    }
+
+    cl->program = clCreateProgramWithSource(cl->context, 1, &kernel_source, NULL, &err);
+    if (err != CL_SUCCESS) {
+        return cl_fail(err, "clCreateProgramWithSource");
+    }
+    err = clBuildProgram(cl->program, 1, &cl->device, KERNEL_BUILD_OPTIONS, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        // Início do log de compilação na mensagem de erro
+        char log[384] = "";
+        clGetProgramBuildInfo(cl->program, cl->device, CL_PROGRAM_BUILD_LOG, sizeof(log) - 1, log, NULL);
+        return invmat_fail(INVMAT_ERR_BACKEND, "clBuildProgram: erro OpenCL %d: %s", (int)err, log);
+    }
+
+    if (cache_dir != NULL && cache_dir[0] != '\0') {
+        save_program_binary(cl, cache_dir, cache_path, key);
+    }
+    return INVMAT_OK;
+}
+
+static void release_buffers(invmat_opencl_t *cl) {
+    cl_mem *buffers[] = { &cl->a_mem, &cl->i_mem, &cl->pivot_vals_mem, &cl->pivot_info_mem,
+                          &cl->pivot_value_mem, &cl->factors_mem };
+    for (size_t b = 0; b < sizeof(buffers) / sizeof(buffers[0]); b++) {
+        if (*buffers[b] != NULL) {
+            clReleaseMemObject(*buffers[b]);
+            *buffers[b] = NULL;
+        }
+    }
+    free(cl->pivot_vals);
+    cl->pivot_vals = NULL;
+    cl->n = 0;
+}
+
+void invmat_opencl_destroy(invmat_opencl_t *cl) {
+    if (cl == NULL) {
+        return;
+    }
+    release_buffers(cl);
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        if (cl->kernels[k] != NULL) clReleaseKernel(cl->kernels[k]);
+    }
+    if (cl->program != NULL) clReleaseProgram(cl->program);
+    if (cl->queue != NULL) clReleaseCommandQueue(cl->queue);
+    if (cl->context != NULL) clReleaseContext(cl->context);
+    free(cl);
+}
+
+const char *invmat_opencl_device(const invmat_opencl_t *cl) {
+    return cl->device_name;
+}
+
+void invmat_opencl_stats(const invmat_opencl_t *cl, invmat_opencl_stats_t *stats) {
+    *stats = cl->stats;
+}
+
+// Confere o work-group pedido para eliminate_tiled contra os limites do
+// dispositivo (o automático é escolhido por n, em choose_tile_shape)
+static invmat_status_t check_requested_tile(invmat_opencl_t *cl) {
+    size_t kernel_max, item_sizes[3];
+    cl_ulong local_mem;
+    cl_kernel kernel = cl->kernels[K_ELIMINATE_TILED];
+    cl_int err = clGetKernelWorkGroupInfo(kernel, cl->device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(kernel_max), &kernel_max, NULL);
+    err |= clGetDeviceInfo(cl->device, CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof(item_sizes), item_sizes, NULL);
+    err |= clGetDeviceInfo(cl->device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(local_mem), &local_mem, NULL);
+    if (err != CL_SUCCESS) {
+        return cl_fail(err, "clGetKernelWorkGroupInfo (eliminate_tiled)");
+    }
+
+    const size_t *local = cl->requested_tile;
+    size_t local_bytes = local[0] * 8 * sizeof(double) + local[1] * sizeof(double);
+    if (local[0] * local[1] > kernel_max || local[0] > item_sizes[0] || local[1] > item_sizes[1] ||
+        local_bytes > local_mem) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG,
+                           "Work-group %zux%zu excede os limites do dispositivo (máximo %zu work-items, %zux%zu)",
+                           local[0], local[1], kernel_max, item_sizes[0], item_sizes[1]);
+    }
+    return INVMAT_OK;
+}
+
+invmat_status_t invmat_opencl_create(const invmat_opencl_options_t *options, invmat_opencl_t **out) {
+    *out = NULL;
+    if ((options->tile[0] == 0) != (options->tile[1] == 0)) {
+        return invmat_fail(INVMAT_ERR_INVALID_ARG, "Work-group da eliminação incompleto (%zux%zu)",
+                           options->tile[0], options->tile[1]);
+    }
+    invmat_opencl_t *cl = (invmat_opencl_t*)calloc(1, sizeof(*cl));
+    if (cl == NULL) {
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "Falha na alocação do estado OpenCL");
+    }
+    cl->force_copies = options->force_copies;
+    cl->synchronous = options->synchronous;
+    cl->requested_tile[0] = options->tile[0];
+    cl->requested_tile[1] = options->tile[1];
+
+    cl_platform_id platform;
+    cl_uint num_platforms, num_devices;
+    cl_int err = clGetPlatformIDs(1, &platform, &num_platforms);
+    if (err != CL_SUCCESS || num_platforms == 0) {
+        invmat_opencl_destroy(cl);
+        return invmat_fail(INVMAT_ERR_BACKEND, "Nenhuma plataforma OpenCL encontrada (erro %d)", (int)err);
+    }
+
+    // GPU se houver, senão a CPU
+    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &cl->device, &num_devices);
+    if (err == CL_DEVICE_NOT_FOUND) {
+        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &cl->device, &num_devices);
+    }
+    if (err != CL_SUCCESS) {
+        invmat_opencl_destroy(cl);
+        return cl_fail(err, "clGetDeviceIDs");
+    }
+
+    // Em dispositivos com memória unificada (CPU, GPU integrada) os buffers
+    // podem usar a memória do chamador diretamente, sem cópias
+    cl_bool host_unified;
+    cl_uint base_addr_align;
+    cl_ulong global_mem;
+    err = clGetDeviceInfo(cl->device, CL_DEVICE_NAME, sizeof(cl->device_name), cl->device_name, NULL);
+    err |= clGetDeviceInfo(cl->device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(cl->max_work_group_size),
+                           &cl->max_work_group_size, NULL);
+    err |= clGetDeviceInfo(cl->device, CL_DEVICE_HOST_UNIFIED_MEMORY, sizeof(host_unified), &host_unified, NULL);
+    err |= clGetDeviceInfo(cl->device, CL_DEVICE_MEM_BASE_ADDR_ALIGN, sizeof(base_addr_align), &base_addr_align, NULL);
+    err |= clGetDeviceInfo(cl->device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(global_mem), &global_mem, NULL);
+    if (err != CL_SUCCESS) {
+        invmat_opencl_destroy(cl);
+        return cl_fail(err, "clGetDeviceInfo");
+    }
+    cl->stats.host_unified = host_unified;
+    cl->stats.host_align = (base_addr_align / 8 > 4096) ? base_addr_align / 8 : 4096;
+    cl->stats.global_mem = global_mem;
+
+    cl->context = clCreateContext(NULL, 1, &cl->device, NULL, NULL, &err);
+    if (err != CL_SUCCESS) {
+        invmat_opencl_destroy(cl);
+        return cl_fail(err, "clCreateContext");
+    }
+    cl->queue = clCreateCommandQueue(cl->context, cl->device, 0, &err);
+    if (err != CL_SUCCESS) {
+        invmat_opencl_destroy(cl);
+        return cl_fail(err, "clCreateCommandQueue");
+    }
+
+    // Compilados uma vez por contexto, ou lidos do cache em disco
+    double build_start = omp_get_wtime();
+    invmat_status_t status = build_program(cl, options->cache_dir, options->rebuild);
+    if (status != INVMAT_OK) {
+        invmat_opencl_destroy(cl);
+        return status;
+    }
+    cl->stats.build_time = omp_get_wtime() - build_start;
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        cl->kernels[k] = clCreateKernel(cl->program, kernel_names[k], &err);
+        if (err != CL_SUCCESS) {
+            invmat_opencl_destroy(cl);
+            return cl_fail(err, kernel_names[k]);
+        }
+    }
+
+    // A redução em árvore usa um único work-group com tamanho potência de 2
+    size_t reduce_max;
+    err = clGetKernelWorkGroupInfo(cl->kernels[K_PIVOT_REDUCE], cl->device, CL_KERNEL_WORK_GROUP_SIZE,
+                                   sizeof(reduce_max), &reduce_max, NULL);
+    if (err != CL_SUCCESS) {
+        invmat_opencl_destroy(cl);
+        return cl_fail(err, "clGetKernelWorkGroupInfo (pivot_reduce)");
+    }
+    cl->reduce_local = floor_pow2(reduce_max < 256 ? reduce_max : 256);
+
+    if (cl->requested_tile[0] > 0) {
+        status = check_requested_tile(cl);
+        if (status != INVMAT_OK) {
+            invmat_opencl_destroy(cl);
+            return status;
+        }
+    }
+
+    *out = cl;
+    return INVMAT_OK;
+}
+
+// Formato do work-group de eliminate_tiled (colunas de double4 x linhas). Sem
+// pedido explícito, a largura é o múltiplo preferido do kernel (warp/wavefront
+// na GPU, largura SIMD na CPU) e a altura preenche o work-group até 64 linhas
+static invmat_status_t choose_tile_shape(invmat_opencl_t *cl, int n) {
+    size_t *local = cl->tile_local;
+    if (cl->requested_tile[0] > 0) {
+        local[0] = cl->requested_tile[0];
+        local[1] = cl->requested_tile[1];
+        return INVMAT_OK;
+    }
+
+    size_t kernel_max, multiple, item_sizes[3];
+    cl_ulong local_mem;
+    cl_kernel kernel = cl->kernels[K_ELIMINATE_TILED];
+    cl_int err = clGetKernelWorkGroupInfo(kernel, cl->device, CL_KERNEL_WORK_GROUP_SIZE, sizeof(kernel_max), &kernel_max, NULL);
+    err |= clGetKernelWorkGroupInfo(kernel, cl->device, CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE, sizeof(multiple), &multiple, NULL);
+    err |= clGetDeviceInfo(cl->device, CL_DEVICE_MAX_WORK_ITEM_SIZES, sizeof(item_sizes), item_sizes, NULL);
+    err |= clGetDeviceInfo(cl->device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(local_mem), &local_mem, NULL);
+    if (err != CL_SUCCESS) {
+        return cl_fail(err, "clGetKernelWorkGroupInfo (eliminate_tiled)");
+    }
+
+    size_t column_groups = ((size_t)n + 3) / 4;
+    local[0] = (multiple > 0) ? multiple : 1;
+    while (local[0] > 1 && (local[0] > kernel_max || local[0] > item_sizes[0] || local[0] / 2 >= column_groups)) {
+        local[0] /= 2;
+    }
+
+    local[1] = kernel_max / local[0];
+    if (local[1] > item_sizes[1]) local[1] = item_sizes[1];
+    if (local[1] > 64) local[1] = 64;
+    while (local[1] > 1 && (local[1] / 2 >= (size_t)n ||
+           local[0] * 8 * sizeof(double) + local[1] * sizeof(double) > local_mem)) {
+        local[1] /= 2;
+    }
+    if (local[1] == 0) local[1] = 1;
+    return INVMAT_OK;
+}
+
+// Buffers para matrizes n x n (refeitos quando n muda). Com memória
+// unificada, a cópia de trabalho de A fica em memória do runtime acessível
+// pelo host (CL_MEM_ALLOC_HOST_PTR)
+static invmat_status_t prepare_buffers(invmat_opencl_t *cl, int n) {
+    if (cl->n == n) {
+        return INVMAT_OK;
+    }
+    release_buffers(cl);
+
+    size_t matrix_bytes = (size_t)n * n * sizeof(double);
+    cl_mem_flags work_flags = CL_MEM_READ_WRITE | (cl->stats.host_unified ? CL_MEM_ALLOC_HOST_PTR : 0);
+    cl_int err, status = CL_SUCCESS;
+    cl->a_mem = clCreateBuffer(cl->context, work_flags, matrix_bytes, NULL, &err);
+    status |= err;
+    cl->i_mem = clCreateBuffer(cl->context, CL_MEM_READ_WRITE, matrix_bytes, NULL, &err);
+    status |= err;
+    cl->pivot_info_mem = clCreateBuffer(cl->context, CL_MEM_READ_WRITE, 2 * sizeof(int), NULL, &err);
+    status |= err;
+    cl->pivot_value_mem = clCreateBuffer(cl->context, CL_MEM_READ_WRITE, 2 * sizeof(double), NULL, &err);
+    status |= err;
+    cl->factors_mem = clCreateBuffer(cl->context, CL_MEM_READ_WRITE, n * sizeof(double), NULL, &err);
+    status |= err;
+    if (cl->synchronous) {
+        cl->pivot_vals_mem = clCreateBuffer(cl->context, CL_MEM_READ_WRITE, n * sizeof(double), NULL, &err);
+        status |= err;
+        cl->pivot_vals = (double*)malloc(n * sizeof(double));
+    }
+    if (status != CL_SUCCESS || (cl->synchronous && cl->pivot_vals == NULL)) {
+        release_buffers(cl);
+        return invmat_fail(INVMAT_ERR_NO_MEMORY, "clCreateBuffer: sem memória no dispositivo para n = %d", n);
+    }
+
+    invmat_status_t shape = choose_tile_shape(cl, n);
+    if (shape != INVMAT_OK) {
+        release_buffers(cl);
+        return shape;
+    }
+    cl->stats.tile[0] = cl->tile_local[0];
+    cl->stats.tile[1] = cl->tile_local[1];
+    cl->n = n;
+    return INVMAT_OK;
+}
+
+// Leitura bloqueante contabilizada em bytes_to_host
+static cl_int read_buffer(invmat_opencl_t *cl, cl_mem buffer, size_t bytes, void *dst) {
+    cl_int err = clEnqueueReadBuffer(cl->queue, buffer, CL_TRUE, 0, bytes, dst, 0, NULL, NULL);
+    if (err == CL_SUCCESS) {
+        cl->stats.bytes_to_host += bytes;
+    }
+    return err;
+}
+
+// Pipeline assíncrono: o argmax é feito no dispositivo (redução em árvore em
+// memória local), a linha do pivô passa de um kernel ao outro por um buffer e
+// troca + normalização são um único kernel, que também copia a coluna k para a
+// eliminação em tiles. As n colunas são enfileiradas sem nenhuma chamada
+// bloqueante; a única sincronização é a leitura do indicador de pivô
+static invmat_status_t run_async_pipeline(invmat_opencl_t *cl, cl_mem i_mem, int n, int *singular) {
+    size_t row_local = (cl->max_work_group_size < 256) ? cl->max_work_group_size : 256;
+    size_t row_global = round_up(n, row_local);
+    size_t tile_global[2] = { round_up((n + 3) / 4, cl->tile_local[0]), round_up(n, cl->tile_local[1]) };
+
+    // Argumentos fixos: somente k muda a cada coluna
+    cl_kernel reduce = cl->kernels[K_PIVOT_REDUCE];
+    cl_int err = clSetKernelArg(reduce, 0, sizeof(cl_mem), &cl->a_mem);
+    err |= clSetKernelArg(reduce, 1, sizeof(int), &n);
+    err |= clSetKernelArg(reduce, 3, sizeof(cl_mem), &cl->pivot_info_mem);
+    err |= clSetKernelArg(reduce, 4, sizeof(cl_mem), &cl->pivot_value_mem);
+    err |= clSetKernelArg(reduce, 5, cl->reduce_local * sizeof(double), NULL);
+    err |= clSetKernelArg(reduce, 6, cl->reduce_local * sizeof(int), NULL);
+    if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (pivot_reduce)");
+
+    cl_kernel swap_norm = cl->kernels[K_SWAP_NORMALIZE];
+    err = clSetKernelArg(swap_norm, 0, sizeof(cl_mem), &cl->a_mem);
+    err |= clSetKernelArg(swap_norm, 1, sizeof(cl_mem), &i_mem);
+    err |= clSetKernelArg(swap_norm, 2, sizeof(int), &n);
+    err |= clSetKernelArg(swap_norm, 4, sizeof(cl_mem), &cl->pivot_info_mem);
+    err |= clSetKernelArg(swap_norm, 5, sizeof(cl_mem), &cl->pivot_value_mem);
+    err |= clSetKernelArg(swap_norm, 6, sizeof(cl_mem), &cl->factors_mem);
+    if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (swap_normalize)");
+
+    cl_kernel eliminate = cl->kernels[K_ELIMINATE_TILED];
+    err = clSetKernelArg(eliminate, 0, sizeof(cl_mem), &cl->a_mem);
+    err |= clSetKernelArg(eliminate, 1, sizeof(cl_mem), &i_mem);
+    err |= clSetKernelArg(eliminate, 2, sizeof(int), &n);
+    err |= clSetKernelArg(eliminate, 4, sizeof(cl_mem), &cl->factors_mem);
+    err |= clSetKernelArg(eliminate, 5, cl->tile_local[0] * 4 * sizeof(double), NULL);
+    err |= clSetKernelArg(eliminate, 6, cl->tile_local[0] * 4 * sizeof(double), NULL);
+    err |= clSetKernelArg(eliminate, 7, cl->tile_local[1] * sizeof(double), NULL);
+    if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (eliminate_tiled)");
+
+    double start = omp_get_wtime();
+    for (int k = 0; k < n; k++) {
+        err = clSetKernelArg(reduce, 2, sizeof(int), &k);
+        err |= clSetKernelArg(swap_norm, 3, sizeof(int), &k);
+        err |= clSetKernelArg(eliminate, 3, sizeof(int), &k);
+        if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (k)");
+
+        err = clEnqueueNDRangeKernel(cl->queue, reduce, 1, NULL, &cl->reduce_local, &cl->reduce_local, 0, NULL, NULL);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueNDRangeKernel (pivot_reduce)");
+        err = clEnqueueNDRangeKernel(cl->queue, swap_norm, 1, NULL, &row_global, &row_local, 0, NULL, NULL);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueNDRangeKernel (swap_normalize)");
+        err = clEnqueueNDRangeKernel(cl->queue, eliminate, 2, NULL, tile_global, cl->tile_local, 0, NULL, NULL);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueNDRangeKernel (eliminate_tiled)");
+    }
+    clFlush(cl->queue);
+    cl->stats.enqueue_time = omp_get_wtime() - start;
+
+    // Única sincronização: o indicador de pivô pequeno, lido ao final da fila
+    int pivot_info[2];
+    err = read_buffer(cl, cl->pivot_info_mem, sizeof(pivot_info), pivot_info);
+    if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueReadBuffer (pivot_info)");
+    cl->stats.pipeline_time = omp_get_wtime() - start;
+    cl->stats.host_syncs = 1;
+    *singular = pivot_info[1];
+    return INVMAT_OK;
+}
+
+// Pipeline original: argmax do pivô no host e clFinish após cada kernel
+// (até 6 idas e voltas ao host por coluna). Mantido para comparação
+static invmat_status_t run_sync_pipeline(invmat_opencl_t *cl, cl_mem i_mem, int n, int *singular) {
+    size_t row_local = (cl->max_work_group_size < 256) ? cl->max_work_group_size : 256;
+    size_t row_global = round_up(n, row_local);
+    size_t local_2d[2] = { 16, 16 };
+    if (n < 16) {
+        local_2d[0] = local_2d[1] = 1;
+    }
+    size_t global_2d[2] = { round_up(n, local_2d[0]), round_up(n, local_2d[1]) };
+    int syncs = 0;
+    *singular = 0;
+
+    cl_kernel find = cl->kernels[K_FIND_PIVOT];
+    cl_kernel swap = cl->kernels[K_SWAP_ROWS];
+    cl_kernel normalize = cl->kernels[K_NORMALIZE_ROW];
+    cl_kernel eliminate = cl->kernels[K_ELIMINATE_ROW];
+    cl_int err = clSetKernelArg(find, 0, sizeof(cl_mem), &cl->a_mem);
+    err |= clSetKernelArg(find, 1, sizeof(int), &n);
+    err |= clSetKernelArg(find, 3, sizeof(cl_mem), &cl->pivot_vals_mem);
+    err |= clSetKernelArg(swap, 1, sizeof(int), &n);
+    err |= clSetKernelArg(normalize, 0, sizeof(cl_mem), &cl->a_mem);
+    err |= clSetKernelArg(normalize, 1, sizeof(cl_mem), &i_mem);
+    err |= clSetKernelArg(normalize, 2, sizeof(int), &n);
+    err |= clSetKernelArg(eliminate, 0, sizeof(cl_mem), &cl->a_mem);
+    err |= clSetKernelArg(eliminate, 1, sizeof(cl_mem), &i_mem);
+    err |= clSetKernelArg(eliminate, 2, sizeof(int), &n);
+    if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (pipeline síncrono)");
+
+    double start = omp_get_wtime();
+    for (int k = 0; k < n; k++) {
+        // 1. Encontrar pivô: |A[i][k]| lidos pelo host
+        err = clSetKernelArg(find, 2, sizeof(int), &k);
+        if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (find_pivot)");
+        size_t global_find = round_up(n - k, row_local);
+        err = clEnqueueNDRangeKernel(cl->queue, find, 1, NULL, &global_find, &row_local, 0, NULL, NULL);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueNDRangeKernel (find_pivot)");
+        clFinish(cl->queue);
+        err = read_buffer(cl, cl->pivot_vals_mem, (n - k) * sizeof(double), cl->pivot_vals);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueReadBuffer (pivot_vals)");
+        syncs += 2;
+
+        int max_idx = 0;
+        double max_val = cl->pivot_vals[0];
+        for (int i = 1; i < (n - k); i++) {
+            if (cl->pivot_vals[i] > max_val) {
+                max_val = cl->pivot_vals[i];
+                max_idx = i;
+            }
+        }
+        max_idx += k;
+        if (max_val < 1e-10) {
+            *singular = 1;
+        }
+
+        // 2. Trocar linhas se necessário
+        if (max_idx != k) {
+            cl_mem matrices[2] = { cl->a_mem, i_mem };
+            for (int m = 0; m < 2; m++) {
+                err = clSetKernelArg(swap, 0, sizeof(cl_mem), &matrices[m]);
+                err |= clSetKernelArg(swap, 2, sizeof(int), &k);
+                err |= clSetKernelArg(swap, 3, sizeof(int), &max_idx);
+                if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (swap_rows)");
+                err = clEnqueueNDRangeKernel(cl->queue, swap, 1, NULL, &row_global, &row_local, 0, NULL, NULL);
+                if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueNDRangeKernel (swap_rows)");
+                clFinish(cl->queue);
+            }
+            syncs += 2;
+        }
+
+        // 3. Normalizar linha do pivô
+        err = clSetKernelArg(normalize, 3, sizeof(int), &k);
+        if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (normalize_row)");
+        err = clEnqueueNDRangeKernel(cl->queue, normalize, 1, NULL, &row_global, &row_local, 0, NULL, NULL);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueNDRangeKernel (normalize_row)");
+        clFinish(cl->queue);
+
+        // 4. Eliminação gaussiana
+        err = clSetKernelArg(eliminate, 3, sizeof(int), &k);
+        if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (eliminate_row)");
+        err = clEnqueueNDRangeKernel(cl->queue, eliminate, 2, NULL, global_2d, local_2d, 0, NULL, NULL);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueNDRangeKernel (eliminate_row)");
+        clFinish(cl->queue);
+        syncs += 2;
+    }
+
+    cl->stats.pipeline_time = omp_get_wtime() - start;
+    cl->stats.enqueue_time = cl->stats.pipeline_time;
+    cl->stats.host_syncs = syncs;
+    return INVMAT_OK;
+}
+
+// Inversão com A já em a_mem e a inversa em i_mem (um buffer sobre Ainv, no
+// zero-copy): identidade, pipeline e indicador de singularidade
+static invmat_status_t run_inversion(invmat_opencl_t *cl, cl_mem i_mem, int n) {
+    size_t local_2d[2] = { 16, 16 };
+    if (n < 16) {
+        local_2d[0] = local_2d[1] = 1;
+    }
+    size_t global_2d[2] = { round_up(n, local_2d[0]), round_up(n, local_2d[1]) };
+    int zero = 0;
+
+    cl_int err = clEnqueueFillBuffer(cl->queue, cl->pivot_info_mem, &zero, sizeof(zero), 0, 2 * sizeof(int), 0, NULL, NULL);
+    if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueFillBuffer (pivot_info)");
+
+    cl_kernel identity = cl->kernels[K_INIT_IDENTITY];
+    err = clSetKernelArg(identity, 0, sizeof(cl_mem), &i_mem);
+    err |= clSetKernelArg(identity, 1, sizeof(int), &n);
+    if (err != CL_SUCCESS) return cl_fail(err, "clSetKernelArg (init_identity)");
+    err = clEnqueueNDRangeKernel(cl->queue, identity, 2, NULL, global_2d, local_2d, 0, NULL, NULL);
+    if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueNDRangeKernel (init_identity)");
+
+    // A medição do pipeline começa com a fila vazia
+    clFinish(cl->queue);
+
+    int singular = 0;
+    invmat_status_t status = cl->synchronous ? run_sync_pipeline(cl, i_mem, n, &singular)
+                                             : run_async_pipeline(cl, i_mem, n, &singular);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+    if (singular) {
+        return invmat_fail(INVMAT_ERR_SINGULAR, "A matriz parece ser singular ou mal condicionada");
+    }
+    return INVMAT_OK;
+}
+
+invmat_status_t invmat_opencl_invert(invmat_opencl_t *cl, const double *A, double *Ainv, int n) {
+    invmat_status_t status = prepare_buffers(cl, n);
+    if (status != INVMAT_OK) {
+        return status;
+    }
+
+    size_t matrix_bytes = (size_t)n * n * sizeof(double);
+    size_t align = cl->stats.host_align;
+    cl_int err;
+
+    // Zero-copy com memória unificada e A e Ainv alinhados: A é usada por um
+    // buffer CL_MEM_USE_HOST_PTR e copiada no próprio dispositivo, e a
+    // eliminação escreve direto em Ainv. Senão, cópias explícitas
+    cl->stats.zero_copy = cl->stats.host_unified && !cl->force_copies &&
+                          (size_t)A % align == 0 && (size_t)Ainv % align == 0;
+    if (!cl->stats.zero_copy) {
+        // Bloqueante: o chamador pode liberar A se algo falhar depois
+        err = clEnqueueWriteBuffer(cl->queue, cl->a_mem, CL_TRUE, 0, matrix_bytes, A, 0, NULL, NULL);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueWriteBuffer (A)");
+        cl->stats.bytes_to_device += matrix_bytes;
+
+        status = run_inversion(cl, cl->i_mem, n);
+        if (status != INVMAT_OK) {
+            return status;
+        }
+        err = read_buffer(cl, cl->i_mem, matrix_bytes, Ainv);
+        if (err != CL_SUCCESS) return cl_fail(err, "clEnqueueReadBuffer (I)");
+        return INVMAT_OK;
+    }
+
+    cl_mem a_host = clCreateBuffer(cl->context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, matrix_bytes,
+                                   (void *)A, &err);
+    if (err != CL_SUCCESS) return cl_fail(err, "clCreateBuffer (A do chamador)");
+    cl_mem i_host = clCreateBuffer(cl->context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, matrix_bytes,
+                                   Ainv, &err);
+    if (err != CL_SUCCESS) {
+        clReleaseMemObject(a_host);
+        return cl_fail(err, "clCreateBuffer (Ainv do chamador)");
+    }
+
+    err = clEnqueueCopyBuffer(cl->queue, a_host, cl->a_mem, 0, 0, matrix_bytes, 0, NULL, NULL);
+    status = (err == CL_SUCCESS) ? run_inversion(cl, i_host, n) : cl_fail(err, "clEnqueueCopyBuffer (A)");
+
+    // O mapeamento devolve a própria alocação do chamador; se o runtime
+    // devolver outro endereço, houve cópia e ela é contabilizada
+    if (status == INVMAT_OK) {
+        double *mapped = (double *)clEnqueueMapBuffer(cl->queue, i_host, CL_TRUE, CL_MAP_READ, 0, matrix_bytes,
+                                                      0, NULL, NULL, &err);
+        if (err != CL_SUCCESS) {
+            status = cl_fail(err, "clEnqueueMapBuffer (Ainv)");
+        } else {
+            if (mapped != Ainv) {
+                memcpy(Ainv, mapped, matrix_bytes);
+                cl->stats.bytes_to_host += matrix_bytes;
+            }
+            clEnqueueUnmapMemObject(cl->queue, i_host, mapped, 0, NULL, NULL);
+        }
+    }
+    clFinish(cl->queue);
+    clReleaseMemObject(i_host);
+    clReleaseMemObject(a_host);
+    return status;
+}
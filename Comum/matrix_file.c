@@ -0,0 +1,339 @@
+/*
+ * matrix_file.c - Leitura e escrita das matrizes via mmap. Os dados ficam a
+ * partir de MATRIX_FILE_DATA_OFFSET (alinhado à página), então o ponteiro do
+ * mapeamento é usado diretamente como a matriz, sem fread/fwrite para um
+ * buffer intermediário
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "matrix_file.h"
+
+#define FNV_PRIME 0x100000001b3ULL
+
+// Maior n cujos índices i*n + j ainda cabem em int nas rotinas de inversão
+#define MATRIX_MAX_N 46340
+
+uint64_t matrix_checksum_update(uint64_t hash, const void *data, size_t bytes) {
+    const unsigned char *p = (const unsigned char *)data;
+    size_t words = bytes / 8;
+
+    // Uma palavra de 8 bytes por passo (os dados estão alinhados)
+    for (size_t i = 0; i < words; i++) {
+        uint64_t w;
+        memcpy(&w, p + i*8, 8);
+        hash ^= w;
+        hash *= FNV_PRIME;
+    }
+    for (size_t i = words*8; i < bytes; i++) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+uint64_t matrix_checksum(const void *data, size_t bytes) {
+    return matrix_checksum_update(MATRIX_CHECKSUM_INIT, data, bytes);
+}
+
+static void map_reset(matrix_map_t *map) {
+    memset(map, 0, sizeof(*map));
+    map->fd = -1;
+}
+
+// Preenche a mensagem de erro das variantes matrix_file_try_*
+static void set_error(char *error, size_t error_size, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+static void set_error(char *error, size_t error_size, const char *format, ...) {
+    if (error == NULL || error_size == 0) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    vsnprintf(error, error_size, format, args);
+    va_end(args);
+}
+
+int matrix_file_try_open(const char *filename, int expected_n, matrix_map_t *map,
+                         char *error, size_t error_size) {
+    map_reset(map);
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        set_error(error, error_size, "Erro ao abrir o arquivo %s para leitura", filename);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        set_error(error, error_size, "Erro ao obter o tamanho do arquivo %s", filename);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+
+    // Lê o cabeçalho (se houver) antes de mapear
+    matrix_file_header_t header;
+    int has_header = 0;
+    if (size >= MATRIX_FILE_DATA_OFFSET &&
+        pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+        memcmp(header.magic, MATRIX_FILE_MAGIC, 8) == 0) {
+        has_header = 1;
+    }
+
+    int n, elem_type, layout;
+    size_t offset;
+    if (has_header) {
+        if (header.version != MATRIX_FILE_VERSION) {
+            set_error(error, error_size, "Erro: %s usa a versão %u do formato (suportada: %d)",
+                      filename, header.version, MATRIX_FILE_VERSION);
+            close(fd);
+            return -1;
+        }
+        if (header.elem_type != MATRIX_ELEM_F64 && header.elem_type != MATRIX_ELEM_F32) {
+            set_error(error, error_size, "Erro: tipo de elemento desconhecido (%u) em %s", header.elem_type, filename);
+            close(fd);
+            return -1;
+        }
+        if (header.layout != MATRIX_ROW_MAJOR && header.layout != MATRIX_COL_MAJOR) {
+            set_error(error, error_size, "Erro: ordem dos elementos desconhecida (%u) em %s", header.layout, filename);
+            close(fd);
+            return -1;
+        }
+        if (header.n == 0 || header.n > MATRIX_MAX_N || header.data_offset != MATRIX_FILE_DATA_OFFSET) {
+            set_error(error, error_size, "Erro: cabeçalho inválido em %s", filename);
+            close(fd);
+            return -1;
+        }
+        n = (int)header.n;
+        elem_type = (int)header.elem_type;
+        layout = (int)header.layout;
+        offset = header.data_offset;
+
+        size_t elem_size = (elem_type == MATRIX_ELEM_F64) ? sizeof(double) : sizeof(float);
+        if (size < offset + (size_t)n*n*elem_size) {
+            set_error(error, error_size, "Erro: %s está truncado (esperados %zu bytes de dados)",
+                      filename, (size_t)n*n*elem_size);
+            close(fd);
+            return -1;
+        }
+    } else {
+        // Formato antigo: n*n doubles crus, n conhecido apenas pelo chamador
+        if (expected_n <= 0 || size != (size_t)expected_n*expected_n*sizeof(double)) {
+            set_error(error, error_size, "Erro: %s não tem cabeçalho e o tamanho não corresponde a uma matriz %dx%d",
+                      filename, expected_n, expected_n);
+            close(fd);
+            return -1;
+        }
+        n = expected_n;
+        elem_type = MATRIX_ELEM_F64;
+        layout = MATRIX_ROW_MAJOR;
+        offset = 0;
+    }
+
+    size_t elem_size = (elem_type == MATRIX_ELEM_F64) ? sizeof(double) : sizeof(float);
+    size_t data_bytes = (size_t)n*n*elem_size;
+    size_t length = offset + data_bytes;
+
+    // Privado: alterações feitas pelas rotinas (ex.: in-place) não vão ao arquivo
+    void *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        set_error(error, error_size, "Erro ao mapear o arquivo %s", filename);
+        close(fd);
+        return -1;
+    }
+    void *data = (char *)base + offset;
+
+    // A verificação do checksum percorre o arquivo uma vez, em ordem
+    madvise(base, length, MADV_SEQUENTIAL);
+    if (has_header && matrix_checksum(data, data_bytes) != header.checksum) {
+        set_error(error, error_size, "Erro: checksum não confere em %s (arquivo corrompido?)", filename);
+        munmap(base, length);
+        close(fd);
+        return -1;
+    }
+    // Depois disso o acesso das rotinas de inversão é por linhas e colunas
+    madvise(base, length, MADV_NORMAL);
+
+    map->n = n;
+    map->layout = layout;
+    map->legacy = !has_header;
+    map->fd = fd;
+    map->base = base;
+    map->length = length;
+
+    if (elem_type == MATRIX_ELEM_F64) {
+        map->data = (double *)data;
+    } else {
+        // float32: as rotinas trabalham em double, então aqui a cópia é inevitável
+        double *converted = (double*)malloc((size_t)n*n*sizeof(double));
+        if (converted == NULL) {
+            set_error(error, error_size, "Erro: Falha na alocação de memória");
+            munmap(base, length);
+            close(fd);
+            map_reset(map);
+            return -1;
+        }
+        const float *src = (const float *)data;
+        for (size_t i = 0; i < (size_t)n*n; i++) {
+            converted[i] = src[i];
+        }
+        map->converted = converted;
+        map->data = converted;
+    }
+
+    return 0;
+}
+
+double *matrix_file_open(const char *filename, int expected_n, matrix_map_t *map) {
+    char error[512];
+    if (matrix_file_try_open(filename, expected_n, map, error, sizeof(error)) != 0) {
+        fprintf(stderr, "%s\n", error);
+        exit(EXIT_FAILURE);
+    }
+    return map->data;
+}
+
+int matrix_file_try_create(const char *filename, int n, int layout, matrix_map_t *map,
+                           char *error, size_t error_size) {
+    map_reset(map);
+
+    if (n <= 0 || n > MATRIX_MAX_N) {
+        set_error(error, error_size, "Erro: tamanho de matriz inválido para %s (%d)", filename, n);
+        return -1;
+    }
+
+    char *temp_path = (char*)malloc(strlen(filename) + 5);
+    char *path = strdup(filename);
+    if (temp_path == NULL || path == NULL) {
+        set_error(error, error_size, "Erro: Falha na alocação de memória");
+        free(temp_path);
+        free(path);
+        return -1;
+    }
+    sprintf(temp_path, "%s.tmp", filename);
+
+    int fd = open(temp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        set_error(error, error_size, "Erro ao abrir o arquivo %s para escrita", temp_path);
+        free(temp_path);
+        free(path);
+        return -1;
+    }
+
+    size_t length = MATRIX_FILE_DATA_OFFSET + (size_t)n*n*sizeof(double);
+
+    // Reserva os blocos agora: sem isso, falta de espaço em disco apareceria
+    // como SIGBUS no meio da inversão. Só sistemas de arquivos sem suporte à
+    // reserva (EOPNOTSUPP/EINVAL) caem no ftruncate esparso; qualquer outro
+    // erro, como ENOSPC, é reportado
+    int err = posix_fallocate(fd, 0, (off_t)length);
+    if (err == EOPNOTSUPP || err == EINVAL) {
+        err = (ftruncate(fd, (off_t)length) == 0) ? 0 : errno;
+    }
+    void *base = MAP_FAILED;
+    if (err != 0) {
+        set_error(error, error_size, "Erro ao reservar %zu bytes para %s: %s", length, filename, strerror(err));
+    } else {
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            set_error(error, error_size, "Erro ao mapear o arquivo %s", filename);
+        }
+    }
+    if (base == MAP_FAILED) {
+        close(fd);
+        unlink(temp_path);
+        free(temp_path);
+        free(path);
+        return -1;
+    }
+
+    // O checksum definitivo é gravado em matrix_file_close
+    matrix_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MATRIX_FILE_MAGIC, 8);
+    header.version = MATRIX_FILE_VERSION;
+    header.elem_type = MATRIX_ELEM_F64;
+    header.layout = (uint32_t)layout;
+    header.data_offset = MATRIX_FILE_DATA_OFFSET;
+    header.n = (uint64_t)n;
+    memcpy(base, &header, sizeof(header));
+
+    map->data = (double *)((char *)base + MATRIX_FILE_DATA_OFFSET);
+    map->n = n;
+    map->layout = layout;
+    map->writable = 1;
+    map->fd = fd;
+    map->base = base;
+    map->length = length;
+    map->path = path;
+    map->temp_path = temp_path;
+
+    return 0;
+}
+
+double *matrix_file_create(const char *filename, int n, int layout, matrix_map_t *map) {
+    char error[512];
+    if (matrix_file_try_create(filename, n, layout, map, error, sizeof(error)) != 0) {
+        fprintf(stderr, "%s\n", error);
+        exit(EXIT_FAILURE);
+    }
+    return map->data;
+}
+
+int matrix_file_try_close(matrix_map_t *map, char *error, size_t error_size) {
+    if (map->base == NULL) {
+        return 0;
+    }
+
+    if (map->writable) {
+        // Passada final sequencial para o checksum; a escrita das páginas no
+        // disco fica a cargo do kernel (sem msync bloqueante)
+        madvise(map->base, map->length, MADV_SEQUENTIAL);
+        matrix_file_header_t *header = (matrix_file_header_t *)map->base;
+        header->checksum = matrix_checksum(map->data, (size_t)map->n*map->n*sizeof(double));
+    }
+
+    munmap(map->base, map->length);
+    close(map->fd);
+    int status = 0;
+    if (map->writable && rename(map->temp_path, map->path) != 0) {
+        set_error(error, error_size, "Erro ao renomear %s para %s", map->temp_path, map->path);
+        status = -1;
+    }
+    free(map->converted);
+    free(map->path);
+    free(map->temp_path);
+    map_reset(map);
+    return status;
+}
+
+void matrix_file_close(matrix_map_t *map) {
+    char error[512];
+    if (matrix_file_try_close(map, error, sizeof(error)) != 0) {
+        fprintf(stderr, "%s\n", error);
+        exit(EXIT_FAILURE);
+    }
+}
+
+const char *matrix_file_format_name(const matrix_map_t *map) {
+    if (map->legacy) {
+        return "legado (sem cabeçalho)";
+    }
+    if (map->converted != NULL) {
+        return map->layout == MATRIX_ROW_MAJOR ? "v1, float32, por linhas" : "v1, float32, por colunas";
+    }
+    return map->layout == MATRIX_ROW_MAJOR ? "v1, float64, por linhas" : "v1, float64, por colunas";
+}
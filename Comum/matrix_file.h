@@ -0,0 +1,101 @@
+/*
+ * matrix_file.h - Formato binário autodescritivo das matrizes (.bin) e acesso
+ * via mmap, sem cópia para buffers alocados com malloc
+ *
+ * Layout do arquivo (versão 1):
+ *   [0, 4096)  cabeçalho matrix_file_header_t, completado com zeros
+ *   [4096, ..) n*n elementos, na ordem indicada por layout
+ *
+ * O deslocamento de 4096 bytes deixa os dados alinhados à página, de modo que
+ * o ponteiro mapeado pode ser entregue diretamente às rotinas de inversão.
+ * Arquivos antigos (n*n doubles crus, sem cabeçalho) continuam sendo aceitos
+ * quando o tamanho confere com o n esperado
+ */
+
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MATRIX_FILE_MAGIC "INVMAT\r\n"
+#define MATRIX_FILE_VERSION 1
+#define MATRIX_FILE_DATA_OFFSET 4096
+
+// Tipo dos elementos gravados no arquivo
+#define MATRIX_ELEM_F64 1
+#define MATRIX_ELEM_F32 2
+
+// Ordem dos elementos no arquivo
+#define MATRIX_ROW_MAJOR 0
+#define MATRIX_COL_MAJOR 1
+
+typedef struct {
+    char magic[8];          // MATRIX_FILE_MAGIC
+    uint32_t version;       // MATRIX_FILE_VERSION
+    uint32_t elem_type;     // MATRIX_ELEM_*
+    uint32_t layout;        // MATRIX_ROW_MAJOR ou MATRIX_COL_MAJOR
+    uint32_t data_offset;   // início dos dados (MATRIX_FILE_DATA_OFFSET)
+    uint64_t n;             // dimensão da matriz (n x n)
+    uint64_t checksum;      // FNV-1a de 64 bits sobre os bytes dos dados
+} matrix_file_header_t;
+
+// Matriz mapeada em memória
+typedef struct {
+    double *data;           // n*n doubles, na ordem de layout
+    int n;
+    int layout;             // MATRIX_ROW_MAJOR ou MATRIX_COL_MAJOR
+    int legacy;             // 1 se o arquivo não tem cabeçalho
+    int writable;           // 1 se foi criado por matrix_file_create
+    int fd;
+    void *base;             // início do mapeamento (cabeçalho incluso)
+    size_t length;          // tamanho do mapeamento
+    double *converted;      // buffer próprio quando o arquivo é float32
+    char *path;             // nome final de um arquivo criado
+    char *temp_path;        // nome usado até matrix_file_close
+} matrix_map_t;
+
+// Valor inicial do checksum (base do FNV-1a de 64 bits)
+#define MATRIX_CHECKSUM_INIT 0xcbf29ce484222325ULL
+
+// Checksum dos dados (FNV-1a de 64 bits sobre palavras de 8 bytes)
+uint64_t matrix_checksum(const void *data, size_t bytes);
+
+// Continua um checksum a partir de hash, para dados lidos em partes (ex.: um
+// trecho por processo MPI, em ordem). Todas as partes, exceto a última,
+// devem ter tamanho múltiplo de 8 bytes
+uint64_t matrix_checksum_update(uint64_t hash, const void *data, size_t bytes);
+
+// Mapeia a matriz de filename e retorna o ponteiro para os dados. O
+// mapeamento é privado (cópia na escrita): as rotinas podem alterar a matriz
+// sem modificar o arquivo. expected_n só é usado para reconhecer arquivos
+// antigos sem cabeçalho (0 aceita apenas o formato novo). O checksum é
+// verificado numa passada sequencial (MADV_SEQUENTIAL). Em caso de erro, a
+// mensagem é impressa e o programa termina
+double *matrix_file_open(const char *filename, int expected_n, matrix_map_t *map);
+
+// Cria filename com espaço para uma matriz n x n em float64, mapeado como
+// compartilhado: o que for escrito em map->data vai direto para o arquivo,
+// sem a cópia de um fwrite no final. Os dados são escritos em filename.tmp,
+// renomeado em matrix_file_close, então um arquivo com o mesmo nome que
+// esteja aberto (ex.: a inversa anterior usada como ponto de partida) segue
+// válido e nunca fica um arquivo pela metade
+double *matrix_file_create(const char *filename, int n, int layout, matrix_map_t *map);
+
+// Desfaz o mapeamento. Para arquivos criados, grava antes o checksum dos dados
+// no cabeçalho e dá ao arquivo o nome definitivo
+void matrix_file_close(matrix_map_t *map);
+
+// Variantes que não terminam o programa (para a biblioteca, Comum/invmat.h):
+// retornam 0 ou -1, com a mesma mensagem das versões acima em error, e não
+// deixam descritores, mapeamentos nem o arquivo .tmp para trás em caso de erro
+int matrix_file_try_open(const char *filename, int expected_n, matrix_map_t *map,
+                         char *error, size_t error_size);
+int matrix_file_try_create(const char *filename, int n, int layout, matrix_map_t *map,
+                           char *error, size_t error_size);
+int matrix_file_try_close(matrix_map_t *map, char *error, size_t error_size);
+
+// Nome legível do formato de um arquivo aberto (para os relatórios)
+const char *matrix_file_format_name(const matrix_map_t *map);
+
+#endif
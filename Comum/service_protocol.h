@@ -0,0 +1,61 @@
+/*
+ * service_protocol.h - Protocolo do serviço de inversão (im_server/im_client)
+ * sobre um socket Unix do tipo stream
+ *
+ * Requisição: uma matriz no formato de Comum/matrix_file.h, transmitida como
+ * o arquivo: matrix_file_header_t seguido dos dados a partir de data_offset.
+ * data_offset pode ser sizeof(matrix_file_header_t) (sem os zeros de
+ * preenchimento do arquivo) ou MATRIX_FILE_DATA_OFFSET (o conteúdo de um .bin
+ * enviado tal como está). O checksum do cabeçalho é conferido.
+ *
+ * Resposta: service_response_t e, se status == SERVICE_OK, a inversa em
+ * float64 na mesma ordem da requisição, também como matrix_file_header_t
+ * (data_offset = sizeof(matrix_file_header_t)) seguido dos dados.
+ *
+ * Uma conexão pode enviar várias requisições; as respostas voltam na ordem
+ * das requisições. Depois de um SERVICE_BAD_HEADER o servidor fecha a
+ * conexão (não dá para achar o início da próxima matriz)
+ */
+
+#ifndef SERVICE_PROTOCOL_H
+#define SERVICE_PROTOCOL_H
+
+#include <stdint.h>
+
+#include "matrix_file.h"
+
+#define SERVICE_DEFAULT_SOCKET "/tmp/im_server.sock"
+#define SERVICE_RESPONSE_MAGIC "INVRES\r\n"
+
+// Maior matriz aceita (limita a memória que um cliente pode pedir)
+#define SERVICE_MAX_N 8192
+
+// Resultado de uma requisição
+#define SERVICE_OK 0
+#define SERVICE_SINGULAR 1        // pivô abaixo de 1e-10
+#define SERVICE_BAD_HEADER 2      // cabeçalho inválido ou n acima de SERVICE_MAX_N
+#define SERVICE_BAD_CHECKSUM 3    // dados não conferem com o checksum
+#define SERVICE_NO_MEMORY 4
+
+typedef struct {
+    char magic[8];              // SERVICE_RESPONSE_MAGIC
+    int32_t status;             // SERVICE_*
+    uint32_t batch_size;        // requisições invertidas juntas com esta
+    double queue_seconds;       // da chegada completa ao início da inversão
+    double compute_seconds;     // inversão (do grupo intercalado inteiro, se em lote)
+    double server_seconds;      // da chegada completa ao início da resposta
+} service_response_t;
+
+// Nome legível de um status (para as mensagens)
+static inline const char *service_status_name(int status) {
+    switch (status) {
+        case SERVICE_OK: return "ok";
+        case SERVICE_SINGULAR: return "matriz singular ou mal condicionada";
+        case SERVICE_BAD_HEADER: return "cabeçalho inválido";
+        case SERVICE_BAD_CHECKSUM: return "checksum não confere";
+        case SERVICE_NO_MEMORY: return "falha na alocação de memória";
+        default: return "status desconhecido";
+    }
+}
+
+#endif
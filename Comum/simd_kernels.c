@@ -0,0 +1,346 @@
+/*
+ * simd_kernels.c - Implementações escalar, SSE2, AVX2+FMA e AVX-512 dos
+ * kernels do Gauss-Jordan. Cada versão é compilada com o atributo target
+ * correspondente, de modo que um único binário roda em qualquer x86-64 e
+ * usa o conjunto mais largo disponível na máquina
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "simd_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// Versões escalares (referência e fallback para outras arquiteturas)
+// ---------------------------------------------------------------------------
+
+static void axpy_scalar(double *y, const double *x, double a, int len) {
+    for (int j = 0; j < len; j++) {
+        y[j] -= a * x[j];
+    }
+}
+
+static void scale_scalar(double *x, double d, int len) {
+    for (int j = 0; j < len; j++) {
+        x[j] /= d;
+    }
+}
+
+static int abs_argmax_scalar(const double *col, int stride, int start, int end, double *max_value) {
+    int best = start;
+    double best_value = fabs(col[(size_t)start*stride]);
+
+    for (int i = start + 1; i < end; i++) {
+        double abs_value = fabs(col[(size_t)i*stride]);
+        if (abs_value > best_value) {
+            best_value = abs_value;
+            best = i;
+        }
+    }
+
+    *max_value = best_value;
+    return best;
+}
+
+// Depois que o máximo é conhecido, localiza a primeira linha que o atinge,
+// preservando a mesma escolha de pivô da versão escalar
+static int first_index_of(const double *col, int stride, int start, int end, double value) {
+    for (int i = start; i < end; i++) {
+        if (fabs(col[(size_t)i*stride]) == value) {
+            return i;
+        }
+    }
+    return start;
+}
+
+#ifdef SIMD_X86
+
+// ---------------------------------------------------------------------------
+// SSE2 (2 doubles por registrador, sem FMA)
+// ---------------------------------------------------------------------------
+
+__attribute__((target("sse2")))
+static void axpy_sse2(double *y, const double *x, double a, int len) {
+    __m128d va = _mm_set1_pd(a);
+    int j = 0;
+    for (; j + 2 <= len; j += 2) {
+        __m128d vy = _mm_loadu_pd(y + j);
+        __m128d vx = _mm_loadu_pd(x + j);
+        _mm_storeu_pd(y + j, _mm_sub_pd(vy, _mm_mul_pd(va, vx)));
+    }
+    for (; j < len; j++) {
+        y[j] -= a * x[j];
+    }
+}
+
+__attribute__((target("sse2")))
+static void scale_sse2(double *x, double d, int len) {
+    __m128d vd = _mm_set1_pd(d);
+    int j = 0;
+    for (; j + 2 <= len; j += 2) {
+        _mm_storeu_pd(x + j, _mm_div_pd(_mm_loadu_pd(x + j), vd));
+    }
+    for (; j < len; j++) {
+        x[j] /= d;
+    }
+}
+
+__attribute__((target("sse2")))
+static int abs_argmax_sse2(const double *col, int stride, int start, int end, double *max_value) {
+    const __m128d sign_mask = _mm_set1_pd(-0.0);
+    __m128d vmax = _mm_set1_pd(fabs(col[(size_t)start*stride]));
+    int i = start + 1;
+    for (; i + 2 <= end; i += 2) {
+        __m128d v = _mm_set_pd(col[(size_t)(i + 1)*stride], col[(size_t)i*stride]);
+        vmax = _mm_max_pd(vmax, _mm_andnot_pd(sign_mask, v));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, vmax);
+    double best_value = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    for (; i < end; i++) {
+        double abs_value = fabs(col[(size_t)i*stride]);
+        if (abs_value > best_value) {
+            best_value = abs_value;
+        }
+    }
+
+    *max_value = best_value;
+    return first_index_of(col, stride, start, end, best_value);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 + FMA (4 doubles por registrador, leitura da coluna via gather)
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2,fma")))
+static void axpy_avx2(double *y, const double *x, double a, int len) {
+    __m256d va = _mm256_set1_pd(a);
+    int j = 0;
+    for (; j + 8 <= len; j += 8) {
+        __m256d y0 = _mm256_loadu_pd(y + j);
+        __m256d y1 = _mm256_loadu_pd(y + j + 4);
+        y0 = _mm256_fnmadd_pd(va, _mm256_loadu_pd(x + j), y0);
+        y1 = _mm256_fnmadd_pd(va, _mm256_loadu_pd(x + j + 4), y1);
+        _mm256_storeu_pd(y + j, y0);
+        _mm256_storeu_pd(y + j + 4, y1);
+    }
+    for (; j + 4 <= len; j += 4) {
+        __m256d vy = _mm256_loadu_pd(y + j);
+        _mm256_storeu_pd(y + j, _mm256_fnmadd_pd(va, _mm256_loadu_pd(x + j), vy));
+    }
+    for (; j < len; j++) {
+        y[j] -= a * x[j];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void scale_avx2(double *x, double d, int len) {
+    __m256d vd = _mm256_set1_pd(d);
+    int j = 0;
+    for (; j + 4 <= len; j += 4) {
+        _mm256_storeu_pd(x + j, _mm256_div_pd(_mm256_loadu_pd(x + j), vd));
+    }
+    for (; j < len; j++) {
+        x[j] /= d;
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static int abs_argmax_avx2(const double *col, int stride, int start, int end, double *max_value) {
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256i offsets = _mm256_set_epi64x(3LL*stride, 2LL*stride, stride, 0);
+    __m256d vmax = _mm256_set1_pd(fabs(col[(size_t)start*stride]));
+    int i = start + 1;
+    for (; i + 4 <= end; i += 4) {
+        __m256d v = _mm256_i64gather_pd(col + (size_t)i*stride, offsets, 8);
+        vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(sign_mask, v));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, vmax);
+    double best_value = lanes[0];
+    for (int l = 1; l < 4; l++) {
+        if (lanes[l] > best_value) {
+            best_value = lanes[l];
+        }
+    }
+    for (; i < end; i++) {
+        double abs_value = fabs(col[(size_t)i*stride]);
+        if (abs_value > best_value) {
+            best_value = abs_value;
+        }
+    }
+
+    *max_value = best_value;
+    return first_index_of(col, stride, start, end, best_value);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512F (8 doubles por registrador, caudas tratadas com máscara)
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(double *y, const double *x, double a, int len) {
+    __m512d va = _mm512_set1_pd(a);
+    int j = 0;
+    for (; j + 16 <= len; j += 16) {
+        __m512d y0 = _mm512_loadu_pd(y + j);
+        __m512d y1 = _mm512_loadu_pd(y + j + 8);
+        y0 = _mm512_fnmadd_pd(va, _mm512_loadu_pd(x + j), y0);
+        y1 = _mm512_fnmadd_pd(va, _mm512_loadu_pd(x + j + 8), y1);
+        _mm512_storeu_pd(y + j, y0);
+        _mm512_storeu_pd(y + j + 8, y1);
+    }
+    for (; j + 8 <= len; j += 8) {
+        __m512d vy = _mm512_loadu_pd(y + j);
+        _mm512_storeu_pd(y + j, _mm512_fnmadd_pd(va, _mm512_loadu_pd(x + j), vy));
+    }
+    if (j < len) {
+        __mmask8 m = (__mmask8)((1u << (len - j)) - 1);
+        __m512d vy = _mm512_maskz_loadu_pd(m, y + j);
+        __m512d vx = _mm512_maskz_loadu_pd(m, x + j);
+        _mm512_mask_storeu_pd(y + j, m, _mm512_fnmadd_pd(va, vx, vy));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void scale_avx512(double *x, double d, int len) {
+    __m512d vd = _mm512_set1_pd(d);
+    int j = 0;
+    for (; j + 8 <= len; j += 8) {
+        _mm512_storeu_pd(x + j, _mm512_div_pd(_mm512_loadu_pd(x + j), vd));
+    }
+    if (j < len) {
+        __mmask8 m = (__mmask8)((1u << (len - j)) - 1);
+        __m512d vx = _mm512_maskz_loadu_pd(m, x + j);
+        _mm512_mask_storeu_pd(x + j, m, _mm512_div_pd(vx, vd));
+    }
+}
+
+__attribute__((target("avx512f")))
+static int abs_argmax_avx512(const double *col, int stride, int start, int end, double *max_value) {
+    const __m512i offsets = _mm512_set_epi64(7LL*stride, 6LL*stride, 5LL*stride, 4LL*stride,
+                                             3LL*stride, 2LL*stride, stride, 0);
+    __m512d vmax = _mm512_set1_pd(fabs(col[(size_t)start*stride]));
+    int i = start + 1;
+    for (; i + 8 <= end; i += 8) {
+        __m512d v = _mm512_i64gather_pd(offsets, col + (size_t)i*stride, 8);
+        vmax = _mm512_max_pd(vmax, _mm512_abs_pd(v));
+    }
+    double best_value = _mm512_reduce_max_pd(vmax);
+    for (; i < end; i++) {
+        double abs_value = fabs(col[(size_t)i*stride]);
+        if (abs_value > best_value) {
+            best_value = abs_value;
+        }
+    }
+
+    *max_value = best_value;
+    return first_index_of(col, stride, start, end, best_value);
+}
+
+#endif // SIMD_X86
+
+// ---------------------------------------------------------------------------
+// Seleção em tempo de execução
+// ---------------------------------------------------------------------------
+
+void (*simd_axpy)(double *y, const double *x, double a, int len) = axpy_scalar;
+void (*simd_scale)(double *x, double d, int len) = scale_scalar;
+int (*simd_abs_argmax)(const double *col, int stride, int start, int end, double *max_value) = abs_argmax_scalar;
+
+static isa_level_t selected_isa = ISA_SCALAR;
+
+static const char *isa_names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+// Maior nível suportado pela CPU (e pelo sistema operacional, via CPUID/XGETBV)
+static isa_level_t detect_isa(void) {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return ISA_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ISA_SSE2;
+    }
+#endif
+    return ISA_SCALAR;
+}
+
+void simd_init_quiet(char *warning, size_t size) {
+    isa_level_t level = detect_isa();
+    if (size > 0) {
+        warning[0] = '\0';
+    }
+
+    // Permite forçar um nível mais baixo (ou escalar) para comparação
+    const char *forced = getenv("IM_ISA");
+    if (forced != NULL && forced[0] != '\0') {
+        int found = 0;
+        for (int l = ISA_SCALAR; l <= ISA_AVX512; l++) {
+            if (strcmp(forced, isa_names[l]) == 0) {
+                found = 1;
+                if ((isa_level_t)l > level) {
+                    snprintf(warning, size, "IM_ISA=%s não é suportado por esta CPU, usando %s",
+                             forced, isa_names[level]);
+                } else {
+                    level = (isa_level_t)l;
+                }
+            }
+        }
+        if (!found) {
+            snprintf(warning, size, "IM_ISA=%s desconhecido (use scalar, sse2, avx2 ou avx512)", forced);
+        }
+    }
+
+    selected_isa = level;
+    switch (level) {
+#ifdef SIMD_X86
+        case ISA_AVX512:
+            simd_axpy = axpy_avx512;
+            simd_scale = scale_avx512;
+            simd_abs_argmax = abs_argmax_avx512;
+            break;
+        case ISA_AVX2:
+            simd_axpy = axpy_avx2;
+            simd_scale = scale_avx2;
+            simd_abs_argmax = abs_argmax_avx2;
+            break;
+        case ISA_SSE2:
+            simd_axpy = axpy_sse2;
+            simd_scale = scale_sse2;
+            simd_abs_argmax = abs_argmax_sse2;
+            break;
+#endif
+        default:
+            simd_axpy = axpy_scalar;
+            simd_scale = scale_scalar;
+            simd_abs_argmax = abs_argmax_scalar;
+            break;
+    }
+}
+
+void simd_init(void) {
+    char warning[256];
+    simd_init_quiet(warning, sizeof(warning));
+    if (warning[0] != '\0') {
+        fprintf(stderr, "Aviso: %s\n", warning);
+    }
+}
+
+isa_level_t simd_isa_level(void) {
+    return selected_isa;
+}
+
+const char *simd_isa_name(void) {
+    return isa_names[selected_isa];
+}
@@ -0,0 +1,42 @@
+/*
+ * simd_kernels.h - Kernels vetorizados (SSE2/AVX2/AVX-512) usados no laço
+ * interno do Gauss-Jordan, com seleção em tempo de execução via CPUID
+ */
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <stddef.h>
+
+// Níveis de conjunto de instruções suportados, do mais simples ao mais largo
+typedef enum {
+    ISA_SCALAR = 0,
+    ISA_SSE2,
+    ISA_AVX2,
+    ISA_AVX512
+} isa_level_t;
+
+// y[j] -= a * x[j], para j = 0..len-1 (AXPY da eliminação)
+extern void (*simd_axpy)(double *y, const double *x, double a, int len);
+
+// x[j] /= d, para j = 0..len-1 (normalização da linha do pivô)
+extern void (*simd_scale)(double *x, double d, int len);
+
+// Retorna o índice i em [start, end) com o maior fabs(col[i*stride]) (primeira
+// ocorrência, como no laço escalar) e grava esse valor em *max_value
+extern int (*simd_abs_argmax)(const double *col, int stride, int start, int end, double *max_value);
+
+// Detecta a CPU e escolhe os kernels. A variável de ambiente IM_ISA
+// (scalar, sse2, avx2 ou avx512) força um nível específico para benchmarks
+void simd_init(void);
+
+// simd_init sem imprimir: o aviso sobre IM_ISA (nível desconhecido ou não
+// suportado pela CPU) vai para warning, vazio se não houver. Usada pela
+// libinvmat, que não escreve no terminal
+void simd_init_quiet(char *warning, size_t size);
+
+// Nível selecionado por simd_init() e seu nome legível
+isa_level_t simd_isa_level(void);
+const char *simd_isa_name(void);
+
+#endif
@@ -0,0 +1,518 @@
+/*
+ * topology.c - Detecção da topologia via /sys (sem libnuma), fixação das
+ * threads com sched_setaffinity e consulta do nó NUMA das páginas com a
+ * chamada de sistema move_pages
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <omp.h>
+
+#include "topology.h"
+
+// Páginas consultadas por chamada de move_pages
+#define PAGE_QUERY_BATCH 512
+
+// Elementos de cada vetor do triad somando todas as threads (64 MB por vetor,
+// bem acima do cache de último nível) e mínimo por thread
+#define STREAM_TOTAL_ELEMS (8L << 20)
+#define STREAM_MIN_ELEMS (256L << 10)
+#define STREAM_REPS 3
+
+static void *checked_calloc(size_t count, size_t size) {
+    void *p = calloc(count > 0 ? count : 1, size);
+    if (p == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// Lê o conteúdo de um arquivo de /sys (uma linha); retorna 0 se não existir
+static int read_sys_file(const char *path, char *buffer, size_t size) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return 0;
+    }
+    int ok = (fgets(buffer, (int)size, f) != NULL);
+    fclose(f);
+    return ok;
+}
+
+static int read_sys_int(const char *path, int fallback) {
+    char buffer[64];
+    if (!read_sys_file(path, buffer, sizeof(buffer))) {
+        return fallback;
+    }
+    return atoi(buffer);
+}
+
+// Marca em set as CPUs de uma lista no formato de /sys (ex.: "0-3,8,10-11")
+static void parse_cpu_list(const char *text, char *set, int max) {
+    const char *p = text;
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long c = first; c <= last && c < max; c++) {
+            if (c >= 0) {
+                set[c] = 1;
+            }
+        }
+        if (*p == ',') {
+            p++;
+        }
+    }
+}
+
+// 1 se values[i] não aparece antes da posição i
+static int first_occurrence(const int *values, int i) {
+    for (int j = 0; j < i; j++) {
+        if (values[j] == values[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Chave de ordenação das CPUs para a fixação
+typedef struct {
+    long key;
+    int index;
+} order_entry_t;
+
+static int compare_order(const void *a, const void *b) {
+    const order_entry_t *x = (const order_entry_t *)a;
+    const order_entry_t *y = (const order_entry_t *)b;
+    if (x->key != y->key) {
+        return (x->key < y->key) ? -1 : 1;
+    }
+    return x->index - y->index;
+}
+
+void topology_detect(topology_t *topo) {
+    memset(topo, 0, sizeof(*topo));
+
+    // CPUs utilizáveis: online e na máscara de afinidade com que o processo
+    // começou (ex.: taskset, cgroups ou mpirun --bind-to)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long c = 0; c < count && c < CPU_SETSIZE; c++) {
+            CPU_SET(c, &allowed);
+        }
+    }
+
+    char *online = (char*)checked_calloc(CPU_SETSIZE, 1);
+    char text[4096];
+    if (read_sys_file("/sys/devices/system/cpu/online", text, sizeof(text))) {
+        parse_cpu_list(text, online, CPU_SETSIZE);
+    } else {
+        memset(online, 1, CPU_SETSIZE);
+    }
+
+    int count = 0;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (online[c] && CPU_ISSET(c, &allowed)) {
+            count++;
+            topo->max_cpu_id = c;
+        }
+    }
+    if (count == 0) {
+        // Sem informação: uma CPU qualquer, para que o resto funcione
+        online[0] = 1;
+        CPU_SET(0, &allowed);
+        count = 1;
+    }
+
+    topo->num_cpus = count;
+    topo->cpu_id = (int*)checked_calloc(count, sizeof(int));
+    topo->cpu_socket = (int*)checked_calloc(count, sizeof(int));
+    topo->cpu_core = (int*)checked_calloc(count, sizeof(int));
+    topo->cpu_smt = (int*)checked_calloc(count, sizeof(int));
+    topo->cpu_node = (int*)checked_calloc(count, sizeof(int));
+    topo->order = (int*)checked_calloc(count, sizeof(int));
+    topo->index_of_cpu = (int*)checked_calloc(topo->max_cpu_id + 1, sizeof(int));
+    for (int c = 0; c <= topo->max_cpu_id; c++) {
+        topo->index_of_cpu[c] = -1;
+    }
+
+    // Identificadores do sistema (package e core_id) de cada CPU
+    int *package = (int*)checked_calloc(count, sizeof(int));
+    int *core_id = (int*)checked_calloc(count, sizeof(int));
+    int i = 0;
+    for (int c = 0; c < CPU_SETSIZE && i < count; c++) {
+        if (!online[c] || !CPU_ISSET(c, &allowed)) {
+            continue;
+        }
+        char path[128];
+        topo->cpu_id[i] = c;
+        topo->index_of_cpu[c] = i;
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", c);
+        package[i] = read_sys_int(path, 0);
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/core_id", c);
+        core_id[i] = read_sys_int(path, c);
+        i++;
+    }
+
+    // Sockets numerados de 0 em diante, na ordem dos identificadores; CPUs
+    // com o mesmo (package, core_id) são irmãs SMT
+    for (int a = 0; a < count; a++) {
+        int socket = 0, first_in_core = -1;
+        for (int b = 0; b < count; b++) {
+            if (package[b] < package[a] && first_occurrence(package, b)) {
+                socket++;
+            }
+            if (first_in_core < 0 && package[b] == package[a] && core_id[b] == core_id[a]) {
+                first_in_core = b;
+            }
+        }
+        topo->cpu_socket[a] = socket;
+        topo->cpu_smt[a] = 0;
+        for (int b = 0; b < a; b++) {
+            if (package[b] == package[a] && core_id[b] == core_id[a]) {
+                topo->cpu_smt[a]++;
+            }
+        }
+        topo->cpu_core[a] = first_in_core;  // provisório: índice da primeira CPU do núcleo
+    }
+    for (int a = 0; a < count; a++) {
+        if (topo->cpu_socket[a] + 1 > topo->num_sockets) {
+            topo->num_sockets = topo->cpu_socket[a] + 1;
+        }
+    }
+
+    // Núcleos numerados densamente na ordem das CPUs
+    int *core_number = (int*)checked_calloc(count, sizeof(int));
+    for (int a = 0; a < count; a++) {
+        core_number[a] = -1;
+    }
+    for (int a = 0; a < count; a++) {
+        int first = topo->cpu_core[a];
+        if (core_number[first] < 0) {
+            core_number[first] = topo->num_cores++;
+        }
+    }
+    for (int a = 0; a < count; a++) {
+        topo->cpu_core[a] = core_number[topo->cpu_core[a]];
+    }
+
+    // Nós NUMA: cada nó online lista as suas CPUs
+    char *node_cpus = (char*)checked_calloc(CPU_SETSIZE, 1);
+    char *nodes = (char*)checked_calloc(CPU_SETSIZE, 1);
+    if (read_sys_file("/sys/devices/system/node/online", text, sizeof(text))) {
+        parse_cpu_list(text, nodes, CPU_SETSIZE);
+    } else {
+        nodes[0] = 1;
+    }
+    for (int node = 0; node < CPU_SETSIZE; node++) {
+        if (!nodes[node]) {
+            continue;
+        }
+        topo->num_nodes++;
+        char path[128];
+        sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+        memset(node_cpus, 0, CPU_SETSIZE);
+        if (read_sys_file(path, text, sizeof(text))) {
+            parse_cpu_list(text, node_cpus, CPU_SETSIZE);
+        }
+        for (int a = 0; a < count; a++) {
+            if (node_cpus[topo->cpu_id[a]]) {
+                topo->cpu_node[a] = node;
+            }
+        }
+    }
+
+    // Posição de cada núcleo dentro do seu socket, para a ordem de fixação
+    int *core_rank = (int*)checked_calloc(count, sizeof(int));
+    int max_smt = 0;
+    for (int a = 0; a < count; a++) {
+        int rank = 0;
+        for (int b = 0; b < count; b++) {
+            if (topo->cpu_smt[b] == 0 && topo->cpu_socket[b] == topo->cpu_socket[a] &&
+                topo->cpu_core[b] < topo->cpu_core[a]) {
+                rank++;
+            }
+        }
+        core_rank[a] = rank;
+        if (topo->cpu_smt[a] > max_smt) {
+            max_smt = topo->cpu_smt[a];
+        }
+    }
+
+    // Política de fixação: IM_PIN; sem ela, respeita a fixação do próprio
+    // OpenMP se o usuário a configurou
+    const char *forced = getenv("IM_PIN");
+    if (forced == NULL) {
+        topo->policy = (getenv("OMP_PROC_BIND") != NULL || getenv("OMP_PLACES") != NULL) ? PIN_NONE : PIN_SPREAD;
+    } else if (strcmp(forced, "spread") == 0) {
+        topo->policy = PIN_SPREAD;
+    } else if (strcmp(forced, "compact") == 0) {
+        topo->policy = PIN_COMPACT;
+    } else if (strcmp(forced, "none") == 0) {
+        topo->policy = PIN_NONE;
+    } else {
+        fprintf(stderr, "Aviso: IM_PIN=%s desconhecido (use spread, compact ou none), usando spread\n", forced);
+        topo->policy = PIN_SPREAD;
+    }
+
+    order_entry_t *entries = (order_entry_t*)checked_calloc(count, sizeof(order_entry_t));
+    long S = topo->num_sockets, C = topo->num_cores + 1, T = max_smt + 1;
+    for (int a = 0; a < count; a++) {
+        entries[a].index = a;
+        if (topo->policy == PIN_COMPACT) {
+            entries[a].key = ((long)topo->cpu_socket[a] * T + topo->cpu_smt[a]) * C + core_rank[a];
+        } else {
+            entries[a].key = ((long)topo->cpu_smt[a] * C + core_rank[a]) * S + topo->cpu_socket[a];
+        }
+    }
+    qsort(entries, count, sizeof(order_entry_t), compare_order);
+    for (int a = 0; a < count; a++) {
+        topo->order[a] = entries[a].index;
+    }
+
+    free(entries);
+    free(core_rank);
+    free(core_number);
+    free(node_cpus);
+    free(nodes);
+    free(package);
+    free(core_id);
+    free(online);
+}
+
+void topology_free(topology_t *topo) {
+    free(topo->cpu_id);
+    free(topo->cpu_socket);
+    free(topo->cpu_core);
+    free(topo->cpu_smt);
+    free(topo->cpu_node);
+    free(topo->order);
+    free(topo->index_of_cpu);
+    memset(topo, 0, sizeof(*topo));
+}
+
+const char *topology_policy_name(const topology_t *topo) {
+    switch (topo->policy) {
+        case PIN_SPREAD: return "spread";
+        case PIN_COMPACT: return "compact";
+        default: return "none";
+    }
+}
+
+void topology_print(const topology_t *topo) {
+    int smt = (topo->num_cores > 0) ? topo->num_cpus / topo->num_cores : 1;
+    printf("Topologia: %d socket%s, %d núcleo%s, %d CPU%s lógica%s (SMT %d), %d nó%s NUMA\n",
+           topo->num_sockets, topo->num_sockets > 1 ? "s" : "",
+           topo->num_cores, topo->num_cores > 1 ? "s" : "",
+           topo->num_cpus, topo->num_cpus > 1 ? "s" : "", topo->num_cpus > 1 ? "s" : "",
+           smt, topo->num_nodes, topo->num_nodes > 1 ? "s" : "");
+}
+
+int topology_pin_threads(const topology_t *topo, int num_threads) {
+    if (topo->policy == PIN_NONE || topo->num_cpus == 0) {
+        return 0;
+    }
+
+    int failed = 0;
+    #pragma omp parallel num_threads(num_threads) reduction(|:failed)
+    {
+        int t = omp_get_thread_num();
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(topo->cpu_id[topo->order[t % topo->num_cpus]], &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            failed = 1;
+        }
+    }
+
+    if (failed) {
+        fprintf(stderr, "Aviso: não foi possível fixar as threads nas CPUs\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int current_index(const topology_t *topo) {
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu > topo->max_cpu_id || topo->index_of_cpu[cpu] < 0) {
+        return -1;
+    }
+    return topo->index_of_cpu[cpu];
+}
+
+int topology_current_socket(const topology_t *topo) {
+    int i = current_index(topo);
+    return (i < 0) ? 0 : topo->cpu_socket[i];
+}
+
+int topology_current_node(const topology_t *topo) {
+    int i = current_index(topo);
+    return (i < 0) ? 0 : topo->cpu_node[i];
+}
+
+double topology_local_page_fraction(const topology_t *topo, const void *data, size_t row_bytes,
+                                    int rows, int num_threads) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    long local = 0, total = 0;
+    int failed = 0;
+
+    #pragma omp parallel num_threads(num_threads) reduction(+:local,total) reduction(|:failed)
+    {
+        // Bloco de linhas da thread no schedule(static)
+        int lo = rows, hi = -1;
+        #pragma omp for schedule(static) nowait
+        for (int i = 0; i < rows; i++) {
+            if (i < lo) {
+                lo = i;
+            }
+            hi = i;
+        }
+
+        if (hi >= lo) {
+            int node = topology_current_node(topo);
+
+            // Só as páginas inteiramente dentro do bloco (as das bordas são
+            // compartilhadas com as threads vizinhas)
+            uintptr_t begin = (uintptr_t)data + (uintptr_t)lo * row_bytes;
+            uintptr_t end = (uintptr_t)data + (uintptr_t)(hi + 1) * row_bytes;
+            begin = (begin + page - 1) & ~(page - 1);
+            end &= ~(page - 1);
+
+            void *pages[PAGE_QUERY_BATCH];
+            int status[PAGE_QUERY_BATCH];
+            for (uintptr_t p = begin; p < end && !failed; ) {
+                int count = 0;
+                while (count < PAGE_QUERY_BATCH && p < end) {
+                    pages[count++] = (void *)p;
+                    p += page;
+                }
+                // Sem vetor de destino, move_pages só informa o nó de cada página
+                if (syscall(SYS_move_pages, 0, (unsigned long)count, pages, NULL, status, 0) != 0) {
+                    failed = 1;
+                    break;
+                }
+                for (int j = 0; j < count; j++) {
+                    if (status[j] >= 0) {
+                        total++;
+                        local += (status[j] == node);
+                    }
+                }
+            }
+        }
+    }
+
+    if (failed || total == 0) {
+        return -1.0;
+    }
+    return (double)local / total;
+}
+
+void topology_rows_per_socket(const topology_t *topo, int rows, int num_threads, long *rows_per_socket) {
+    memset(rows_per_socket, 0, topo->num_sockets * sizeof(long));
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        long count = 0;
+        int socket = topology_current_socket(topo);
+        #pragma omp for schedule(static) nowait
+        for (int i = 0; i < rows; i++) {
+            count++;
+        }
+        #pragma omp atomic
+        rows_per_socket[socket] += count;
+    }
+}
+
+void topology_stream_bandwidth(const topology_t *topo, int num_threads, double *socket_gbs) {
+    long elems = STREAM_TOTAL_ELEMS / num_threads;
+    if (elems < STREAM_MIN_ELEMS) {
+        elems = STREAM_MIN_ELEMS;
+    }
+
+    int *thread_socket = (int*)checked_calloc(num_threads, sizeof(int));
+    double *thread_time = (double*)checked_calloc(num_threads, sizeof(double));
+    for (int s = 0; s < topo->num_sockets; s++) {
+        socket_gbs[s] = 0.0;
+    }
+    int failed = 0;
+
+    #pragma omp parallel num_threads(num_threads) reduction(|:failed)
+    {
+        int t = omp_get_thread_num();
+        thread_socket[t] = topology_current_socket(topo);
+
+        // Cada thread aloca e toca os próprios vetores: as páginas ficam no
+        // seu nó, como as linhas da matriz com a inicialização por primeiro toque
+        double *a = (double*)malloc(elems*sizeof(double));
+        double *b = (double*)malloc(elems*sizeof(double));
+        double *c = (double*)malloc(elems*sizeof(double));
+        int ok = (a != NULL && b != NULL && c != NULL);
+        if (ok) {
+            for (long i = 0; i < elems; i++) {
+                a[i] = 0.0;
+                b[i] = 1.0;
+                c[i] = 2.0;
+            }
+        } else {
+            failed = 1;
+        }
+
+        for (int rep = 0; rep < STREAM_REPS; rep++) {
+            #pragma omp barrier
+            double start = omp_get_wtime();
+            if (ok) {
+                for (long i = 0; i < elems; i++) {
+                    a[i] = b[i] + 3.0 * c[i];
+                }
+            }
+            thread_time[t] = omp_get_wtime() - start;
+            #pragma omp barrier
+
+            // Por socket: bytes das suas threads / tempo da mais lenta
+            #pragma omp master
+            {
+                for (int s = 0; s < topo->num_sockets; s++) {
+                    double bytes = 0.0, slowest = 0.0;
+                    for (int u = 0; u < num_threads; u++) {
+                        if (thread_socket[u] == s) {
+                            bytes += 3.0 * sizeof(double) * elems;
+                            if (thread_time[u] > slowest) {
+                                slowest = thread_time[u];
+                            }
+                        }
+                    }
+                    if (slowest > 0.0 && bytes / (slowest * 1e9) > socket_gbs[s]) {
+                        socket_gbs[s] = bytes / (slowest * 1e9);
+                    }
+                }
+            }
+        }
+
+        free(a);
+        free(b);
+        free(c);
+    }
+
+    if (failed) {
+        fprintf(stderr, "Aviso: memória insuficiente para medir a banda de memória\n");
+    }
+    free(thread_socket);
+    free(thread_time);
+}
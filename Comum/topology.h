@@ -0,0 +1,75 @@
+/*
+ * topology.h - Topologia da máquina (sockets, núcleos, irmãos SMT e nós NUMA)
+ * lida de /sys, fixação das threads OpenMP em CPUs e medidas de localidade e
+ * de banda de memória por socket
+ */
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+
+// Política de fixação das threads (variável de ambiente IM_PIN)
+typedef enum {
+    PIN_NONE = 0,   // sem fixação (também quando OMP_PROC_BIND/OMP_PLACES estão definidas)
+    PIN_SPREAD,     // alterna entre os sockets; irmãos SMT só depois de todos os núcleos
+    PIN_COMPACT     // preenche um socket antes do próximo; irmãos SMT ao fim de cada socket
+} pin_policy_t;
+
+// CPUs utilizáveis pelo processo (online e na máscara de afinidade inicial)
+typedef struct {
+    int num_cpus;       // CPUs lógicas
+    int num_cores;      // núcleos físicos
+    int num_sockets;
+    int num_nodes;      // nós NUMA
+    int *cpu_id;        // número da CPU no sistema
+    int *cpu_socket;    // socket (0..num_sockets-1)
+    int *cpu_core;      // núcleo físico (0..num_cores-1)
+    int *cpu_smt;       // posição entre os irmãos SMT do núcleo (0 = primeiro)
+    int *cpu_node;      // nó NUMA
+    int *order;         // índices das CPUs na ordem de fixação
+    int max_cpu_id;
+    int *index_of_cpu;  // cpu_id -> índice, -1 se a CPU não é utilizável
+    pin_policy_t policy;
+} topology_t;
+
+// Lê a topologia de /sys/devices/system (cpu e node). Sem /sys, cada CPU
+// vira um núcleo de um único socket e nó. A política vem de IM_PIN (spread,
+// compact ou none; padrão spread)
+void topology_detect(topology_t *topo);
+void topology_free(topology_t *topo);
+
+// Resumo de uma linha (ex.: "2 sockets, 16 núcleos, 32 CPUs lógicas (SMT 2), 2 nós NUMA")
+void topology_print(const topology_t *topo);
+
+// Nome da política de fixação
+const char *topology_policy_name(const topology_t *topo);
+
+// Fixa a thread t de uma região com num_threads threads na CPU order[t mod
+// num_cpus]. As regiões paralelas seguintes com o mesmo número de threads
+// reaproveitam as mesmas threads do pool do OpenMP, na mesma ordem, então
+// basta chamar uma vez no início. Retorna 1 se as threads foram fixadas
+int topology_pin_threads(const topology_t *topo, int num_threads);
+
+// Socket e nó da CPU em que a thread chamadora está rodando
+int topology_current_socket(const topology_t *topo);
+int topology_current_node(const topology_t *topo);
+
+// Distribui as linhas 0..rows-1 de uma matriz com row_bytes bytes por linha
+// entre num_threads threads com schedule(static), o mesmo dos laços de
+// inicialização e eliminação, e retorna a fração das páginas de cada bloco
+// que está no nó NUMA da thread dona (consulta via move_pages). Retorna -1
+// se o kernel não informar o nó das páginas
+double topology_local_page_fraction(const topology_t *topo, const void *data, size_t row_bytes,
+                                    int rows, int num_threads);
+
+// Quantas das linhas 0..rows-1, distribuídas com schedule(static), ficam com
+// threads de cada socket (rows_per_socket tem num_sockets posições)
+void topology_rows_per_socket(const topology_t *topo, int rows, int num_threads, long *rows_per_socket);
+
+// Banda de memória sustentada por socket (GB/s), medida com o triad do STREAM
+// (a[i] = b[i] + s*c[i]) rodando em todas as threads ao mesmo tempo, cada uma
+// com os seus vetores inicializados por ela mesma (páginas locais)
+void topology_stream_bandwidth(const topology_t *topo, int num_threads, double *socket_gbs);
+
+#endif
@@ -0,0 +1,245 @@
+/*
+ * woodbury.c - Fórmulas de Sherman-Morrison e Woodbury sobre uma inversa
+ * existente. Os produtos com Ainv (n x n) são os únicos passos O(n^2 k) e
+ * são paralelizados com OpenMP; a matriz de capacitância k x k é invertida
+ * por Gauss-Jordan com pivotamento parcial
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "simd_kernels.h"
+#include "woodbury.h"
+
+// Colunas de Ainv tratadas por vez no produto Vt*Ainv (k linhas de Q em cache)
+#define WOODBURY_COL_BLOCK 512
+
+static double *alloc_or_die(size_t elems) {
+    double *p = (double*)malloc(elems*sizeof(double));
+    if (p == NULL) {
+        fprintf(stderr, "Erro: Falha na alocação de memória\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// P = Ainv*U (n x k)
+static void multiply_ainv_u(const double *Ainv, const double *U, double *P, int n, int k) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        double *p = P + (size_t)i*k;
+        const double *row = Ainv + (size_t)i*n;
+        memset(p, 0, k*sizeof(double));
+        // k é pequeno: o laço interno curto fica melhor sem chamada ao kernel
+        for (int j = 0; j < n; j++) {
+            double a = row[j];
+            const double *u = U + (size_t)j*k;
+            for (int t = 0; t < k; t++) {
+                p[t] += a * u[t];
+            }
+        }
+    }
+}
+
+// Q = Vt*Ainv (k x n), por blocos de colunas: cada linha de Ainv é lida uma
+// vez e usada pelas k linhas de Q
+static void multiply_vt_ainv(const double *Vt, const double *Ainv, double *Q, int n, int k) {
+    #pragma omp parallel for schedule(static)
+    for (int j0 = 0; j0 < n; j0 += WOODBURY_COL_BLOCK) {
+        int jb = (n - j0 < WOODBURY_COL_BLOCK) ? n - j0 : WOODBURY_COL_BLOCK;
+        for (int t = 0; t < k; t++) {
+            memset(Q + (size_t)t*n + j0, 0, jb*sizeof(double));
+        }
+        for (int j = 0; j < n; j++) {
+            for (int t = 0; t < k; t++) {
+                double v = Vt[(size_t)t*n + j];
+                if (v != 0.0) {
+                    simd_axpy(Q + (size_t)t*n + j0, Ainv + (size_t)j*n + j0, -v, jb);
+                }
+            }
+        }
+    }
+}
+
+// Norma 1 (maior soma de |.| numa coluna) de uma matriz k x k
+static double norm_1(const double *M, int k) {
+    double norm = 0.0;
+    for (int j = 0; j < k; j++) {
+        double sum = 0.0;
+        for (int i = 0; i < k; i++) {
+            sum += fabs(M[i*k + j]);
+        }
+        if (sum > norm) {
+            norm = sum;
+        }
+    }
+    return norm;
+}
+
+// Inverte C (k x k) em Cinv por Gauss-Jordan com pivotamento parcial.
+// Retorna 0 se C for singular
+static int invert_small(const double *C, double *Cinv, int k) {
+    double *T = alloc_or_die((size_t)k*k);
+    memcpy(T, C, (size_t)k*k*sizeof(double));
+    for (int i = 0; i < k; i++) {
+        for (int j = 0; j < k; j++) {
+            Cinv[i*k + j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+
+    for (int c = 0; c < k; c++) {
+        int pivot_row = c;
+        for (int i = c + 1; i < k; i++) {
+            if (fabs(T[i*k + c]) > fabs(T[pivot_row*k + c])) {
+                pivot_row = i;
+            }
+        }
+        if (T[pivot_row*k + c] == 0.0) {
+            free(T);
+            return 0;
+        }
+        if (pivot_row != c) {
+            for (int j = 0; j < k; j++) {
+                double temp = T[c*k + j];
+                T[c*k + j] = T[pivot_row*k + j];
+                T[pivot_row*k + j] = temp;
+                temp = Cinv[c*k + j];
+                Cinv[c*k + j] = Cinv[pivot_row*k + j];
+                Cinv[pivot_row*k + j] = temp;
+            }
+        }
+        double pivot = T[c*k + c];
+        for (int j = 0; j < k; j++) {
+            T[c*k + j] /= pivot;
+            Cinv[c*k + j] /= pivot;
+        }
+        for (int i = 0; i < k; i++) {
+            if (i != c) {
+                double factor = T[i*k + c];
+                for (int j = 0; j < k; j++) {
+                    T[i*k + j] -= factor * T[c*k + j];
+                    Cinv[i*k + j] -= factor * Cinv[c*k + j];
+                }
+            }
+        }
+    }
+
+    free(T);
+    return 1;
+}
+
+// Sherman-Morrison (k = 1): Ainv -= (Ainv*u)(v'*Ainv) / (1 + v'*Ainv*u)
+static int sherman_morrison(double *Ainv, const double *u, const double *v, int n, double *cond) {
+    double *p = alloc_or_die(n);
+    double *q = alloc_or_die(n);
+
+    multiply_ainv_u(Ainv, u, p, n, 1);
+    multiply_vt_ainv(v, Ainv, q, n, 1);
+
+    double vp = 0.0;
+    for (int i = 0; i < n; i++) {
+        vp += v[i] * p[i];
+    }
+    double c = 1.0 + vp;
+
+    // Cancelamento em 1 + v'*Ainv*u: quantas vezes o denominador é menor que
+    // as parcelas que o formam
+    double estimate = (c == 0.0) ? INFINITY : (1.0 + fabs(vp)) / fabs(c);
+    if (cond != NULL) {
+        *cond = estimate;
+    }
+    if (estimate > WOODBURY_MAX_COND) {
+        free(p);
+        free(q);
+        return WOODBURY_ILL_CONDITIONED;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        simd_axpy(Ainv + (size_t)i*n, q, p[i] / c, n);
+    }
+
+    free(p);
+    free(q);
+    return WOODBURY_OK;
+}
+
+int woodbury_update(double *Ainv, const double *U, const double *Vt, int n, int k, double *cond) {
+    if (k == 1) {
+        return sherman_morrison(Ainv, U, Vt, n, cond);
+    }
+
+    double *P = alloc_or_die((size_t)n*k);
+    double *Q = alloc_or_die((size_t)k*n);
+    double *C = alloc_or_die((size_t)k*k);
+    double *Cinv = alloc_or_die((size_t)k*k);
+
+    multiply_ainv_u(Ainv, U, P, n, k);
+    multiply_vt_ainv(Vt, Ainv, Q, n, k);
+
+    // C = I + Vt*P (k x k, O(n k^2))
+    memset(C, 0, (size_t)k*k*sizeof(double));
+    for (int t = 0; t < k; t++) {
+        for (int j = 0; j < n; j++) {
+            double v = Vt[(size_t)t*n + j];
+            if (v != 0.0) {
+                for (int s = 0; s < k; s++) {
+                    C[t*k + s] += v * P[(size_t)j*k + s];
+                }
+            }
+        }
+    }
+    double vp_norm = norm_1(C, k);
+    for (int t = 0; t < k; t++) {
+        C[t*k + t] += 1.0;
+    }
+
+    double estimate = INFINITY;
+    if (invert_small(C, Cinv, k)) {
+        estimate = norm_1(Cinv, k) * (1.0 + vp_norm);
+    }
+    if (cond != NULL) {
+        *cond = estimate;
+    }
+    if (estimate > WOODBURY_MAX_COND) {
+        free(P);
+        free(Q);
+        free(C);
+        free(Cinv);
+        return WOODBURY_ILL_CONDITIONED;
+    }
+
+    // W = inv(C)*Q (k x n)
+    double *W = alloc_or_die((size_t)k*n);
+    #pragma omp parallel for schedule(static)
+    for (int j0 = 0; j0 < n; j0 += WOODBURY_COL_BLOCK) {
+        int jb = (n - j0 < WOODBURY_COL_BLOCK) ? n - j0 : WOODBURY_COL_BLOCK;
+        for (int t = 0; t < k; t++) {
+            double *w = W + (size_t)t*n + j0;
+            memset(w, 0, jb*sizeof(double));
+            for (int s = 0; s < k; s++) {
+                simd_axpy(w, Q + (size_t)s*n + j0, -Cinv[t*k + s], jb);
+            }
+        }
+    }
+
+    // Ainv -= P*W
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        for (int t = 0; t < k; t++) {
+            double p = P[(size_t)i*k + t];
+            if (p != 0.0) {
+                simd_axpy(Ainv + (size_t)i*n, W + (size_t)t*n, p, n);
+            }
+        }
+    }
+
+    free(P);
+    free(Q);
+    free(C);
+    free(Cinv);
+    free(W);
+    return WOODBURY_OK;
+}
@@ -0,0 +1,28 @@
+/*
+ * woodbury.h - Atualização de posto baixo de uma inversa já calculada
+ * (Sherman-Morrison para k = 1, Woodbury para k > 1), em O(n^2 k)
+ */
+
+#ifndef WOODBURY_H
+#define WOODBURY_H
+
+// Acima deste condicionamento da matriz de capacitância a atualização perde
+// mais de ~8 dígitos; é melhor recalcular a inversa completa
+#define WOODBURY_MAX_COND 1e8
+
+// Resultado de woodbury_update
+#define WOODBURY_OK 0
+#define WOODBURY_ILL_CONDITIONED 1
+
+// Atualiza Ainv = inv(A) para inv(A + U*Vt), com U (n x k) e Vt (k x n)
+// orientadas a linhas:
+//   inv(A + U*Vt) = Ainv - Ainv*U * inv(I + Vt*Ainv*U) * Vt*Ainv
+// C = I + Vt*Ainv*U é a matriz de capacitância (k x k). Seu condicionamento
+// estimado, ||inv(C)||_1 * (1 + ||Vt*Ainv*U||_1), que para k = 1 mede o
+// cancelamento em 1 + v'*Ainv*u, é gravado em *cond (se não for NULL). Se
+// passar de WOODBURY_MAX_COND (ou C for singular), Ainv não é alterada e a
+// função retorna WOODBURY_ILL_CONDITIONED. Os laços O(n^2 k) usam as threads
+// OpenMP do chamador
+int woodbury_update(double *Ainv, const double *U, const double *Vt, int n, int k, double *cond);
+
+#endif